@@ -0,0 +1,178 @@
+#ifndef TREE_SITTER_TALON_BENCH_H_
+#define TREE_SITTER_TALON_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+  inline uint64_t now_ns()
+  {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  // A small deterministic PRNG (xorshift64*), so that generated inputs are
+  // identical across runs and machines.
+  struct Random
+  {
+    explicit Random(uint64_t seed) : state(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    uint64_t next()
+    {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return state * 0x2545f4914f6cdd1dull;
+    }
+
+    uint32_t below(uint32_t bound) { return uint32_t(next() % bound); }
+
+    uint64_t state;
+  };
+
+  // Returns the p-th percentile (0 to 100) of `values`, by nearest rank.
+  inline double percentile(std::vector<double> values, double p)
+  {
+    if (values.empty())
+      return 0;
+    size_t rank = size_t(p / 100 * values.size() + 0.5);
+    rank = std::min(values.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+  }
+
+  // Writes machine-readable results, one JSON document per benchmark run.
+  class Json
+  {
+  public:
+    explicit Json(FILE *out = stdout) : out(out) {}
+
+    Json &begin_object()
+    {
+      separate();
+      std::fputc('{', out);
+      first.push_back(true);
+      return *this;
+    }
+
+    Json &end_object()
+    {
+      first.pop_back();
+      std::fputc('}', out);
+      if (first.empty())
+        std::fputc('\n', out);
+      return *this;
+    }
+
+    Json &begin_array()
+    {
+      separate();
+      std::fputc('[', out);
+      first.push_back(true);
+      return *this;
+    }
+
+    Json &end_array()
+    {
+      first.pop_back();
+      std::fputc(']', out);
+      return *this;
+    }
+
+    Json &key(const std::string &name)
+    {
+      separate();
+      string(name);
+      std::fputc(':', out);
+      after_key = true;
+      return *this;
+    }
+
+    Json &value(double number)
+    {
+      separate();
+      std::fprintf(out, "%.6g", number);
+      return *this;
+    }
+
+    Json &value(uint64_t number)
+    {
+      separate();
+      std::fprintf(out, "%llu", (unsigned long long)number);
+      return *this;
+    }
+
+    Json &value(const std::string &text)
+    {
+      separate();
+      string(text);
+      return *this;
+    }
+
+    Json &value(const std::vector<double> &numbers)
+    {
+      begin_array();
+      for (double number : numbers)
+        value(number);
+      return end_array();
+    }
+
+    template <typename T>
+    Json &field(const std::string &name, const T &v)
+    {
+      key(name);
+      return value(v);
+    }
+
+  private:
+    void separate()
+    {
+      if (after_key)
+      {
+        after_key = false;
+        return;
+      }
+      if (!first.empty())
+      {
+        if (!first.back())
+          std::fputc(',', out);
+        first.back() = false;
+      }
+    }
+
+    void string(const std::string &text)
+    {
+      std::fputc('"', out);
+      for (char c : text)
+      {
+        if (c == '"' || c == '\\')
+          std::fputc('\\', out);
+        if ((unsigned char)c < 0x20)
+          std::fprintf(out, "\\u%04x", c);
+        else
+          std::fputc(c, out);
+      }
+      std::fputc('"', out);
+    }
+
+    FILE *out;
+    std::vector<bool> first;
+    bool after_key = false;
+  };
+
+  // Keeps the optimizer from discarding a computed value.
+  template <typename T>
+  inline void keep(const T &value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_BENCH_H_
@@ -0,0 +1,220 @@
+// Usage: build/native/bench/bytecode [iterations]
+//
+// Compares running command bodies through the bytecode VM against a naive
+// interpreter that walks the syntax tree on every execution.
+
+#include "bench/bench.h"
+#include "talon/bytecode.h"
+#include "talon/language.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+  using talon::Value;
+
+  const char *const bodies[] = {
+      "    key(ctrl-a)\n",
+      "    edit.select_all()\n    edit.copy()\n",
+      "    user.insert_formatted(\"hello {text} world\", \"SNAKE_CASE\")\n",
+      "    x = 5 + 3 * 2\n    user.move_cursor(x - 1, x % 4)\n    sleep(50ms)\n",
+      "    insert(\"(\" + \"{text}\" + \")\")\n    key(left)\n",
+      "    n = number_small or 1\n    user.repeat(n * 2)\n    key(escape)\n",
+      "    app.notify(\"line {number_small}: {text}\", 0x10, 1_000, 2.5e-1)\n",
+      "    mimic(\"go to line\")\n    user.line_start(-number_small)\n",
+  };
+
+  // Walks the syntax tree on every run, looking up actions by name.
+  struct TreeInterpreter
+  {
+    using Action = talon::VM::Action;
+
+    Value eval(TSNode node)
+    {
+      const talon::Symbols &s = talon::symbols();
+      TSSymbol symbol = ts_node_symbol(node);
+      if (symbol == s.integer)
+        return Value::of_int(std::strtoll(std::string(text(node)).c_str(), NULL, 0));
+      if (symbol == s.float_)
+        return Value::of_float(std::strtod(std::string(text(node)).c_str(), NULL));
+      if (symbol == s.variable)
+        return variables[std::string(text(ts_node_child_by_field_id(node, s.variable_name)))];
+      if (symbol == s.parenthesized_expression)
+        return eval(ts_node_named_child(node, 0));
+      if (symbol == s.unary_operator)
+      {
+        Value v = eval(ts_node_child_by_field_id(node, s.right));
+        return v.type == Value::INT ? Value::of_int(-v.i) : Value::of_float(-v.f);
+      }
+      if (symbol == s.binary_operator)
+      {
+        std::string_view op = text(ts_node_child_by_field_id(node, s.operator_field));
+        Value left = eval(ts_node_child_by_field_id(node, s.left));
+        if (op == "or")
+          return left.truthy() ? left : eval(ts_node_child_by_field_id(node, s.right));
+        Value right = eval(ts_node_child_by_field_id(node, s.right));
+        talon::Opcode opcode = op == "+" ? talon::OP_ADD : op == "-" ? talon::OP_SUB
+                                                       : op == "*"   ? talon::OP_MUL
+                                                       : op == "/"   ? talon::OP_DIV
+                                                                     : talon::OP_MOD;
+        Value result;
+        talon::apply_binary(opcode, left, right, result);
+        return result;
+      }
+      if (symbol == s.string)
+      {
+        std::string out;
+        uint32_t count = ts_node_named_child_count(node);
+        for (uint32_t i = 0; i < count; i++)
+        {
+          TSNode child = ts_node_named_child(node, i);
+          if (ts_node_symbol(child) == s.interpolation)
+            talon::append_value(out, eval(ts_node_named_child(child, 0)));
+          else
+            out += text(child);
+        }
+        return Value::of_string(std::move(out));
+      }
+      if (symbol == s.key_action || symbol == s.sleep_action)
+      {
+        Value argument = Value::of_string(std::string(text(ts_node_child_by_field_id(node, s.arguments))));
+        return actions[symbol == s.key_action ? "key" : "sleep"](&argument, 1);
+      }
+      if (symbol == s.action)
+      {
+        std::vector<Value> arguments;
+        TSNode list = ts_node_child_by_field_id(node, s.arguments);
+        uint32_t count = ts_node_named_child_count(list);
+        for (uint32_t i = 0; i < count; i++)
+          arguments.push_back(eval(ts_node_named_child(list, i)));
+        std::string name(text(ts_node_child_by_field_id(node, s.action_name)));
+        return actions[name](arguments.data(), arguments.size());
+      }
+      return Value();
+    }
+
+    void run(TSNode block)
+    {
+      const talon::Symbols &s = talon::symbols();
+      uint32_t count = ts_node_named_child_count(block);
+      for (uint32_t i = 0; i < count; i++)
+      {
+        TSNode statement = ts_node_named_child(block, i);
+        if (ts_node_symbol(statement) == s.assignment_statement)
+          variables[std::string(text(ts_node_child_by_field_id(statement, s.left)))] =
+              eval(ts_node_child_by_field_id(statement, s.right));
+        else if (ts_node_symbol(statement) == s.expression_statement)
+          eval(ts_node_child_by_field_id(statement, s.expression));
+      }
+    }
+
+    std::string_view text(TSNode node) { return talon::node_text(source, node); }
+
+    std::string_view source;
+    std::unordered_map<std::string, Action> actions;
+    std::unordered_map<std::string, Value> variables;
+  };
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 200000;
+  const talon::Symbols &s = talon::symbols();
+
+  std::string source;
+  for (size_t i = 0; i < sizeof(bodies) / sizeof(bodies[0]); i++)
+    source += "command " + std::to_string(i) + " <user.text> [<number_small>]:\n" + bodies[i];
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+  TSNode declarations = ts_node_named_child(ts_tree_root_node(tree), 0);
+
+  std::vector<TSNode> blocks;
+  for (uint32_t i = 0; i < ts_node_named_child_count(declarations); i++)
+  {
+    TSNode declaration = ts_node_named_child(declarations, i);
+    if (ts_node_symbol(declaration) == s.command_declaration)
+      blocks.push_back(ts_node_child_by_field_id(declaration, s.right));
+  }
+
+  size_t calls = 0;
+  auto action = [&calls](const Value *, uint32_t)
+  {
+    calls++;
+    return Value();
+  };
+
+  // Compile once, then bind every interned action to the same stub.
+  talon::ActionTable actions;
+  talon::Compiler compiler(actions);
+  std::vector<talon::Program> programs(blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    if (!compiler.compile(blocks[i], source, programs[i]))
+    {
+      std::fprintf(stderr, "Could not compile command %zu: %s\n", i, compiler.error().c_str());
+      return 1;
+    }
+  }
+  talon::VM vm;
+  for (uint32_t id = 0; id < actions.size(); id++)
+    vm.bind(id, action);
+
+  std::vector<std::vector<Value>> variables(programs.size());
+  for (size_t i = 0; i < programs.size(); i++)
+  {
+    variables[i].resize(programs[i].variables.size());
+    for (size_t v = 0; v < programs[i].variables.size(); v++)
+    {
+      if (programs[i].variables[v] == "text")
+        variables[i][v] = Value::of_string("some text");
+      else if (programs[i].variables[v] == "number_small")
+        variables[i][v] = Value::of_int(3);
+    }
+  }
+
+  uint64_t start = bench::now_ns();
+  for (size_t n = 0; n < iterations; n++)
+  {
+    size_t i = n % programs.size();
+    if (!vm.run(programs[i], variables[i].data()))
+    {
+      std::fprintf(stderr, "Could not run command %zu: %s\n", i, vm.error().c_str());
+      return 1;
+    }
+  }
+  uint64_t vm_ns = bench::now_ns() - start;
+  size_t vm_calls = calls;
+
+  TreeInterpreter interpreter;
+  interpreter.source = source;
+  for (uint32_t id = 0; id < actions.size(); id++)
+    interpreter.actions[actions.name(id)] = action;
+  interpreter.variables["text"] = Value::of_string("some text");
+  interpreter.variables["number_small"] = Value::of_int(3);
+
+  calls = 0;
+  start = bench::now_ns();
+  for (size_t n = 0; n < iterations; n++)
+    interpreter.run(blocks[n % blocks.size()]);
+  uint64_t tree_ns = bench::now_ns() - start;
+
+  if (calls != vm_calls)
+  {
+    std::fprintf(stderr, "Mismatch: VM made %zu calls, tree walker made %zu\n", vm_calls, calls);
+    return 1;
+  }
+
+  std::printf("Bytecode VM:  %.0f commands/s\n", iterations / (vm_ns / 1e9));
+  std::printf("Tree walking: %.0f commands/s\n", iterations / (tree_ns / 1e9));
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  return 0;
+}
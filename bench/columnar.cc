@@ -0,0 +1,158 @@
+// Usage: build/native/bench/columnar [repetitions] [export]
+//
+// Counts the calls of every action, by reparsing the sources, by walking
+// trees kept in memory, and by scanning a columnar export, and prints the
+// time of each as JSON. The scan reads the field and text columns only.
+// Without an export, one is written of every corpus test 200 times, and
+// then the sources and trees are those; with one, only the scan is timed.
+// The "samples" are the time in milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "talon/columnar.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <filesystem>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace
+{
+
+  // Adds the calls below `root` to `counts`.
+  void count_calls(TSNode root, std::string_view source, std::unordered_map<std::string_view, uint64_t> &counts)
+  {
+    TSFieldId action_name = talon::symbols().action_name;
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    for (bool done = false; !done;)
+    {
+      if (ts_tree_cursor_current_field_id(&cursor) == action_name)
+      {
+        TSNode node = ts_tree_cursor_current_node(&cursor);
+        uint32_t start = ts_node_start_byte(node);
+        counts[source.substr(start, ts_node_end_byte(node) - start)]++;
+      }
+      if (ts_tree_cursor_goto_first_child(&cursor))
+        continue;
+      while (!ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        if (!ts_tree_cursor_goto_parent(&cursor))
+        {
+          done = true;
+          break;
+        }
+      }
+    }
+    ts_tree_cursor_delete(&cursor);
+  }
+
+  // The calls of each text id of `file`.
+  std::vector<uint64_t> scan_calls(const talon::ColumnarFile &file)
+  {
+    std::vector<uint64_t> counts(file.text_count());
+    uint32_t action_name = file.find_field("action_name");
+    const uint16_t *fields = file.fields();
+    const uint32_t *texts = file.text_ids();
+    for (size_t n = 0, end = file.node_count(); n < end; n++)
+      if (fields[n] == action_name && texts[n] != talon::COLUMNAR_NONE)
+        counts[texts[n]]++;
+    return counts;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 10;
+  bool generated = argc <= 2;
+  std::string path = generated ? (std::filesystem::temp_directory_path() /
+                                  ("tree-sitter-talon-bench-" + std::to_string(getpid()))).string()
+                               : argv[2];
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  std::vector<std::string> sources;
+  std::vector<TSTree *> trees;
+  if (generated)
+  {
+    std::vector<test::Example> examples = test::load_corpus();
+    talon::ColumnarWriter writer;
+    for (int copy = 0; copy < 200; copy++)
+    {
+      for (size_t i = 0; i < examples.size(); i++)
+      {
+        sources.push_back(examples[i].source);
+        const std::string &source = sources.back();
+        trees.push_back(ts_parser_parse_string(parser, NULL, source.data(), source.size()));
+        writer.add_file(std::to_string(copy) + "/" + std::to_string(i), ts_tree_root_node(trees.back()), source);
+      }
+    }
+    if (!writer.write(path))
+    {
+      std::fprintf(stderr, "%s\n", writer.error().c_str());
+      return 1;
+    }
+  }
+
+  talon::ColumnarFile file;
+  if (!file.open(path))
+  {
+    std::fprintf(stderr, "%s\n", file.error().c_str());
+    return 1;
+  }
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("columnar"));
+  json.field("files", uint64_t(file.file_count()));
+  json.field("nodes", uint64_t(file.node_count()));
+  json.key("classes").begin_object();
+  for (const char *name : {"reparse", "tree_walk", "columnar_scan"})
+  {
+    std::string kind = name;
+    if (kind != "columnar_scan" && !generated)
+      continue;
+    std::vector<double> samples;
+    uint64_t calls = 0;
+    for (int r = 0; r < repetitions; r++)
+    {
+      uint64_t start = bench::now_ns();
+      calls = 0;
+      if (kind == "columnar_scan")
+      {
+        for (uint64_t count : scan_calls(file))
+          calls += count;
+      }
+      else
+      {
+        std::unordered_map<std::string_view, uint64_t> counts;
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+          TSTree *tree = trees[i];
+          if (kind == "reparse")
+            tree = ts_parser_parse_string(parser, NULL, sources[i].data(), sources[i].size());
+          count_calls(ts_tree_root_node(tree), sources[i], counts);
+          if (kind == "reparse")
+            ts_tree_delete(tree);
+        }
+        for (const auto &count : counts)
+          calls += count.second;
+      }
+      samples.push_back((bench::now_ns() - start) / 1e6);
+    }
+    double median = bench::percentile(samples, 50);
+    json.key(name).begin_object();
+    json.field("calls", calls);
+    json.field("mnodes_per_s", median > 0 ? file.node_count() / median / 1e3 : 0);
+    json.field("samples", samples);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+
+  for (TSTree *tree : trees)
+    ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  if (generated)
+    std::filesystem::remove(path);
+  return 0;
+}
@@ -0,0 +1,149 @@
+// Usage: build/native/bench/dispatch [binding_count]
+//
+// Generates a synthetic workspace of key, noise, parrot, face and gamepad
+// bindings, builds the dispatch tables and compares their lookups against a
+// linear scan over all bindings.
+
+#include "bench/bench.h"
+#include "talon/dispatch.h"
+#include "talon/language.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  const char *const modifiers[] = {"ctrl", "shift", "alt", "cmd"};
+  const char *const keys[] = {"a", "b", "c", "d", "e", "f", "g", "h", "k", "l", "m", "n", "p", "r", "s", "t",
+                              "up", "down", "left", "right", "enter", "tab", "space", "f1", "f2", "f3", "f4",
+                              "f5", "f6", "f7", "f8", "f9", "f10", "f11", "f12", "1", "2", "3", "4", "5"};
+  const char *const noises[] = {"pop", "hiss", "hiss:stop"};
+  const char *const parrots[] = {"tut", "palate_click", "shush", "cluck", "pop", "ee", "oh", "hmm"};
+  const char *const faces[] = {"smile:start", "smile:stop", "brow:start", "brow:stop", "blink"};
+  const char *const buttons[] = {"dpad_up", "dpad_down", "dpad_left", "dpad_right", "north", "south",
+                                 "east", "west", "l1", "r1", "l2:change", "r2:change", "select", "start"};
+
+  template <typename T, size_t N>
+  const char *pick(bench::Random &random, T (&items)[N])
+  {
+    return items[random.below(N)];
+  }
+
+  std::string chord(bench::Random &random)
+  {
+    std::string result;
+    for (const char *modifier : modifiers)
+    {
+      if (random.below(3) == 0)
+      {
+        result += modifier;
+        result += '-';
+      }
+    }
+    return result + pick(random, keys);
+  }
+
+  std::string binding(bench::Random &random)
+  {
+    switch (random.below(10))
+    {
+    case 0:
+      return std::string("noise(") + pick(random, noises) + ")";
+    case 1:
+      return std::string("parrot(") + pick(random, parrots) + ")";
+    case 2:
+      return std::string("face(") + pick(random, faces) + ")";
+    case 3:
+      return std::string("gamepad(") + pick(random, buttons) + ")";
+    default:
+      return "key(" + chord(random) + ")";
+    }
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t binding_count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 10000;
+  const size_t bindings_per_file = 20;
+
+  bench::Random random(51);
+  std::vector<std::string> sources;
+  for (size_t n = 0; n < binding_count; n += bindings_per_file)
+  {
+    std::string source = "app: app" + std::to_string(random.below(50)) + "\n";
+    if (random.below(2))
+      source += "tag: user.tag" + std::to_string(random.below(20)) + "\n";
+    source += "-\n";
+    for (size_t i = 0; i < bindings_per_file && n + i < binding_count; i++)
+      source += binding(random) + ": user.action_" + std::to_string(n + i) + "()\n";
+    sources.push_back(std::move(source));
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  talon::DispatchIndex index;
+  std::vector<talon::Binding> all;
+  uint64_t parse_start = bench::now_ns();
+  for (const std::string &source : sources)
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    uint32_t file = index.add_file(ts_tree_root_node(tree), source);
+    talon::extract_bindings(ts_tree_root_node(tree), source, file, all);
+    ts_tree_delete(tree);
+  }
+  uint64_t parsed = bench::now_ns();
+  index.build();
+  uint64_t built = bench::now_ns();
+
+  // Queries use other spellings of the same events, so they are normalized.
+  std::vector<std::pair<talon::EventKind, std::string>> queries;
+  for (size_t i = 0; i < 100000; i++)
+  {
+    const talon::Binding &b = all[random.below(all.size())];
+    std::string query = b.event;
+    if (b.kind == talon::KEY_EVENT && query.rfind("ctrl-", 0) == 0)
+      query = "Control-" + query.substr(5);
+    queries.emplace_back(b.kind, query);
+  }
+
+  size_t table_hits = 0;
+  uint64_t start = bench::now_ns();
+  for (const auto &[kind, query] : queries)
+  {
+    auto range = index.lookup(kind, query);
+    table_hits += range.second - range.first;
+  }
+  uint64_t table_ns = bench::now_ns() - start;
+
+  size_t scan_hits = 0;
+  start = bench::now_ns();
+  for (const auto &[kind, query] : queries)
+  {
+    std::string event = talon::normalize_event(kind, query);
+    for (const talon::Binding &b : all)
+      scan_hits += b.kind == kind && b.event == event;
+  }
+  uint64_t scan_ns = bench::now_ns() - start;
+
+  if (table_hits != scan_hits)
+  {
+    std::fprintf(stderr, "Mismatch: table found %zu bindings, scan found %zu\n", table_hits, scan_hits);
+    return 1;
+  }
+
+  size_t events = 0;
+  for (int kind = 0; kind < talon::EVENT_KIND_COUNT; kind++)
+    events += index.table(talon::EventKind(kind)).size();
+
+  std::printf("Parsed %zu bindings in %zu files in %.2fms\n", all.size(), sources.size(), (parsed - parse_start) / 1e6);
+  std::printf("Built tables for %zu distinct events in %.2fms\n", events, (built - parsed) / 1e6);
+  std::printf("Table lookup: %.1fns per query\n", double(table_ns) / queries.size());
+  std::printf("Linear scan:  %.1fns per query\n", double(scan_ns) / queries.size());
+
+  ts_parser_delete(parser);
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Usage: build/native/bench/escape [megabytes]
+//
+// Measures decode_escapes on escape-dense and escape-sparse string text,
+// against the byte-at-a-time decoder.
+
+#include "bench/bench.h"
+#include "talon/escape.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  std::string generate(size_t size, uint32_t escape_per_mille, uint64_t seed)
+  {
+    static const char *const escapes[] = {"\\n", "\\t", "\\\\", "\\\"", "\\x41", "\\u00e9", "\\U0001f600", "\\101", "\\\n"};
+    static const char text[] = "the quick brown fox jumps over the lazy dog ";
+    bench::Random random(seed);
+    std::string result;
+    while (result.size() < size)
+    {
+      if (random.below(1000) < escape_per_mille)
+        result += escapes[random.below(sizeof(escapes) / sizeof(escapes[0]))];
+      else
+        result += text[random.below(sizeof(text) - 1)];
+    }
+    return result;
+  }
+
+  template <typename Decode>
+  double throughput(const std::string &input, std::vector<char> &out, Decode decode)
+  {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < 5; r++)
+    {
+      uint64_t start = bench::now_ns();
+      bench::keep(decode(input.data(), input.size(), out.data()));
+      best = std::min(best, bench::now_ns() - start);
+    }
+    return input.size() / 1e6 / (best / 1e9);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t megabytes = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 64;
+  const uint32_t densities[] = {0, 10, 100, 300};
+
+  for (uint32_t density : densities)
+  {
+    std::string input = generate(megabytes << 20, density, 56 + density);
+    std::vector<char> out(input.size());
+    double simd = throughput(input, out, talon::decode_escapes);
+    double scalar = throughput(input, out, talon::decode_escapes_scalar);
+    std::printf("%3u escapes per 1000 bytes: %8.1f MB/s (scalar %8.1f MB/s)\n", density, simd, scalar);
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+// Usage: build/native/bench/header [repetitions] [path..]
+//
+// Compares reading the `match` list of every input with the header scanner in
+// talon/header.h against a full parse followed by read_matches, and checks
+// that both agree on inputs that parse without errors. The inputs are the
+// .talon files below the given paths, e.g., a directory written by
+// tools/generate, or the source sections of the corpus tests. The "samples"
+// are the time in milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "talon/context.h"
+#include "talon/header.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include "tools/files.h"
+#include <cstdlib>
+
+namespace
+{
+
+  std::vector<talon::Match> scan_matches(const std::string &source, std::vector<TalonMatch> &buffer)
+  {
+    TalonHeader header;
+    TalonHeaderStatus status;
+    while ((status = talon_scan_header(source.data(), source.size(), true, buffer.data(), buffer.size(), &header)),
+           header.match_count > buffer.size())
+      buffer.resize(header.match_count);
+    std::vector<talon::Match> matches;
+    if (status != TALON_HEADER_FOUND)
+      return matches;
+    for (uint32_t i = 0; i < header.match_count; i++)
+    {
+      const TalonMatch &m = buffer[i];
+      talon::Match match;
+      match.conjunctive = m.conjunctive;
+      match.negated = m.negated;
+      match.left = source.substr(m.left_start, m.left_end - m.left_start);
+      match.right = source.substr(m.right_start, m.right_end - m.right_start);
+      matches.push_back(std::move(match));
+    }
+    return matches;
+  }
+
+  bool same(const std::vector<talon::Match> &a, const std::vector<talon::Match> &b)
+  {
+    if (a.size() != b.size())
+      return false;
+    for (size_t i = 0; i < a.size(); i++)
+      if (a[i].conjunctive != b[i].conjunctive || a[i].negated != b[i].negated || a[i].left != b[i].left ||
+          a[i].right != b[i].right)
+        return false;
+    return true;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 10;
+  std::vector<std::string> paths;
+  for (int i = 2; i < argc; i++)
+    tools::find_files(argv[i], paths);
+  std::vector<std::string> sources;
+  for (const std::string &path : paths)
+    sources.push_back(tools::read_file(path));
+  if (argc <= 2)
+    for (test::Example &example : test::load_corpus())
+      sources.push_back(std::move(example.source));
+
+  uint64_t bytes = 0;
+  for (const std::string &source : sources)
+    bytes += source.size();
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  std::vector<TalonMatch> buffer(16);
+
+  // Check agreement first; recovered trees may contain partial headers.
+  uint64_t checked = 0, mismatches = 0;
+  for (const std::string &source : sources)
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    if (!ts_node_has_error(root))
+    {
+      checked++;
+      mismatches += !same(talon::read_matches(root, source), scan_matches(source, buffer));
+    }
+    ts_tree_delete(tree);
+  }
+
+  std::vector<double> parse_ms, scan_ms;
+  for (int r = 0; r < repetitions; r++)
+  {
+    uint64_t start = bench::now_ns();
+    for (const std::string &source : sources)
+    {
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      bench::keep(talon::read_matches(ts_tree_root_node(tree), source).size());
+      ts_tree_delete(tree);
+    }
+    parse_ms.push_back((bench::now_ns() - start) / 1e6);
+
+    start = bench::now_ns();
+    for (const std::string &source : sources)
+      bench::keep(scan_matches(source, buffer).size());
+    scan_ms.push_back((bench::now_ns() - start) / 1e6);
+  }
+  ts_parser_delete(parser);
+
+  double parse_median = bench::percentile(parse_ms, 50);
+  double scan_median = bench::percentile(scan_ms, 50);
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("header"));
+  json.field("inputs", uint64_t(sources.size()));
+  json.field("bytes", bytes);
+  json.field("checked", checked);
+  json.field("mismatches", mismatches);
+  json.field("speedup", parse_median / scan_median);
+  json.key("classes").begin_object();
+  json.key("full_parse").begin_object();
+  json.field("files_per_s", sources.size() / (parse_median / 1e3));
+  json.field("samples", parse_ms);
+  json.end_object();
+  json.key("header_scan").begin_object();
+  json.field("files_per_s", sources.size() / (scan_median / 1e3));
+  json.field("samples", scan_ms);
+  json.end_object();
+  json.end_object();
+  json.end_object();
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,253 @@
+// Usage: build/native/bench/incremental [repetitions] [file.talon...]
+//
+// Replays keystroke-sized edit scripts against large talon inputs. After each
+// keystroke it calls ts_tree_edit and reparses incrementally, and it reports
+// the latency distribution and the size of the changed ranges per script as
+// JSON. Without files, the input is built from the bodies of the corpus tests.
+// The "samples" are the total time in microseconds of each replay.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace
+{
+
+  struct Edit
+  {
+    uint32_t start;
+    uint32_t removed;
+    std::string inserted;
+  };
+
+  TSPoint point_at(const std::string &text, uint32_t byte)
+  {
+    TSPoint point = {0, 0};
+    for (uint32_t i = 0; i < byte; i++)
+    {
+      if (text[i] == '\n')
+      {
+        point.row++;
+        point.column = 0;
+      }
+      else
+      {
+        point.column++;
+      }
+    }
+    return point;
+  }
+
+  struct Sample
+  {
+    double latency_us;
+    uint64_t changed_bytes;
+  };
+
+  // Applies `edit` to `text` and `tree`, reparses, and returns the new tree.
+  TSTree *replay(TSParser *parser, std::string &text, TSTree *tree, const Edit &edit, Sample &sample)
+  {
+    TSInputEdit input_edit;
+    input_edit.start_byte = edit.start;
+    input_edit.old_end_byte = edit.start + edit.removed;
+    input_edit.new_end_byte = edit.start + edit.inserted.size();
+    input_edit.start_point = point_at(text, edit.start);
+    input_edit.old_end_point = point_at(text, edit.start + edit.removed);
+    text.replace(edit.start, edit.removed, edit.inserted);
+    input_edit.new_end_point = point_at(text, edit.start + edit.inserted.size());
+
+    uint64_t start = bench::now_ns();
+    ts_tree_edit(tree, &input_edit);
+    TSTree *new_tree = ts_parser_parse_string(parser, tree, text.data(), text.size());
+    sample.latency_us = (bench::now_ns() - start) / 1e3;
+
+    uint32_t count = 0;
+    TSRange *ranges = ts_tree_get_changed_ranges(tree, new_tree, &count);
+    sample.changed_bytes = 0;
+    for (uint32_t i = 0; i < count; i++)
+      sample.changed_bytes += ranges[i].end_byte - ranges[i].start_byte;
+    std::free(ranges);
+
+    ts_tree_delete(tree);
+    return new_tree;
+  }
+
+  // Returns the start of the first top-level line at or after `byte`.
+  uint32_t top_level_line(const std::string &text, uint32_t byte)
+  {
+    size_t line = text.find('\n', byte);
+    while (line != std::string::npos && line + 1 < text.size())
+    {
+      char next = text[line + 1];
+      if (next != ' ' && next != '\t' && next != '\n' && next != '#' && next != '\r')
+        return line + 1;
+      line = text.find('\n', line + 1);
+    }
+    return text.size();
+  }
+
+  // Returns the start of the first indented body line at or after `byte`.
+  uint32_t body_line(const std::string &text, uint32_t byte)
+  {
+    size_t line = text.find("\n    ", byte);
+    return line == std::string::npos ? text.size() : line + 1;
+  }
+
+  std::vector<Edit> typing(uint32_t at, const std::string &typed)
+  {
+    std::vector<Edit> edits;
+    for (size_t i = 0; i < typed.size(); i++)
+      edits.push_back(Edit{uint32_t(at + i), 0, typed.substr(i, 1)});
+    return edits;
+  }
+
+  struct Script
+  {
+    std::string name;
+    std::function<std::vector<Edit>(const std::string &)> edits;
+  };
+
+  const Script scripts[] = {
+      {"type_command",
+       [](const std::string &text)
+       {
+         uint32_t at = top_level_line(text, text.size() / 2);
+         return typing(at, "open the new file <user.text>: user.open_file(text)\n");
+       }},
+      {"indent_block",
+       [](const std::string &text)
+       {
+         // Press tab at the start of every line of a multi-line body.
+         std::vector<Edit> edits;
+         uint32_t at = body_line(text, text.size() / 3);
+         int shift = 0;
+         while (at < text.size() && text.compare(at, 4, "    ") == 0 && edits.size() < 8)
+         {
+           edits.push_back(Edit{uint32_t(at + shift), 0, "    "});
+           shift += 4;
+           at = text.find('\n', at) + 1;
+         }
+         return edits;
+       }},
+      {"insert_string",
+       [](const std::string &text)
+       {
+         uint32_t at = body_line(text, text.size() / 4);
+         return typing(at, "    insert(\"hello {text} world\\n\")\n");
+       }},
+      {"delete_header_line",
+       [](const std::string &text)
+       {
+         // Backspace over the second header line, one character at a time.
+         std::vector<Edit> edits;
+         uint32_t start = text.find('\n') + 1;
+         uint32_t end = text.find('\n', start) + 1;
+         for (uint32_t at = end; at > start; at--)
+           edits.push_back(Edit{at - 1, 1, ""});
+         return edits;
+       }},
+  };
+
+  std::string corpus_document()
+  {
+    // Keep the bodies of the corpus tests, below one shared header.
+    std::string text = "app: vscode\ntag: user.code_language\n-\n";
+    for (const test::Example &example : test::load_corpus())
+    {
+      std::string source = example.source;
+      size_t separator = source.find("\n-\n");
+      if (separator != std::string::npos)
+        source = source.substr(separator + 3);
+      else if (source.rfind("-\n", 0) == 0)
+        source = source.substr(2);
+      if (source.find("\n-") != std::string::npos)
+        continue;
+      text += source;
+      text += "\n";
+    }
+    return text;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+
+  std::vector<std::pair<std::string, std::string>> inputs;
+  for (int i = 2; i < argc; i++)
+  {
+    std::ifstream in(argv[i], std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    inputs.emplace_back(argv[i], buffer.str());
+  }
+  if (inputs.empty())
+    inputs.emplace_back("corpus", corpus_document());
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("incremental"));
+  json.field("repetitions", uint64_t(repetitions));
+  json.key("classes").begin_object();
+
+  for (const auto &[input_name, original] : inputs)
+  {
+    // Time a full parse, as the bound that incremental parsing should beat.
+    std::vector<double> full_us;
+    for (int r = 0; r < repetitions; r++)
+    {
+      uint64_t start = bench::now_ns();
+      ts_tree_delete(ts_parser_parse_string(parser, NULL, original.data(), original.size()));
+      full_us.push_back((bench::now_ns() - start) / 1e3);
+    }
+
+    for (const Script &script : scripts)
+    {
+      std::vector<double> latency_us;
+      std::vector<double> changed_bytes;
+      std::vector<double> totals_us;
+      for (int r = 0; r < repetitions; r++)
+      {
+        std::string text = original;
+        TSTree *tree = ts_parser_parse_string(parser, NULL, text.data(), text.size());
+        double total = 0;
+        for (const Edit &edit : script.edits(text))
+        {
+          Sample sample;
+          tree = replay(parser, text, tree, edit, sample);
+          latency_us.push_back(sample.latency_us);
+          changed_bytes.push_back(sample.changed_bytes);
+          total += sample.latency_us;
+        }
+        totals_us.push_back(total);
+        ts_tree_delete(tree);
+      }
+
+      json.key(input_name + "/" + script.name).begin_object();
+      json.field("bytes", uint64_t(original.size()));
+      json.field("edits", uint64_t(latency_us.size() / std::max(repetitions, 1)));
+      json.field("full_parse_us", bench::percentile(full_us, 50));
+      json.field("p50_us", bench::percentile(latency_us, 50));
+      json.field("p90_us", bench::percentile(latency_us, 90));
+      json.field("p99_us", bench::percentile(latency_us, 99));
+      json.field("max_us", bench::percentile(latency_us, 100));
+      json.field("changed_bytes_p50", bench::percentile(changed_bytes, 50));
+      json.field("changed_bytes_max", bench::percentile(changed_bytes, 100));
+      json.field("samples", totals_us);
+      json.end_object();
+    }
+  }
+
+  json.end_object();
+  json.end_object();
+  ts_parser_delete(parser);
+  return 0;
+}
@@ -0,0 +1,170 @@
+// Usage: build/native/bench/index [seconds] [readers]
+//
+// Measures the latency of index queries while a writer reindexes files
+// without pause, with the workspace index behind a mutex and with
+// talon::WorkspaceIndex snapshots. Behind the mutex, the writer holds the lock
+// while it rebuilds the lookup tables, as an index updated in place would. The
+// index holds every corpus test as a file. Every 64th query is timed, and the
+// "samples" are up to 1000 of those latencies in microseconds.
+
+#include "bench/bench.h"
+#include "talon/index.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+  // The index behind a mutex.
+  class LockedIndex
+  {
+  public:
+    void update(talon::FileIndex file)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::vector<std::shared_ptr<const talon::FileIndex>> files = snapshot->files();
+      auto changed = std::make_shared<const talon::FileIndex>(std::move(file));
+      bool found = false;
+      for (std::shared_ptr<const talon::FileIndex> &f : files)
+      {
+        if (f->path == changed->path)
+        {
+          f = changed;
+          found = true;
+        }
+      }
+      if (!found)
+      {
+        files.push_back(changed);
+        std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a->path < b->path; });
+      }
+      snapshot.reset(new talon::IndexSnapshot(snapshot->version() + 1, std::move(files)));
+    }
+
+    size_t query(const std::string &action)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      const std::vector<talon::IndexSnapshot::Entry> *entries = snapshot->find_action(action);
+      return entries ? entries->size() : 0;
+    }
+
+  private:
+    std::mutex mutex;
+    std::unique_ptr<talon::IndexSnapshot> snapshot{new talon::IndexSnapshot(0, {})};
+  };
+
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = argc > 1 ? std::atof(argv[1]) : 1;
+  int reader_count = argc > 2 ? std::max(1, std::atoi(argv[2])) : 4;
+
+  std::vector<talon::FileIndex> files;
+  std::vector<std::string> actions;
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  for (const test::Example &example : test::load_corpus())
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+    files.push_back(talon::index_file(example.file + "/" + example.name, ts_tree_root_node(tree), example.source));
+    for (const talon::FileIndex::Reference &action : files.back().actions)
+      actions.push_back(action.name);
+    ts_tree_delete(tree);
+  }
+  ts_parser_delete(parser);
+  if (actions.empty())
+    actions.push_back("edit.undo");
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("index"));
+  json.field("files", uint64_t(files.size()));
+  json.field("readers", uint64_t(reader_count));
+  json.key("classes").begin_object();
+  for (const char *name : {"mutex", "snapshot"})
+  {
+    bool locked = std::string(name) == "mutex";
+    LockedIndex locked_index;
+    talon::WorkspaceIndex index;
+    for (const talon::FileIndex &file : files)
+    {
+      if (locked)
+        locked_index.update(file);
+      else
+        index.update({file});
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> queries(0);
+    std::vector<std::vector<double>> latencies(reader_count);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < reader_count; r++)
+    {
+      readers.emplace_back([&, r]()
+      {
+        bench::Random random(r + 1);
+        uint64_t i = 0;
+        for (; !done; i++)
+        {
+          const std::string &action = actions[random.below(actions.size())];
+          uint64_t start = bench::now_ns();
+          size_t found;
+          if (locked)
+          {
+            found = locked_index.query(action);
+          }
+          else
+          {
+            talon::WorkspaceIndex::Reader snapshot = index.read();
+            const std::vector<talon::IndexSnapshot::Entry> *entries = snapshot->find_action(action);
+            found = entries ? entries->size() : 0;
+          }
+          bench::keep(found);
+          if (i % 64 == 0)
+            latencies[r].push_back((bench::now_ns() - start) / 1e3);
+        }
+        queries += i;
+      });
+    }
+
+    uint64_t writes = 0;
+    bench::Random random(0);
+    uint64_t start = bench::now_ns();
+    while (bench::now_ns() - start < seconds * 1e9)
+    {
+      const talon::FileIndex &file = files[random.below(files.size())];
+      if (locked)
+        locked_index.update(file);
+      else
+        index.update({file});
+      writes++;
+    }
+    done = true;
+    for (std::thread &reader : readers)
+      reader.join();
+    double elapsed_s = (bench::now_ns() - start) / 1e9;
+
+    std::vector<double> timed, samples;
+    for (const std::vector<double> &l : latencies)
+      timed.insert(timed.end(), l.begin(), l.end());
+    for (size_t i = 0; i < timed.size(); i += std::max<size_t>(timed.size() / 1000, 1))
+      samples.push_back(timed[i]);
+    json.key(name).begin_object();
+    json.field("queries_per_s", queries / elapsed_s);
+    json.field("writes_per_s", writes / elapsed_s);
+    json.field("p50_us", bench::percentile(timed, 50));
+    json.field("p99_us", bench::percentile(timed, 99));
+    json.field("p999_us", bench::percentile(timed, 99.9));
+    json.field("max_us", bench::percentile(timed, 100));
+    json.field("samples", samples);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  return 0;
+}
@@ -0,0 +1,135 @@
+// Usage: build/native/bench/lazy [repetitions] [bodies_percent] [path..]
+//
+// Builds an index that needs the rule of every command but the body of only
+// some, once with full parses and once with tree_sitter_talon_lazy() and
+// LazyBodies, and prints both times and the speedup as JSON. The inputs are
+// the .talon files below the given paths, or the knausj_talon corpus tests.
+// The "samples" are the time in milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "talon/lazy.h"
+#include "test/native/corpus.h"
+#include "tools/files.h"
+#include <cstdlib>
+
+namespace
+{
+
+  struct Index
+  {
+    uint64_t rules = 0;
+    uint64_t rule_bytes = 0;
+    uint64_t bodies = 0;
+    uint64_t statements = 0;
+  };
+
+  // Records every rule, and the body of every `stride`th declaration.
+  void build_index(TSParser *parser, const std::string &source, uint64_t stride, talon::LazyBodies *bodies, Index &out)
+  {
+    const talon::Symbols &s = talon::symbols();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    if (bodies)
+      bodies->reset(tree, source);
+    TSNode root = ts_tree_root_node(tree);
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+      {
+        TSNode declaration = ts_node_named_child(child, j);
+        if (ts_node_symbol(declaration) != s.command_declaration)
+          continue;
+        out.rules++;
+        out.rule_bytes += talon::node_text(source, ts_node_child_by_field_id(declaration, s.left)).size();
+        if (out.rules % stride != 0)
+          continue;
+        TSNode body = bodies ? bodies->body(declaration) : ts_node_child_by_field_id(declaration, s.right);
+        out.bodies++;
+        out.statements += ts_node_named_child_count(body);
+      }
+    }
+    ts_tree_delete(tree);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 10;
+  double bodies_percent = argc > 2 ? std::atof(argv[2]) : 5;
+  uint64_t stride = bodies_percent > 0 ? std::max<uint64_t>(1, uint64_t(100 / bodies_percent)) : UINT64_MAX;
+
+  std::vector<std::string> paths;
+  for (int i = 3; i < argc; i++)
+    tools::find_files(argv[i], paths);
+  std::vector<std::string> sources;
+  for (const std::string &path : paths)
+    sources.push_back(tools::read_file(path));
+  if (argc <= 3)
+    for (test::Example &example : test::load_corpus())
+      if (example.file.rfind("knausj_talon/", 0) == 0)
+        sources.push_back(std::move(example.source));
+  uint64_t bytes = 0;
+  for (const std::string &source : sources)
+    bytes += source.size();
+
+  TSParser *eager = ts_parser_new();
+  ts_parser_set_language(eager, tree_sitter_talon());
+  TSParser *lazy = ts_parser_new();
+  ts_parser_set_language(lazy, tree_sitter_talon_lazy());
+  talon::LazyBodies bodies;
+
+  Index eager_index, lazy_index;
+  std::vector<double> eager_ms, lazy_ms;
+  for (int r = -1; r < repetitions; r++)
+  {
+    eager_index = Index();
+    uint64_t start = bench::now_ns();
+    for (const std::string &source : sources)
+      build_index(eager, source, stride, NULL, eager_index);
+    double eager_elapsed = (bench::now_ns() - start) / 1e6;
+
+    lazy_index = Index();
+    start = bench::now_ns();
+    for (const std::string &source : sources)
+      build_index(lazy, source, stride, &bodies, lazy_index);
+    double lazy_elapsed = (bench::now_ns() - start) / 1e6;
+
+    // The first repetition warms up.
+    if (r < 0)
+      continue;
+    eager_ms.push_back(eager_elapsed);
+    lazy_ms.push_back(lazy_elapsed);
+  }
+  ts_parser_delete(lazy);
+  ts_parser_delete(eager);
+
+  bool same = eager_index.rules == lazy_index.rules && eager_index.rule_bytes == lazy_index.rule_bytes &&
+              eager_index.statements == lazy_index.statements;
+  double eager_median = bench::percentile(eager_ms, 50);
+  double lazy_median = bench::percentile(lazy_ms, 50);
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("lazy"));
+  json.field("inputs", uint64_t(sources.size()));
+  json.field("bytes", bytes);
+  json.field("rules", eager_index.rules);
+  json.field("bodies", eager_index.bodies);
+  json.field("same_index", std::string(same ? "yes" : "no"));
+  json.field("speedup", eager_median / lazy_median);
+  json.key("classes").begin_object();
+  json.key("eager").begin_object();
+  json.field("mb_per_s", bytes / 1e3 / eager_median);
+  json.field("samples", eager_ms);
+  json.end_object();
+  json.key("lazy").begin_object();
+  json.field("mb_per_s", bytes / 1e3 / lazy_median);
+  json.field("samples", lazy_ms);
+  json.end_object();
+  json.end_object();
+  json.end_object();
+  return same ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Usage: build/native/bench/memory [corpus_path]
+//
+// Parses every corpus test under a counting allocator and reports, per kind
+// of input, the bytes allocated while parsing, the peak, and the bytes held by
+// the finished tree relative to the source, as JSON. The "samples" are the
+// total tree bytes of each class.
+//
+// Only allocations made by the tree-sitter runtime are counted; the external
+// scanner's few bytes of state are allocated with `new`.
+
+#include "bench/bench.h"
+#include "bench/tree.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace
+{
+
+  // Every block is prefixed with its size, so that free and realloc can keep
+  // the counters exact.
+  const size_t header = 16;
+
+  uint64_t current_bytes = 0;
+  uint64_t peak_bytes = 0;
+  uint64_t allocated_bytes = 0;
+
+  void count(size_t size)
+  {
+    current_bytes += size;
+    allocated_bytes += size;
+    if (current_bytes > peak_bytes)
+      peak_bytes = current_bytes;
+  }
+
+  void *counting_malloc(size_t size)
+  {
+    char *block = static_cast<char *>(std::malloc(size + header));
+    if (!block)
+      return NULL;
+    std::memcpy(block, &size, sizeof(size));
+    count(size);
+    return block + header;
+  }
+
+  void *counting_calloc(size_t n, size_t size)
+  {
+    void *pointer = counting_malloc(n * size);
+    if (pointer)
+      std::memset(pointer, 0, n * size);
+    return pointer;
+  }
+
+  void counting_free(void *pointer)
+  {
+    if (!pointer)
+      return;
+    char *block = static_cast<char *>(pointer) - header;
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    current_bytes -= size;
+    std::free(block);
+  }
+
+  void *counting_realloc(void *pointer, size_t size)
+  {
+    if (!pointer)
+      return counting_malloc(size);
+    char *block = static_cast<char *>(pointer) - header;
+    size_t old_size;
+    std::memcpy(&old_size, block, sizeof(old_size));
+    block = static_cast<char *>(std::realloc(block, size + header));
+    if (!block)
+      return NULL;
+    std::memcpy(block, &size, sizeof(size));
+    current_bytes -= old_size;
+    count(size);
+    return block + header;
+  }
+
+  struct Class
+  {
+    uint64_t inputs = 0;
+    uint64_t source_bytes = 0;
+    uint64_t nodes = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t peak_bytes = 0;
+    uint64_t tree_bytes = 0;
+  };
+
+  // Classifies an input by what its declarations are mostly made of.
+  std::string classify(TSNode root)
+  {
+    const talon::Symbols &s = talon::symbols();
+    uint32_t commands = 0, settings = 0, others = 0;
+    bool has_header = false;
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) == s.matches)
+        has_header = ts_node_named_child_count(child) > 0;
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+      {
+        TSSymbol symbol = ts_node_symbol(ts_node_named_child(child, j));
+        if (symbol == s.command_declaration)
+          commands++;
+        else if (symbol == s.settings_declaration)
+          settings++;
+        else
+          others++;
+      }
+    }
+    if (commands + settings + others == 0)
+      return has_header ? "header_only" : "empty";
+    if (settings > 0 && settings >= commands)
+      return "settings_heavy";
+    if (commands >= others)
+      return "command_heavy";
+    return "binding_heavy";
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  ts_set_allocator(counting_malloc, counting_calloc, counting_realloc, counting_free);
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  std::map<std::string, Class> classes;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    uint64_t before = current_bytes;
+    peak_bytes = current_bytes;
+    allocated_bytes = 0;
+
+    TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+    uint64_t peak = peak_bytes - before;
+    uint64_t allocated = allocated_bytes;
+
+    TSNode root = ts_tree_root_node(tree);
+    uint64_t nodes = bench::tree_stats(root).nodes;
+    std::string kind = classify(root);
+
+    uint64_t with_tree = current_bytes;
+    ts_tree_delete(tree);
+    uint64_t tree_bytes = with_tree - current_bytes;
+
+    for (const std::string &name : {kind, std::string("all")})
+    {
+      Class &c = classes[name];
+      c.inputs++;
+      c.source_bytes += example.source.size();
+      c.nodes += nodes;
+      c.allocated_bytes += allocated;
+      c.peak_bytes = std::max(c.peak_bytes, peak);
+      c.tree_bytes += tree_bytes;
+    }
+  }
+  ts_parser_delete(parser);
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("memory"));
+  json.key("classes").begin_object();
+  for (const auto &[name, c] : classes)
+  {
+    json.key(name).begin_object();
+    json.field("inputs", c.inputs);
+    json.field("source_bytes", c.source_bytes);
+    json.field("nodes", c.nodes);
+    json.field("allocated_bytes", c.allocated_bytes);
+    json.field("peak_bytes", c.peak_bytes);
+    json.field("tree_bytes", c.tree_bytes);
+    json.field("tree_to_source", double(c.tree_bytes) / std::max<uint64_t>(c.source_bytes, 1));
+    json.field("bytes_per_node", double(c.tree_bytes) / std::max<uint64_t>(c.nodes, 1));
+    json.field("samples", std::vector<double>{double(c.tree_bytes)});
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  return 0;
+}
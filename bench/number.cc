@@ -0,0 +1,106 @@
+// Usage: build/native/bench/number [literal_count]
+//
+// Measures the throughput of decode_number on a buffer of mixed literals,
+// against copying each literal and calling strtoll or strtod.
+
+#include "bench/bench.h"
+#include "talon/number.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  std::string digits(bench::Random &random, const char *alphabet, uint32_t base, bool separators)
+  {
+    std::string result;
+    uint32_t length = 1 + random.below(12);
+    for (uint32_t i = 0; i < length; i++)
+    {
+      if (separators && i > 0 && random.below(6) == 0)
+        result += '_';
+      result += alphabet[random.below(base)];
+    }
+    return result;
+  }
+
+  std::string literal(bench::Random &random)
+  {
+    bool separators = random.below(4) == 0;
+    switch (random.below(8))
+    {
+    case 0:
+      return "0x" + digits(random, "0123456789abcdef", 16, separators);
+    case 1:
+      return "0b" + digits(random, "01", 2, separators);
+    case 2:
+      return digits(random, "0123456789", 10, separators) + "." + digits(random, "0123456789", 10, separators);
+    case 3:
+      return digits(random, "0123456789", 10, false) + "e-" + digits(random, "0123456789", 2, false);
+    default:
+      return digits(random, "0123456789", 10, separators);
+    }
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+  const int repetitions = 5;
+
+  bench::Random random(55);
+  std::string buffer;
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  for (size_t i = 0; i < count; i++)
+  {
+    std::string text = literal(random);
+    ranges.emplace_back(buffer.size(), text.size());
+    buffer += text;
+    buffer += ' ';
+  }
+
+  uint64_t best_decoder = UINT64_MAX;
+  uint64_t sum = 0;
+  for (int r = 0; r < repetitions; r++)
+  {
+    uint64_t start = bench::now_ns();
+    for (const auto &[offset, length] : ranges)
+    {
+      talon::Number number = talon::decode_number(std::string_view(buffer).substr(offset, length));
+      sum += number.integer + uint64_t(number.real);
+    }
+    best_decoder = std::min(best_decoder, bench::now_ns() - start);
+  }
+
+  uint64_t best_copy = UINT64_MAX;
+  for (int r = 0; r < repetitions; r++)
+  {
+    uint64_t start = bench::now_ns();
+    for (const auto &[offset, length] : ranges)
+    {
+      std::string text;
+      for (char c : std::string_view(buffer).substr(offset, length))
+        if (c != '_')
+          text += c;
+      if (text.find_first_of(".eE") != std::string::npos && text[1] != 'x')
+        sum += uint64_t(std::strtod(text.c_str(), NULL));
+      else if (text.size() > 1 && text[1] == 'x')
+        sum += std::strtoull(text.c_str() + 2, NULL, 16);
+      else if (text.size() > 1 && text[1] == 'b')
+        sum += std::strtoull(text.c_str() + 2, NULL, 2);
+      else // Not base 0, which reads a leading zero as octal.
+        sum += std::strtoull(text.c_str(), NULL, 10);
+    }
+    best_copy = std::min(best_copy, bench::now_ns() - start);
+  }
+  bench::keep(sum);
+
+  double megabytes = (buffer.size() - count) / 1e6;
+  std::printf("decode_number:    %.1f MB/s, %.1fM literals/s\n", megabytes / (best_decoder / 1e9), count / (best_decoder / 1e3));
+  std::printf("copy and strto*:  %.1f MB/s, %.1fM literals/s\n", megabytes / (best_copy / 1e9), count / (best_copy / 1e3));
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Usage: build/native/bench/parallel [repetitions] [megabytes | file.talon]
+//
+// Parses one large input with talon::parse_parallel on 1, 2, 4, ... threads up
+// to the number of cores and prints the speedup curve as JSON. Without a file,
+// the input repeats the error-free corpus tests without a header until it has
+// the given size. The "samples" are the time in milliseconds of each
+// repetition.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "talon/parallel.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+
+  std::string build_input(size_t size)
+  {
+    const talon::Symbols &s = talon::symbols();
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_talon());
+    std::vector<std::string> sources;
+    for (const test::Example &example : test::load_corpus())
+    {
+      TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+      TSNode root = ts_tree_root_node(tree);
+      bool has_header = ts_node_named_child_count(root) > 0 && ts_node_symbol(ts_node_named_child(root, 0)) == s.matches;
+      if (!ts_node_has_error(root) && !has_header && !example.source.empty())
+        sources.push_back(example.source + "\n");
+      ts_tree_delete(tree);
+    }
+    ts_parser_delete(parser);
+
+    std::string input;
+    for (size_t i = 0; !sources.empty() && input.size() < size; i++)
+      input += sources[i % sources.size()];
+    return input;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+  std::string input;
+  if (argc > 2 && std::atof(argv[2]) == 0)
+  {
+    std::ifstream in(argv[2], std::ios::binary);
+    input.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  else
+  {
+    input = build_input(size_t((argc > 2 ? std::atof(argv[2]) : 16) * 1e6));
+  }
+
+  // The pieces must add up to the declarations of a single parse.
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  uint64_t start = bench::now_ns();
+  TSTree *tree = ts_parser_parse_string(parser, NULL, input.data(), input.size());
+  double single_ms = (bench::now_ns() - start) / 1e6;
+  uint64_t expected = 0;
+  TSNode root = ts_tree_root_node(tree);
+  for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+  {
+    TSNode child = ts_node_named_child(root, i);
+    for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+      expected += ts_node_symbol(ts_node_named_child(child, j)) != talon::symbols().comment;
+  }
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> thread_counts;
+  for (unsigned threads = 1; threads < cores; threads *= 2)
+    thread_counts.push_back(threads);
+  thread_counts.push_back(cores);
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("parallel"));
+  json.field("bytes", uint64_t(input.size()));
+  json.field("single_parse_ms", single_ms);
+  json.key("classes").begin_object();
+  double baseline_ms = 0;
+  for (unsigned threads : thread_counts)
+  {
+    std::vector<double> samples;
+    uint64_t declarations = 0, pieces = 0;
+    for (int r = 0; r < repetitions; r++)
+    {
+      start = bench::now_ns();
+      talon::SplitTree split = talon::parse_parallel(input, threads);
+      samples.push_back((bench::now_ns() - start) / 1e6);
+      pieces = split.pieces().size();
+      declarations = 0;
+      split.for_each_declaration([&](TSNode) { declarations++; });
+    }
+    double median = bench::percentile(samples, 50);
+    if (threads == 1)
+      baseline_ms = median;
+
+    json.key("threads_" + std::to_string(threads)).begin_object();
+    json.field("threads", uint64_t(threads));
+    json.field("pieces", pieces);
+    json.field("declarations", declarations);
+    json.field("expected_declarations", expected);
+    json.field("mb_per_s", input.size() / 1e3 / median);
+    json.field("speedup", baseline_ms / median);
+    json.field("samples", samples);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  return 0;
+}
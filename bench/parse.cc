@@ -0,0 +1,111 @@
+// Usage: build/native/bench/parse [repetitions] [corpus_path]
+//
+// Parses the source sections of the tree-sitter corpus in-process, with a
+// warmup pass, and prints throughput and per-input latency as JSON, both for
+// the whole corpus and per corpus file name (commands, contexts, ...). The
+// "samples" are the time in milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "bench/tree.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <map>
+
+namespace
+{
+
+  struct Class
+  {
+    uint64_t inputs = 0;
+    uint64_t bytes = 0;
+    uint64_t nodes = 0;
+    std::vector<double> repetition_ns;
+    std::vector<double> latency_us;
+  };
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 10;
+  std::string corpus_path = argc > 2 ? argv[2] : "test/corpus";
+  const int warmup = 2;
+
+  std::vector<test::Example> examples = test::load_corpus(corpus_path);
+  if (examples.empty())
+  {
+    std::fprintf(stderr, "No corpus tests found in %s\n", corpus_path.c_str());
+    return 1;
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  std::map<std::string, Class> classes;
+  for (const test::Example &example : examples)
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+    uint64_t nodes = bench::tree_stats(ts_tree_root_node(tree)).nodes;
+    ts_tree_delete(tree);
+    for (const std::string &name : {example.group, std::string("all")})
+    {
+      Class &c = classes[name];
+      c.inputs++;
+      c.bytes += example.source.size();
+      c.nodes += nodes;
+    }
+  }
+
+  for (int r = -warmup; r < repetitions; r++)
+  {
+    std::map<std::string, uint64_t> totals;
+    for (const test::Example &example : examples)
+    {
+      uint64_t start = bench::now_ns();
+      TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+      uint64_t elapsed = bench::now_ns() - start;
+      ts_tree_delete(tree);
+
+      if (r < 0)
+        continue;
+      for (const std::string &name : {example.group, std::string("all")})
+      {
+        totals[name] += elapsed;
+        classes[name].latency_us.push_back(elapsed / 1e3);
+      }
+    }
+    for (const auto &[name, total] : totals)
+      classes[name].repetition_ns.push_back(total);
+  }
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("parse"));
+  json.field("repetitions", uint64_t(repetitions));
+  json.field("warmup", uint64_t(warmup));
+  json.key("classes").begin_object();
+  for (const auto &[name, c] : classes)
+  {
+    std::vector<double> repetition_ms;
+    for (double ns : c.repetition_ns)
+      repetition_ms.push_back(ns / 1e6);
+    double median_ns = bench::percentile(c.repetition_ns, 50);
+
+    json.key(name).begin_object();
+    json.field("inputs", c.inputs);
+    json.field("bytes", c.bytes);
+    json.field("nodes", c.nodes);
+    json.field("mb_per_s", c.bytes / 1e6 / (median_ns / 1e9));
+    json.field("nodes_per_s", c.nodes / (median_ns / 1e9));
+    json.field("p50_us", bench::percentile(c.latency_us, 50));
+    json.field("p99_us", bench::percentile(c.latency_us, 99));
+    json.field("samples", repetition_ms);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+
+  ts_parser_delete(parser);
+  return 0;
+}
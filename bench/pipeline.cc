@@ -0,0 +1,93 @@
+// Usage: build/native/bench/pipeline [repetitions] [path]
+//
+// Indexes a user directory with the serial path, with the pipeline reading
+// through io_uring and with the pipeline reading on a thread pool, and prints
+// the end-to-end time and the utilization of every stage as JSON. Without a
+// path, the directory holds every corpus test 20 times, one file each. Files
+// are in the page cache after the first repetition, so this measures the
+// overlap of the stages rather than the disk. The "samples" are the time in
+// milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "talon/pipeline.h"
+#include "test/native/corpus.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+  std::filesystem::path root;
+  bool generated = argc <= 2;
+  if (generated)
+  {
+    root = std::filesystem::temp_directory_path() / ("tree-sitter-talon-bench-" + std::to_string(getpid()));
+    std::vector<test::Example> examples = test::load_corpus();
+    for (int copy = 0; copy < 20; copy++)
+    {
+      std::filesystem::path directory = root / std::to_string(copy);
+      std::filesystem::create_directories(directory);
+      for (size_t i = 0; i < examples.size(); i++)
+        std::ofstream(directory / (std::to_string(i) + ".talon"), std::ios::binary) << examples[i].source;
+    }
+  }
+  else
+  {
+    root = argv[2];
+  }
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("pipeline"));
+  json.key("classes").begin_object();
+  double serial_ms = 0;
+  for (const char *name : {"serial", "pipeline_io_uring", "pipeline_threads"})
+  {
+    std::vector<double> samples;
+    talon::PipelineStats stats;
+    for (int r = 0; r < repetitions; r++)
+    {
+      talon::WorkspaceIndex index;
+      if (std::string(name) == "serial")
+      {
+        stats = talon::index_directory_serial(root.string(), index);
+      }
+      else
+      {
+        talon::PipelineOptions options;
+        options.use_io_uring = std::string(name) == "pipeline_io_uring";
+        stats = talon::index_directory(root.string(), index, options);
+      }
+      samples.push_back(stats.total_ns / 1e6);
+    }
+    double median = bench::percentile(samples, 50);
+    if (serial_ms == 0)
+      serial_ms = median;
+
+    json.key(name).begin_object();
+    json.field("files", stats.files);
+    json.field("bytes", stats.bytes);
+    json.field("io_uring", uint64_t(stats.io_uring));
+    json.field("speedup", serial_ms / median);
+    json.key("stages").begin_object();
+    for (const talon::StageStats &stage : stats.stages)
+    {
+      json.key(stage.name).begin_object();
+      json.field("threads", uint64_t(stage.threads));
+      json.field("busy_ms", stage.busy_ns / 1e6);
+      json.field("utilization", stats.utilization(stage));
+      json.end_object();
+    }
+    json.end_object();
+    json.field("samples", samples);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+
+  if (generated)
+    std::filesystem::remove_all(root);
+  return 0;
+}
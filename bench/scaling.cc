@@ -0,0 +1,167 @@
+// Usage: build/native/bench/scaling [max_slope] [repetitions]
+//
+// Generates pathological inputs of doubling size, parses each a few times,
+// fits log(median time) against log(bytes) by least squares and exits with 1
+// if the slope of any generator exceeds `max_slope`, that is if parse time
+// grows noticeably faster than the input. Timing depends on the machine, so
+// this is a benchmark rather than a test that CI runs.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  // Returns a distinct rule word for every n, using letters only.
+  std::string word(size_t n)
+  {
+    std::string result = "w";
+    do
+    {
+      result += char('a' + n % 26);
+      n /= 26;
+    } while (n > 0);
+    return result;
+  }
+
+  std::string nested_expressions(size_t size)
+  {
+    size_t depth = size / 2;
+    return "foo: x = " + std::string(depth, '(') + "1" + std::string(depth, ')') + "\n";
+  }
+
+  std::string nested_rules(size_t size)
+  {
+    size_t depth = size / 2;
+    return std::string(depth, '(') + "foo" + std::string(depth, ')') + ": skip()\n";
+  }
+
+  std::string alternatives(size_t size)
+  {
+    std::string source = word(0);
+    for (size_t i = 1; source.size() < size; i++)
+      source += " | " + word(i);
+    return source + ": skip()\n";
+  }
+
+  std::string long_line(size_t size)
+  {
+    std::string source = "foo: x = 1";
+    for (size_t i = 0; source.size() < size; i++)
+      source += i % 2 ? " + y" : " * 2";
+    return source + "\n";
+  }
+
+  std::string comment_run(size_t size)
+  {
+    std::string source = "tag: user.foo\n-\nfoo:\n";
+    for (size_t i = 0; source.size() < size; i++)
+      source += i % 3 ? "    # indented comment\n" : "# comment\n";
+    return source + "    skip()\n";
+  }
+
+  std::string unterminated_string(size_t size)
+  {
+    std::string source = "foo: \"";
+    for (size_t i = 0; source.size() < size; i++)
+      source += i % 8 ? "text " : "{x} ";
+    return source;
+  }
+
+  std::string indentation_churn(size_t size)
+  {
+    static const int indents[] = {4, 8, 2, 12, 4, 1, 16, 4, 6};
+    std::string source = "foo:\n";
+    for (size_t i = 0; source.size() < size; i++)
+      source += std::string(indents[i % 9], ' ') + "key(a)\n";
+    return source;
+  }
+
+  struct Generator
+  {
+    const char *name;
+    std::string (*generate)(size_t size);
+  };
+
+  const Generator generators[] = {
+      {"nested_expressions", nested_expressions},
+      {"nested_rules", nested_rules},
+      {"alternatives", alternatives},
+      {"long_line", long_line},
+      {"comment_run", comment_run},
+      {"unterminated_string", unterminated_string},
+      {"indentation_churn", indentation_churn},
+  };
+
+  // Returns the median of `repetitions` parses of `source`, in seconds.
+  double parse_time(TSParser *parser, const std::string &source, int repetitions)
+  {
+    std::vector<double> times;
+    for (int r = 0; r < repetitions; r++)
+    {
+      uint64_t start = bench::now_ns();
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      times.push_back((bench::now_ns() - start) / 1e9);
+      ts_tree_delete(tree);
+    }
+    return bench::percentile(times, 50);
+  }
+
+  // Returns the least-squares slope of log(y) against log(x).
+  double log_log_slope(const std::vector<double> &x, const std::vector<double> &y)
+  {
+    double n = x.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+      double lx = std::log(x[i]), ly = std::log(y[i]);
+      sx += lx;
+      sy += ly;
+      sxx += lx * lx;
+      sxy += lx * ly;
+    }
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  double max_slope = argc > 1 ? std::strtod(argv[1], NULL) : 1.25;
+  size_t min_size = 16 << 10;
+  size_t max_size = 512 << 10;
+  int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 7;
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  int failures = 0;
+  for (const Generator &generator : generators)
+  {
+    std::vector<double> bytes, seconds;
+    for (size_t size = min_size; size <= max_size; size *= 2)
+    {
+      std::string source = generator.generate(size);
+      // Warm up the parser's buffers on an input of the same shape.
+      parse_time(parser, source, 1);
+      bytes.push_back(source.size());
+      seconds.push_back(parse_time(parser, source, repetitions));
+    }
+    double slope = log_log_slope(bytes, seconds);
+    bool ok = slope <= max_slope;
+    if (!ok)
+      failures++;
+    std::printf("%-20s slope %.2f, %.1f MB/s at %zu KB%s\n", generator.name, slope,
+                bytes.back() / seconds.back() / 1e6, size_t(bytes.back()) >> 10, ok ? "" : "  FAIL");
+  }
+
+  ts_parser_delete(parser);
+  if (failures)
+    std::fprintf(stderr, "%d generators scale worse than O(n^%.2f)\n", failures, max_slope);
+  return failures ? 1 : 0;
+}
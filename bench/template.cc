@@ -0,0 +1,94 @@
+// Usage: build/native/bench/template [iterations]
+//
+// Compares formatting precompiled string templates against interpreting the
+// `string` syntax nodes, escapes and all, on every execution.
+
+#include "bench/bench.h"
+#include "talon/template.h"
+#include "test/native/interpret.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  using talon::Value;
+
+  const char *const strings[] = {
+      "\"hello world\"",
+      "\"Hello {name}!\\n\\tTotal: {count} items\"",
+      "\"{{not interpolated}} but {name} is\"",
+      "\"caf\\u00e9 \\x41\\x42\\x43 \\101 {name}\\r\\n\"",
+      "\"{count}/{total} ({ratio}) \\\"done\\\"\"",
+      "\"path\\\\to\\\\{name}\\\\file.txt\"",
+  };
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000000;
+
+  std::string source;
+  for (const char *string : strings)
+    source += std::string("test:\n    insert(") + string + ")\n";
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+
+  std::vector<TSNode> nodes = test::string_nodes(ts_tree_root_node(tree));
+
+  test::Scope scope = {
+      {"name", Value::of_string("world")},
+      {"count", Value::of_int(42)},
+      {"total", Value::of_int(100)},
+      {"ratio", Value::of_float(0.42)},
+  };
+
+  talon::TemplateSet templates;
+  std::vector<std::vector<Value>> slot_values;
+  for (TSNode node : nodes)
+  {
+    std::vector<TSNode> slots;
+    templates.compile(node, source, slots);
+    slot_values.push_back(test::slot_values(slots, source, scope));
+  }
+
+  std::string out;
+  size_t bytes = 0;
+  uint64_t start = bench::now_ns();
+  for (size_t n = 0; n < iterations; n++)
+  {
+    size_t i = n % nodes.size();
+    out.clear();
+    templates.format(i, slot_values[i].data(), out);
+    bytes += out.size();
+  }
+  uint64_t template_ns = bench::now_ns() - start;
+
+  size_t interpreted_bytes = 0;
+  start = bench::now_ns();
+  for (size_t n = 0; n < iterations; n++)
+  {
+    out.clear();
+    test::interpret(nodes[n % nodes.size()], source, scope, out);
+    interpreted_bytes += out.size();
+  }
+  uint64_t interpret_ns = bench::now_ns() - start;
+
+  if (bytes != interpreted_bytes)
+  {
+    std::fprintf(stderr, "Mismatch: templates produced %zu bytes, interpreter %zu\n", bytes, interpreted_bytes);
+    return 1;
+  }
+
+  std::printf("Templates:      %.1fns per string\n", double(template_ns) / iterations);
+  std::printf("Syntax nodes:   %.1fns per string\n", double(interpret_ns) / iterations);
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  return 0;
+}
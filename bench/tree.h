@@ -0,0 +1,44 @@
+#ifndef TREE_SITTER_TALON_BENCH_TREE_H_
+#define TREE_SITTER_TALON_BENCH_TREE_H_
+
+#include <tree_sitter/api.h>
+#include <cstdint>
+
+namespace bench
+{
+
+  struct TreeStats
+  {
+    uint64_t nodes = 0;
+    uint64_t errors = 0;
+  };
+
+  // Counts every node below `root`, including anonymous ones, and the ERROR
+  // and MISSING nodes among them.
+  inline TreeStats tree_stats(TSNode root)
+  {
+    TreeStats stats;
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    for (;;)
+    {
+      TSNode node = ts_tree_cursor_current_node(&cursor);
+      stats.nodes++;
+      // ERROR nodes have the symbol ts_builtin_sym_error, i.e., (TSSymbol)-1.
+      if (ts_node_is_missing(node) || ts_node_symbol(node) == UINT16_MAX)
+        stats.errors++;
+      if (ts_tree_cursor_goto_first_child(&cursor))
+        continue;
+      while (!ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        if (!ts_tree_cursor_goto_parent(&cursor))
+        {
+          ts_tree_cursor_delete(&cursor);
+          return stats;
+        }
+      }
+    }
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_BENCH_TREE_H_
@@ -0,0 +1,151 @@
+// Usage: build/native/bench/workspace [repetitions] [threads] [path..]
+//
+// Parses a whole workspace with a static split of the files over the threads
+// and with talon::parse_workspace, and prints the makespan and core
+// utilization of both as JSON. The static split gives every thread an equal
+// count of consecutive files, as a plain parallel loop would. Without paths,
+// the workspace has the heavy tail of real user directories: thousands of
+// small files from the corpus tests and a few large generated ones, up to 8
+// MB. The "samples" are the makespan in milliseconds of each repetition.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "talon/parallel.h"
+#include "test/native/corpus.h"
+#include "tools/files.h"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+
+  std::vector<std::string> build_workspace()
+  {
+    std::vector<std::string> files;
+    std::vector<test::Example> examples = test::load_corpus();
+    for (int copy = 0; copy < 20; copy++)
+      for (const test::Example &example : examples)
+        files.push_back(example.source);
+
+    // Concatenated command files without their headers, as generated lists are.
+    std::string commands;
+    for (const test::Example &example : examples)
+      if (example.group == "commands" && example.source.find("\n-\n") == std::string::npos)
+        commands += example.source + "\n";
+    size_t sizes[] = {8 << 20, 2 << 20, 1 << 20, 512 << 10};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && !commands.empty(); i++)
+    {
+      std::string file;
+      while (file.size() < sizes[i])
+        file += commands;
+      // Placed mid-way, where a static split does not expect them.
+      files.insert(files.begin() + files.size() / 2 + i, file);
+    }
+    return files;
+  }
+
+  std::vector<std::string> read_workspace(int argc, char **argv)
+  {
+    std::vector<std::string> files;
+    for (int i = 3; i < argc; i++)
+    {
+      std::vector<std::string> paths;
+      tools::find_files(argv[i], paths);
+      std::sort(paths.begin(), paths.end());
+      for (const std::string &path : paths)
+        files.push_back(tools::read_file(path));
+    }
+    return files;
+  }
+
+  talon::Scheduler::Stats parse_static(const std::vector<std::string_view> &sources, unsigned threads)
+  {
+    talon::Scheduler::Stats stats;
+    stats.busy_ns.assign(threads, 0);
+    std::vector<TSTree *> trees(sources.size());
+    uint64_t start = bench::now_ns();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+    {
+      pool.emplace_back([&, t]()
+      {
+        uint64_t begin = bench::now_ns();
+        TSParser *parser = ts_parser_new();
+        ts_parser_set_language(parser, tree_sitter_talon());
+        for (size_t i = sources.size() * t / threads; i < sources.size() * (t + 1) / threads; i++)
+          trees[i] = ts_parser_parse_string(parser, NULL, sources[i].data(), sources[i].size());
+        ts_parser_delete(parser);
+        stats.busy_ns[t] = bench::now_ns() - begin;
+      });
+    }
+    for (std::thread &thread : pool)
+      thread.join();
+    stats.makespan_ns = bench::now_ns() - start;
+    stats.tasks = sources.size();
+    for (TSTree *tree : trees)
+      ts_tree_delete(tree);
+    return stats;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  int repetitions = argc > 1 ? std::atoi(argv[1]) : 5;
+  unsigned threads = argc > 2 ? std::max(1, std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> files = argc > 3 ? read_workspace(argc, argv) : build_workspace();
+  std::vector<std::string_view> sources(files.begin(), files.end());
+  uint64_t bytes = 0, largest = 0;
+  for (const std::string &file : files)
+  {
+    bytes += file.size();
+    largest = std::max<uint64_t>(largest, file.size());
+  }
+
+  bench::Json json;
+  json.begin_object();
+  json.field("benchmark", std::string("workspace"));
+  json.field("files", uint64_t(files.size()));
+  json.field("bytes", bytes);
+  json.field("largest_file", largest);
+  json.field("threads", uint64_t(threads));
+  json.key("classes").begin_object();
+  for (const char *name : {"static", "work_stealing"})
+  {
+    std::vector<double> samples, utilizations;
+    uint64_t tasks = 0, steals = 0;
+    for (int r = 0; r < repetitions; r++)
+    {
+      talon::Scheduler::Stats stats;
+      if (std::string(name) == "static")
+      {
+        stats = parse_static(sources, threads);
+      }
+      else
+      {
+        talon::WorkspaceOptions options;
+        options.threads = threads;
+        uint64_t start = bench::now_ns();
+        std::vector<talon::SplitTree> trees = talon::parse_workspace(sources, options, &stats);
+        // Freeing the trees is not part of the makespan.
+        stats.makespan_ns = bench::now_ns() - start;
+      }
+      samples.push_back(stats.makespan_ns / 1e6);
+      utilizations.push_back(stats.utilization());
+      tasks = stats.tasks;
+      steals = stats.steals;
+    }
+
+    json.key(name).begin_object();
+    json.field("tasks", tasks);
+    json.field("steals", steals);
+    json.field("utilization", bench::percentile(utilizations, 50));
+    json.field("mb_per_s", bytes / 1e3 / bench::percentile(samples, 50));
+    json.field("samples", samples);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  return 0;
+}
@@ -4,12 +4,14 @@
       "target_name": "tree_sitter_talon_binding",
       "include_dirs": [
         "<!(node -e \"require('nan')\")",
-        "src"
+        "src",
+        "."
       ],
       "sources": [
         "bindings/node/binding.cc",
         "src/parser.c",
-        "src/scanner.cc"
+        "src/scanner.cc",
+        "talon/header.cc"
       ],
       "cflags_c": [
         "-std=c99",
@@ -1,5 +1,8 @@
 #include "tree_sitter/parser.h"
+#include "talon/header.h"
 #include <node.h>
+#include <node_buffer.h>
+#include <vector>
 #include "nan.h"
 
 using namespace v8;
@@ -10,6 +13,62 @@ namespace {
 
 NAN_METHOD(New) {}
 
+Local<String> Slice(const char *source, uint32_t start, uint32_t end) {
+  return Nan::New(source + start, end - start).ToLocalChecked();
+}
+
+// scanHeader(source: string | Buffer, atEnd = true)
+//
+// Returns null if `source` is a prefix of the file that is too short to tell,
+// and otherwise {hasHeader, endByte, matches: [{conjunctive, negated, left, right}]}.
+NAN_METHOD(ScanHeader) {
+  std::string text;
+  const char *source;
+  size_t length;
+  if (node::Buffer::HasInstance(info[0])) {
+    source = node::Buffer::Data(info[0]);
+    length = node::Buffer::Length(info[0]);
+  } else if (info[0]->IsString()) {
+    Nan::Utf8String utf8(info[0]);
+    text.assign(*utf8, utf8.length());
+    source = text.data();
+    length = text.size();
+  } else {
+    Nan::ThrowTypeError("Expected a string or a Buffer");
+    return;
+  }
+  bool at_end = info[1]->IsUndefined() || Nan::To<bool>(info[1]).FromJust();
+
+  std::vector<TalonMatch> matches(16);
+  TalonHeader header;
+  TalonHeaderStatus status;
+  for (;;) {
+    status = talon_scan_header(source, (uint32_t)length, at_end, matches.data(), (uint32_t)matches.size(), &header);
+    if (header.match_count <= matches.size()) break;
+    matches.resize(header.match_count);
+  }
+  if (status == TALON_HEADER_INCOMPLETE) {
+    info.GetReturnValue().Set(Nan::Null());
+    return;
+  }
+
+  Local<Array> list = Nan::New<Array>(header.match_count);
+  for (uint32_t i = 0; i < header.match_count; i++) {
+    const TalonMatch &match = matches[i];
+    Local<Object> object = Nan::New<Object>();
+    Nan::Set(object, Nan::New("conjunctive").ToLocalChecked(), Nan::New(match.conjunctive));
+    Nan::Set(object, Nan::New("negated").ToLocalChecked(), Nan::New(match.negated));
+    Nan::Set(object, Nan::New("left").ToLocalChecked(), Slice(source, match.left_start, match.left_end));
+    Nan::Set(object, Nan::New("right").ToLocalChecked(), Slice(source, match.right_start, match.right_end));
+    Nan::Set(list, i, object);
+  }
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("hasHeader").ToLocalChecked(), Nan::New(status == TALON_HEADER_FOUND));
+  Nan::Set(result, Nan::New("endByte").ToLocalChecked(), Nan::New(header.end_byte));
+  Nan::Set(result, Nan::New("matches").ToLocalChecked(), list);
+  info.GetReturnValue().Set(result);
+}
+
 void Init(Local<Object> exports, Local<Object> module) {
   Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
   tpl->SetClassName(Nan::New("Language").ToLocalChecked());
@@ -20,6 +79,8 @@ void Init(Local<Object> exports, Local<Object> module) {
   Nan::SetInternalFieldPointer(instance, 0, tree_sitter_talon());
 
   Nan::Set(instance, Nan::New("name").ToLocalChecked(), Nan::New("talon").ToLocalChecked());
+  Nan::Set(instance, Nan::New("scanHeader").ToLocalChecked(),
+           Nan::GetFunction(Nan::New<FunctionTemplate>(ScanHeader)).ToLocalChecked());
   Nan::Set(module, Nan::New("exports").ToLocalChecked(), instance);
 }
 
@@ -17,3 +17,64 @@ try {
 try {
   module.exports.nodeTypeInfo = require("../../src/node-types.json");
 } catch (_) {}
+
+// Scans the header of the file at `path`, reading it in small chunks so that
+// the declarations after the header are not read. See scanHeader.
+module.exports.scanHeaderFile = function scanHeaderFile(path, chunkSize = 4096) {
+  const fs = require('fs');
+  const fd = fs.openSync(path, 'r');
+  try {
+    let buffer = Buffer.alloc(0);
+    for (;;) {
+      const chunk = Buffer.alloc(chunkSize);
+      const bytesRead = fs.readSync(fd, chunk, 0, chunkSize, buffer.length);
+      buffer = Buffer.concat([buffer, chunk.subarray(0, bytesRead)]);
+      const result = module.exports.scanHeader(buffer, bytesRead === 0);
+      if (result !== null) return result;
+    }
+  } finally {
+    fs.closeSync(fd);
+  }
+};
+
+// Parses `source` with a `tree-sitter` Parser, bounded by a deadline and an
+// AbortSignal, and reports progress as the number of characters read so far:
+//
+//   parseWithLimits(parser, source, { timeoutMicros, signal, onProgress, oldTree })
+//
+// The parser reads `source` in chunks of `chunkSize` characters, and stops
+// reading when the signal is aborted or the deadline passes, which ends the
+// parse early. The native timeout also bounds work between two reads. On
+// either, the tree is discarded, the parser is reset so that the next parse
+// does not resume this one, and an Error is thrown whose `code` is 'ABORT_ERR'
+// or 'ETIMEDOUT'.
+module.exports.parseWithLimits = function parseWithLimits(parser, source, options = {}) {
+  const { oldTree = null, timeoutMicros = 0, signal = null, onProgress = null, chunkSize = 4096 } = options;
+  const deadline = timeoutMicros > 0 ? process.hrtime.bigint() + BigInt(timeoutMicros) * 1000n : null;
+  let stopped = null;
+  const read = (index) => {
+    if (signal && signal.aborted) stopped = 'ABORT_ERR';
+    else if (deadline !== null && process.hrtime.bigint() > deadline) stopped = 'ETIMEDOUT';
+    if (stopped || index >= source.length) return null;
+    const chunk = source.slice(index, index + chunkSize);
+    if (onProgress) onProgress(index + chunk.length, source.length);
+    return chunk;
+  };
+
+  const previousTimeout = parser.getTimeoutMicros();
+  parser.setTimeoutMicros(timeoutMicros);
+  let tree;
+  try {
+    tree = parser.parse(read, oldTree);
+  } finally {
+    parser.setTimeoutMicros(previousTimeout);
+  }
+  if (!tree && !stopped) stopped = 'ETIMEDOUT';
+  if (stopped) {
+    parser.reset();
+    const error = new Error(stopped === 'ABORT_ERR' ? 'The parse was aborted' : 'The parse timed out');
+    error.code = stopped;
+    throw error;
+  }
+  return tree;
+};
@@ -35,4 +35,14 @@ fn main() {
     cpp_config.file(&scanner_path);
     cpp_config.compile("scanner");
     println!("cargo:rerun-if-changed={}", scanner_path.to_str().unwrap());
+
+    // The header scanner from the native library, for `parse_header`.
+
+    let mut header_config = cc::Build::new();
+    header_config.cpp(true);
+    header_config.include(".");
+    let header_path = std::path::Path::new("talon").join("header.cc");
+    header_config.file(&header_path);
+    header_config.compile("talon_header");
+    println!("cargo:rerun-if-changed={}", header_path.to_str().unwrap());
 }
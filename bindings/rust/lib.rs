@@ -15,12 +15,44 @@
 //! [Parser]: https://docs.rs/tree-sitter/*/tree_sitter/struct.Parser.html
 //! [tree-sitter]: https://tree-sitter.github.io/
 
-use tree_sitter::Language;
+use std::ops::Range;
+use std::os::raw::c_char;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use tree_sitter::{Language, Parser, Tree};
 
 extern "C" {
     fn tree_sitter_talon() -> Language;
+    fn talon_scan_header(
+        source: *const c_char,
+        length: u32,
+        at_end: bool,
+        matches: *mut TalonMatch,
+        capacity: u32,
+        header: *mut TalonHeader,
+    ) -> u32;
 }
 
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+struct TalonMatch {
+    conjunctive: bool,
+    negated: bool,
+    left_start: u32,
+    left_end: u32,
+    right_start: u32,
+    right_end: u32,
+}
+
+#[repr(C)]
+#[derive(Default)]
+struct TalonHeader {
+    end_byte: u32,
+    match_count: u32,
+}
+
+const TALON_HEADER_FOUND: u32 = 1;
+const TALON_HEADER_INCOMPLETE: u32 = 2;
+
 /// Get the tree-sitter [Language][] for this grammar.
 ///
 /// [Language]: https://docs.rs/tree-sitter/*/tree_sitter/struct.Language.html
@@ -28,6 +60,139 @@ pub fn language() -> Language {
     unsafe { tree_sitter_talon() }
 }
 
+/// A `match` line from the header of a talon file, e.g., `and not tag: user.terminal`, as byte
+/// ranges of its identifier and its value.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Match {
+    pub conjunctive: bool,
+    pub negated: bool,
+    pub left: Range<usize>,
+    pub right: Range<usize>,
+}
+
+/// The result of [parse_header][].
+///
+/// [parse_header]: fn.parse_header.html
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum Header {
+    /// The file has no header.
+    None,
+    /// The header ends at `end_byte`, where the declarations start.
+    Found { end_byte: usize, matches: Vec<Match> },
+    /// `source` is a prefix of the file that is too short to tell.
+    Incomplete,
+}
+
+/// Scans the `matches` header of a talon file up to its line of dashes, without the parser and
+/// without reading the declarations after it. `source` may be a prefix of the file, unless
+/// `at_end` is set. A header must end within the first 64 KiB, so a headerless file of lines
+/// that look like matches, such as one-line commands, is read no further than that.
+pub fn parse_header(source: &[u8], at_end: bool) -> Header {
+    let length = source.len().min(u32::MAX as usize) as u32;
+    let mut matches = vec![TalonMatch::default(); 16];
+    let mut header = TalonHeader::default();
+    let status = loop {
+        let status = unsafe {
+            talon_scan_header(
+                source.as_ptr() as *const c_char,
+                length,
+                at_end,
+                matches.as_mut_ptr(),
+                matches.len() as u32,
+                &mut header,
+            )
+        };
+        if header.match_count as usize <= matches.len() {
+            break status;
+        }
+        matches.resize(header.match_count as usize, TalonMatch::default());
+    };
+    match status {
+        TALON_HEADER_FOUND => Header::Found {
+            end_byte: header.end_byte as usize,
+            matches: matches[..header.match_count as usize]
+                .iter()
+                .map(|m| Match {
+                    conjunctive: m.conjunctive,
+                    negated: m.negated,
+                    left: m.left_start as usize..m.left_end as usize,
+                    right: m.right_start as usize..m.right_end as usize,
+                })
+                .collect(),
+        },
+        TALON_HEADER_INCOMPLETE => Header::Incomplete,
+        _ => Header::None,
+    }
+}
+
+/// Limits for [parse_with_options][].
+///
+/// [parse_with_options]: fn.parse_with_options.html
+#[derive(Default)]
+pub struct ParseOptions<'a> {
+    /// Gives up after this many microseconds, or never if 0.
+    pub timeout_micros: u64,
+    /// Gives up soon after another thread sets the flag to a nonzero value.
+    pub cancellation_flag: Option<&'a AtomicUsize>,
+    /// Called with the number of bytes read so far and the size of the source.
+    pub progress: Option<&'a mut dyn FnMut(usize, usize)>,
+}
+
+/// Why [parse_with_options][] gave up.
+///
+/// [parse_with_options]: fn.parse_with_options.html
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum ParseError {
+    TimedOut,
+    Cancelled,
+}
+
+/// Parses `source` with `parser`, bounded by `options`, feeding it 4 KB at a time so that
+/// progress can be reported. If the parse times out or is cancelled, the parser is reset so
+/// that the next parse starts afresh instead of resuming this one. Either way, the parser's own
+/// timeout is restored and its cancellation flag is cleared.
+pub fn parse_with_options(
+    parser: &mut Parser,
+    source: &[u8],
+    old_tree: Option<&Tree>,
+    mut options: ParseOptions,
+) -> Result<Tree, ParseError> {
+    const CHUNK_SIZE: usize = 4096;
+    let timeout = parser.timeout_micros();
+    parser.set_timeout_micros(options.timeout_micros);
+    // The flag is cleared again below, before the borrow ends.
+    unsafe { parser.set_cancellation_flag(options.cancellation_flag) };
+
+    let mut bytes_read = 0;
+    let tree = parser.parse_with(
+        &mut |byte, _| {
+            let start = byte.min(source.len());
+            let end = (start + CHUNK_SIZE).min(source.len());
+            if end > bytes_read {
+                bytes_read = end;
+                if let Some(progress) = options.progress.as_mut() {
+                    progress(end, source.len());
+                }
+            }
+            &source[start..end]
+        },
+        old_tree,
+    );
+
+    parser.set_timeout_micros(timeout);
+    unsafe { parser.set_cancellation_flag(None) };
+    match tree {
+        Some(tree) => Ok(tree),
+        None => {
+            parser.reset();
+            match options.cancellation_flag {
+                Some(flag) if flag.load(Ordering::Relaxed) != 0 => Err(ParseError::Cancelled),
+                _ => Err(ParseError::TimedOut),
+            }
+        }
+    }
+}
+
 /// The content of the [`node-types.json`][] file for this grammar.
 ///
 /// [`node-types.json`]: https://tree-sitter.github.io/tree-sitter/using-parsers#static-node-types
@@ -49,4 +214,54 @@ mod tests {
             .set_language(super::language())
             .expect("Error loading talon language");
     }
+
+    #[test]
+    fn test_parse_with_options() {
+        use super::{parse_with_options, ParseError, ParseOptions};
+        use std::sync::atomic::AtomicUsize;
+
+        let mut parser = tree_sitter::Parser::new();
+        parser.set_language(super::language()).unwrap();
+        let source = "foo:\n    key(a)\n    sleep(50ms)\n".repeat(20000);
+        let expected = parser.parse(&source, None).unwrap().root_node().to_sexp();
+
+        let mut reports = Vec::new();
+        let mut progress = |read: usize, _: usize| reports.push(read);
+        let options = ParseOptions { progress: Some(&mut progress), ..Default::default() };
+        let tree = parse_with_options(&mut parser, source.as_bytes(), None, options).unwrap();
+        assert_eq!(tree.root_node().to_sexp(), expected);
+        assert_eq!(reports.last(), Some(&source.len()));
+
+        let flag = AtomicUsize::new(1);
+        let options = ParseOptions { cancellation_flag: Some(&flag), ..Default::default() };
+        let result = parse_with_options(&mut parser, source.as_bytes(), None, options);
+        assert_eq!(result.err(), Some(ParseError::Cancelled));
+
+        let options = ParseOptions { timeout_micros: 1, ..Default::default() };
+        let result = parse_with_options(&mut parser, source.as_bytes(), None, options);
+        assert_eq!(result.err(), Some(ParseError::TimedOut));
+
+        let tree = parser.parse(&source, None).unwrap();
+        assert_eq!(tree.root_node().to_sexp(), expected);
+    }
+
+    #[test]
+    fn test_parse_header() {
+        use super::{parse_header, Header, Match};
+        let source = b"not app: vscode\ntag: user.git\n-\ngit status: \"git status\"\n";
+        assert_eq!(
+            parse_header(source, true),
+            Header::Found {
+                end_byte: 32,
+                matches: vec![
+                    Match { conjunctive: false, negated: true, left: 4..7, right: 9..15 },
+                    Match { conjunctive: false, negated: false, left: 16..19, right: 21..29 },
+                ],
+            }
+        );
+        assert_eq!(parse_header(b"tag: user.git\n", false), Header::Incomplete);
+        assert_eq!(parse_header(b"git status: \"git status\"\n", true), Header::None);
+        let commands = b"hello: key(a)\n".repeat(5000);
+        assert_eq!(parse_header(&commands, false), Header::None);
+    }
 }
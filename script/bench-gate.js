@@ -0,0 +1,141 @@
+#!/usr/bin/env node
+
+// Usage: script/bench-gate.js [--update] [--threshold=0.05] [--alpha=0.01] [--baseline=path] [benchmark..]
+//
+// Runs the native benchmarks (parse, incremental and memory by default) and
+// compares the samples of every input class against the baseline, by default
+// bench/baseline.json. A class regresses if its median cost grew by more than
+// the threshold and a one-sided Mann-Whitney U test says the growth is not
+// noise. Exits with 1 if any class regressed, or if a benchmark has no
+// baseline at all, so that an empty baseline cannot pass. With --update,
+// writes the results as the new baseline instead. The baseline is measured
+// per machine and is not committed. Run script/build-native first.
+
+const fs = require('fs');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const root = path.resolve(__dirname, '..');
+
+const benchmarks = {
+  parse: ['10'],
+  incremental: ['10'],
+  memory: [],
+};
+
+const options = { update: false, threshold: 0.05, alpha: 0.01, baseline: path.join(root, 'bench', 'baseline.json') };
+const selected = [];
+for (const arg of process.argv.slice(2)) {
+  const [name, value] = arg.replace(/^--/, '').split('=');
+  if (arg === '--update') {
+    options.update = true;
+  } else if (arg.startsWith('--baseline=') && value) {
+    options.baseline = path.resolve(value);
+  } else if (arg.startsWith('--') && typeof options[name] === 'number') {
+    options[name] = Number(value);
+  } else if (arg in benchmarks) {
+    selected.push(arg);
+  } else {
+    console.error(`Unknown argument: ${arg}`);
+    process.exit(2);
+  }
+}
+if (selected.length === 0) selected.push(...Object.keys(benchmarks));
+
+function run(benchmark) {
+  const program = path.join(root, 'build', 'native', 'bench', benchmark);
+  const result = spawnSync(program, benchmarks[benchmark], { cwd: root, encoding: 'utf8' });
+  if (result.error || result.status !== 0) {
+    console.error(`${benchmark} failed: ${result.error || result.stderr}`);
+    process.exit(2);
+  }
+  return JSON.parse(result.stdout);
+}
+
+function median(values) {
+  const sorted = [...values].sort((a, b) => a - b);
+  const middle = sorted.length >> 1;
+  return sorted.length % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+// Standard normal CDF, with erf from Abramowitz and Stegun 7.1.26.
+function normalCdf(z) {
+  const x = Math.abs(z) / Math.SQRT2;
+  const t = 1 / (1 + 0.3275911 * x);
+  const poly = t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))));
+  const erf = 1 - poly * Math.exp(-x * x);
+  return z >= 0 ? (1 + erf) / 2 : (1 - erf) / 2;
+}
+
+// Returns the p-value of the hypothesis that `current` is not larger than
+// `baseline`, by the Mann-Whitney U test with the normal approximation and a
+// correction for ties.
+function mannWhitney(baseline, current) {
+  // Deterministic benchmarks, e.g., memory, repeat one value.
+  const constant = (values) => values.every((value) => value === values[0]);
+  if (constant(baseline) && constant(current)) return current[0] > baseline[0] ? 0 : 1;
+  const all = [
+    ...baseline.map((value) => ({ value, current: false })),
+    ...current.map((value) => ({ value, current: true })),
+  ].sort((a, b) => a.value - b.value);
+  let rankSum = 0;
+  let tieTerm = 0;
+  for (let i = 0; i < all.length; ) {
+    let j = i;
+    while (j < all.length && all[j].value === all[i].value) j++;
+    const rank = (i + j + 1) / 2;
+    for (let k = i; k < j; k++) if (all[k].current) rankSum += rank;
+    tieTerm += (j - i) ** 3 - (j - i);
+    i = j;
+  }
+  const m = current.length;
+  const n = baseline.length;
+  const u = rankSum - (m * (m + 1)) / 2;
+  const variance = ((m * n) / 12) * (m + n + 1 - tieTerm / ((m + n) * (m + n - 1)));
+  return 1 - normalCdf((u - (m * n) / 2 - 0.5) / Math.sqrt(variance));
+}
+
+const baselinePath = options.baseline;
+const baseline = fs.existsSync(baselinePath) ? JSON.parse(fs.readFileSync(baselinePath, 'utf8')) : {};
+const results = {};
+let regressions = 0;
+let unmeasured = 0;
+
+for (const benchmark of selected) {
+  console.log(`Running ${benchmark}`);
+  const classes = run(benchmark).classes;
+  results[benchmark] = {};
+  let compared = 0;
+  for (const [name, { samples }] of Object.entries(classes)) {
+    results[benchmark][name] = { samples };
+    const reference = baseline[benchmark] && baseline[benchmark][name];
+    if (!reference || !reference.samples || reference.samples.length === 0) {
+      console.log(`  ${name.padEnd(24)} no baseline`);
+      continue;
+    }
+    compared++;
+    const change = median(samples) / median(reference.samples) - 1;
+    const p = mannWhitney(reference.samples, samples);
+    const regressed = change > options.threshold && p < options.alpha;
+    if (regressed) regressions++;
+    const sign = change >= 0 ? '+' : '';
+    console.log(
+      `  ${name.padEnd(24)} ${sign}${(change * 100).toFixed(1)}%  p=${p.toFixed(4)}${regressed ? '  REGRESSION' : ''}`
+    );
+  }
+  if (compared === 0) {
+    console.log(`  no class of ${benchmark} has a baseline`);
+    unmeasured++;
+  }
+}
+
+if (options.update) {
+  fs.writeFileSync(baselinePath, JSON.stringify({ ...baseline, ...results }, null, 2) + '\n');
+  console.log(`Updated ${path.relative(root, baselinePath)}`);
+} else if (regressions > 0) {
+  console.error(`${regressions} classes regressed`);
+  process.exit(1);
+} else if (unmeasured > 0) {
+  console.error(`${unmeasured} benchmarks have no baseline; record one with --update`);
+  process.exit(1);
+}
@@ -70,7 +70,9 @@ namespace
 
   struct Scanner
   {
-    Scanner()
+    // In lazy mode, the scanner returns the statements of every indented
+    // block as a single comment, which talon/lazy.h parses on demand.
+    Scanner(bool lazy = false) : lazy(lazy)
     {
       assert(sizeof(Delimiter) == sizeof(char));
       deserialize(NULL, 0);
@@ -95,6 +97,12 @@ namespace
       // serialize the previous_indent_length
       buffer[i++] = previous_indent_length;
 
+      // serialize whether the next block is to be skipped, in lazy mode only
+      if (lazy)
+      {
+        buffer[i++] = skip_next_block;
+      }
+
       return i;
     }
 
@@ -102,6 +110,7 @@ namespace
     {
       delimiter_stack.clear();
       previous_indent_length = 0;
+      skip_next_block = false;
 
       if (length > 0)
       {
@@ -118,6 +127,12 @@ namespace
 
         // deserialize previous_indent_length
         previous_indent_length = buffer[i++];
+
+        // deserialize skip_next_block
+        if (lazy && i < length)
+        {
+          skip_next_block = buffer[i++];
+        }
       }
     }
 
@@ -245,8 +260,93 @@ namespace
       return false;
     }
 
+    // Consumes the lines of the block that starts after the current line, up
+    // to the first line that starts at column 0, is not a comment and does not
+    // continue a line ending in a backslash. Leading whitespace is skipped and
+    // the token ends after the content of the last line of the block.
+    //
+    // Comment lines are kept in the block the way scan() delays the dedent: a
+    // run of comments belongs to the block if its first comment is indented as
+    // deep as the block, or if an indented line follows it. Comments before
+    // the first statement are skipped, as they come before the block.
+    bool skip_block(TSLexer *lexer)
+    {
+      bool has_content = false;
+      bool continued = false;
+      int32_t first_comment_indent_length = -1;
+      advance_line(lexer, true);
+      while (lexer->lookahead)
+      {
+        uint32_t indent_length = 0;
+        for (;;)
+        {
+          if (lexer->lookahead == ' ')
+            indent_length++;
+          else if (lexer->lookahead == '\t')
+            indent_length += 8;
+          else if (lexer->lookahead == '\r' || lexer->lookahead == '\f')
+            indent_length = 0;
+          else
+            break;
+          lexer->advance(lexer, !has_content);
+        }
+        if (lexer->lookahead == '\n')
+        { // blank line
+          lexer->advance(lexer, !has_content);
+          continue;
+        }
+        bool comment = lexer->lookahead == '#' && !continued;
+        if (lexer->lookahead == 0 || (indent_length == 0 && !continued && !comment))
+        {
+          break;
+        }
+        if (comment && first_comment_indent_length == -1)
+        {
+          first_comment_indent_length = (int32_t)indent_length;
+        }
+
+        int32_t last = 0;
+        while (lexer->lookahead && lexer->lookahead != '\n')
+        {
+          if (lexer->lookahead != '\r')
+          {
+            last = lexer->lookahead;
+          }
+          lexer->advance(lexer, !has_content && comment);
+        }
+        // A comment that may come after the end of the block is consumed
+        // without moving the end of the token.
+        if (!comment || (has_content && first_comment_indent_length >= (int32_t)previous_indent_length))
+        {
+          if (!comment)
+          {
+            first_comment_indent_length = -1;
+          }
+          has_content = true;
+          continued = !comment && last == '\\';
+          lexer->mark_end(lexer);
+        }
+        if (lexer->lookahead == '\n')
+        {
+          lexer->advance(lexer, !has_content);
+        }
+      }
+      return has_content;
+    }
+
     bool scan(TSLexer *lexer, const bool *valid_symbols)
     {
+      // In lazy mode, skip the block that the last token indented.
+      if (skip_next_block)
+      {
+        skip_next_block = false;
+        if (valid_symbols[COMMENT] && valid_symbols[DEDENT] && !valid_symbols[NEWLINE])
+        {
+          lexer->result_symbol = COMMENT;
+          return skip_block(lexer);
+        }
+      }
+
       // Check for string content.
       if (valid_symbols[STRING_CONTENT] && !delimiter_stack.empty())
       {
@@ -355,6 +455,7 @@ namespace
             indent_length > 0)
         {
           previous_indent_length = indent_length;
+          skip_next_block = lazy;
           lexer->result_symbol = INDENT;
           return true;
         }
@@ -410,6 +511,8 @@ namespace
 
     uint16_t previous_indent_length;
     vector<Delimiter> delimiter_stack;
+    bool lazy;
+    bool skip_next_block;
   };
 
 }
@@ -422,6 +525,11 @@ extern "C"
     return new Scanner();
   }
 
+  void *tree_sitter_talon_lazy_external_scanner_create()
+  {
+    return new Scanner(true);
+  }
+
   bool tree_sitter_talon_external_scanner_scan(void *payload, TSLexer *lexer,
                                                const bool *valid_symbols)
   {
@@ -0,0 +1,517 @@
+#include "talon/bytecode.h"
+#include "talon/language.h"
+#include "talon/number.h"
+#include "talon/util.h"
+#include <cmath>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    bool is_number(const Value &v)
+    {
+      return v.type == Value::INT || v.type == Value::FLOAT;
+    }
+
+    double as_float(const Value &v)
+    {
+      return v.type == Value::INT ? double(v.i) : v.f;
+    }
+
+  }
+
+  bool apply_binary(Opcode op, const Value &left, const Value &right, Value &result)
+  {
+    if (left.type == Value::INT && right.type == Value::INT)
+    {
+      switch (op)
+      {
+      // Python integers do not overflow; ours fail instead of wrapping.
+      case OP_ADD:
+        result = Value::of_int(0);
+        return !__builtin_add_overflow(left.i, right.i, &result.i);
+      case OP_SUB:
+        result = Value::of_int(0);
+        return !__builtin_sub_overflow(left.i, right.i, &result.i);
+      case OP_MUL:
+        result = Value::of_int(0);
+        return !__builtin_mul_overflow(left.i, right.i, &result.i);
+      case OP_DIV:
+        if (right.i == 0)
+          return false;
+        result = Value::of_float(double(left.i) / double(right.i));
+        return true;
+      case OP_MOD:
+      {
+        if (right.i == 0)
+          return false;
+        // INT64_MIN % -1 traps, though the result is 0.
+        if (right.i == -1)
+        {
+          result = Value::of_int(0);
+          return true;
+        }
+        int64_t m = left.i % right.i;
+        if (m != 0 && ((m < 0) != (right.i < 0)))
+          m += right.i;
+        result = Value::of_int(m);
+        return true;
+      }
+      default:
+        return false;
+      }
+    }
+
+    if (is_number(left) && is_number(right))
+    {
+      double a = as_float(left), b = as_float(right);
+      switch (op)
+      {
+      case OP_ADD:
+        result = Value::of_float(a + b);
+        return true;
+      case OP_SUB:
+        result = Value::of_float(a - b);
+        return true;
+      case OP_MUL:
+        result = Value::of_float(a * b);
+        return true;
+      case OP_DIV:
+        if (b == 0)
+          return false;
+        result = Value::of_float(a / b);
+        return true;
+      case OP_MOD:
+      {
+        if (b == 0)
+          return false;
+        // Python's float modulo takes the sign of the divisor, zero included.
+        double m = std::fmod(a, b);
+        if (m == 0)
+          m = std::copysign(0.0, b);
+        else if ((m < 0) != (b < 0))
+          m += b;
+        result = Value::of_float(m);
+        return true;
+      }
+      default:
+        return false;
+      }
+    }
+
+    if (op == OP_ADD && left.type == Value::STRING && right.type == Value::STRING)
+    {
+      result = Value::of_string(left.s + right.s);
+      return true;
+    }
+
+    if (op == OP_MUL && (left.type == Value::STRING || right.type == Value::STRING))
+    {
+      const Value &text = left.type == Value::STRING ? left : right;
+      const Value &count = left.type == Value::STRING ? right : left;
+      if (count.type != Value::INT)
+        return false;
+      if (count.i > 0 && text.s.size() > max_string_size / uint64_t(count.i))
+        return false;
+      std::string repeated;
+      if (count.i > 0)
+        repeated.reserve(text.s.size() * count.i);
+      for (int64_t n = 0; n < count.i; n++)
+        repeated += text.s;
+      result = Value::of_string(std::move(repeated));
+      return true;
+    }
+
+    return false;
+  }
+
+  ActionTable::ActionTable()
+  {
+    intern("key");
+    intern("sleep");
+  }
+
+  uint32_t ActionTable::intern(std::string_view name)
+  {
+    auto [it, inserted] = ids.emplace(std::string(name), uint32_t(names.size()));
+    if (inserted)
+      names.emplace_back(name);
+    return it->second;
+  }
+
+  uint32_t ActionTable::find(std::string_view name) const
+  {
+    auto it = ids.find(std::string(name));
+    return it == ids.end() ? npos : it->second;
+  }
+
+  uint32_t Program::variable_slot(std::string_view name) const
+  {
+    for (uint32_t i = 0; i < variables.size(); i++)
+      if (variables[i] == name)
+        return i;
+    return ActionTable::npos;
+  }
+
+  void Program::encode(std::string &out) const
+  {
+    auto append = [&](uint64_t value) { out.append((const char *)&value, sizeof(value)); };
+    append(code.size());
+    for (const Instruction &instruction : code)
+    {
+      out += char(instruction.op);
+      out += char(instruction.dst);
+      append(uint64_t(instruction.a) | uint64_t(instruction.b) << 16 | uint64_t(instruction.c) << 32);
+    }
+    append(constants.size());
+    for (const Value &constant : constants)
+    {
+      out += char(constant.type);
+      if (constant.type == Value::INT)
+        append(uint64_t(constant.i));
+      else if (constant.type == Value::FLOAT)
+        out.append((const char *)&constant.f, sizeof(constant.f));
+      if (constant.type != Value::STRING)
+        continue;
+      append(constant.s.size());
+      out += constant.s;
+    }
+    templates.encode(out);
+    append(variables.size());
+    for (const std::string &variable : variables)
+    {
+      append(variable.size());
+      out += variable;
+    }
+    append(register_count);
+  }
+
+  size_t Program::memory_size() const
+  {
+    size_t size = sizeof(Program) + code.capacity() * sizeof(Instruction) + constants.capacity() * sizeof(Value) +
+                  templates.memory_size() + variables.capacity() * sizeof(std::string);
+    for (const Value &constant : constants)
+      size += heap_size(constant.s);
+    for (const std::string &variable : variables)
+      size += heap_size(variable);
+    return size;
+  }
+
+  bool Compiler::compile(TSNode block, std::string_view text, Program &out)
+  {
+    source = text;
+    program = &out;
+    message.clear();
+    out = Program();
+
+    uint32_t count = ts_node_named_child_count(block);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode node = ts_node_named_child(block, i);
+      if (ts_node_is_extra(node))
+        continue;
+      if (!statement(node))
+        return false;
+    }
+    return true;
+  }
+
+  bool Compiler::fail(TSNode node, const char *what)
+  {
+    TSPoint point = ts_node_start_point(node);
+    message = std::string(what) + " at " + std::to_string(point.row + 1) + ":" +
+              std::to_string(point.column + 1);
+    return false;
+  }
+
+  bool Compiler::emit(Opcode op, uint32_t dst, uint32_t a, uint32_t b, uint32_t c)
+  {
+    if (dst > UINT8_MAX || a > UINT16_MAX || b > UINT16_MAX || c > UINT16_MAX)
+    {
+      message = "Command body is too large to compile";
+      return false;
+    }
+    program->code.push_back(Instruction{op, uint8_t(dst), uint16_t(a), uint16_t(b), uint16_t(c)});
+    return true;
+  }
+
+  uint32_t Compiler::constant(Value value)
+  {
+    program->constants.push_back(std::move(value));
+    return program->constants.size() - 1;
+  }
+
+  uint32_t Compiler::variable(std::string_view name)
+  {
+    uint32_t slot = program->variable_slot(name);
+    if (slot != ActionTable::npos)
+      return slot;
+    program->variables.emplace_back(name);
+    return program->variables.size() - 1;
+  }
+
+  bool Compiler::statement(TSNode node)
+  {
+    const Symbols &s = symbols();
+    TSSymbol symbol = ts_node_symbol(node);
+
+    if (symbol == s.assignment_statement)
+    {
+      TSNode left = ts_node_child_by_field_id(node, s.left);
+      TSNode right = ts_node_child_by_field_id(node, s.right);
+      if (ts_node_is_null(left) || ts_node_is_null(right))
+        return fail(node, "Incomplete assignment");
+      if (!expression(right, 0))
+        return false;
+      return emit(OP_STORE_VAR, 0, variable(node_text(source, left)), 0);
+    }
+
+    if (symbol == s.expression_statement)
+    {
+      TSNode expr = ts_node_child_by_field_id(node, s.expression);
+      if (ts_node_is_null(expr))
+        return fail(node, "Incomplete statement");
+      return expression(expr, 0);
+    }
+
+    return fail(node, "Unexpected statement");
+  }
+
+  bool Compiler::call(uint32_t action, uint32_t dst, uint32_t argc)
+  {
+    return emit(OP_CALL, dst, action, dst, argc);
+  }
+
+  bool Compiler::expression(TSNode node, uint32_t dst)
+  {
+    const Symbols &s = symbols();
+    TSSymbol symbol = ts_node_symbol(node);
+
+    if (dst + 1 > program->register_count)
+      program->register_count = dst + 1;
+
+    if (symbol == s.integer || symbol == s.float_)
+    {
+      Number number = decode_number(node_text(source, node));
+      if (number.kind == Number::INVALID)
+        return fail(node, "Invalid number");
+      if (number.is_imaginary)
+        return fail(node, "Unsupported imaginary number");
+      if (number.kind == Number::INTEGER && (number.overflow || number.integer > uint64_t(INT64_MAX)))
+        return fail(node, "Integer is too large");
+      Value value = number.kind == Number::FLOAT ? Value::of_float(number.real)
+                                                 : Value::of_int(int64_t(number.integer));
+      return emit(OP_LOAD_CONST, dst, constant(std::move(value)));
+    }
+
+    if (symbol == s.string)
+      return string(node, dst);
+
+    if (symbol == s.variable)
+    {
+      TSNode name = ts_node_child_by_field_id(node, s.variable_name);
+      return emit(OP_LOAD_VAR, dst, variable(node_text(source, name)));
+    }
+
+    if (symbol == s.parenthesized_expression)
+    {
+      if (ts_node_named_child_count(node) == 0)
+        return fail(node, "Empty parentheses");
+      return expression(ts_node_named_child(node, 0), dst);
+    }
+
+    if (symbol == s.unary_operator)
+    {
+      TSNode right = ts_node_child_by_field_id(node, s.right);
+      if (ts_node_is_null(right))
+        return fail(node, "Incomplete operator");
+      return expression(right, dst) && emit(OP_NEG, dst, dst);
+    }
+
+    if (symbol == s.binary_operator)
+    {
+      TSNode left = ts_node_child_by_field_id(node, s.left);
+      TSNode right = ts_node_child_by_field_id(node, s.right);
+      TSNode op = ts_node_child_by_field_id(node, s.operator_field);
+      if (ts_node_is_null(left) || ts_node_is_null(right) || ts_node_is_null(op))
+        return fail(node, "Incomplete operator");
+
+      std::string_view name = node_text(source, op);
+      if (name == "or")
+      { // Only evaluate the right operand when the left one is falsy.
+        if (!expression(left, dst) || !emit(OP_JUMP_IF_TRUTHY, dst, 0))
+          return false;
+        size_t jump = program->code.size() - 1;
+        if (!expression(right, dst))
+          return false;
+        if (program->code.size() > UINT16_MAX)
+          return fail(node, "Command body is too large to compile");
+        program->code[jump].a = program->code.size();
+        return true;
+      }
+
+      Opcode opcode;
+      if (name == "+")
+        opcode = OP_ADD;
+      else if (name == "-")
+        opcode = OP_SUB;
+      else if (name == "*")
+        opcode = OP_MUL;
+      else if (name == "/")
+        opcode = OP_DIV;
+      else if (name == "%")
+        opcode = OP_MOD;
+      else
+        return fail(op, "Unknown operator");
+
+      return expression(left, dst) && expression(right, dst + 1) &&
+             emit(opcode, dst, dst, dst + 1);
+    }
+
+    if (symbol == s.key_action || symbol == s.sleep_action)
+    {
+      TSNode argument = ts_node_child_by_field_id(node, s.arguments);
+      std::string_view text = ts_node_is_null(argument) ? std::string_view() : node_text(source, argument);
+      uint32_t action = symbol == s.key_action ? ActionTable::KEY : ActionTable::SLEEP;
+      return emit(OP_LOAD_CONST, dst, constant(Value::of_string(std::string(text)))) &&
+             call(action, dst, 1);
+    }
+
+    if (symbol == s.action)
+    {
+      TSNode name = ts_node_child_by_field_id(node, s.action_name);
+      TSNode arguments = ts_node_child_by_field_id(node, s.arguments);
+      uint32_t argc = 0;
+      uint32_t count = ts_node_named_child_count(arguments);
+      for (uint32_t i = 0; i < count; i++)
+      {
+        TSNode argument = ts_node_named_child(arguments, i);
+        if (ts_node_is_extra(argument))
+          continue;
+        if (!expression(argument, dst + argc))
+          return false;
+        argc++;
+      }
+      return call(actions.intern(node_text(source, name)), dst, argc);
+    }
+
+    return fail(node, "Unexpected expression");
+  }
+
+  bool Compiler::string(TSNode node, uint32_t dst)
+  {
+    std::vector<TSNode> slots;
+    uint32_t id = program->templates.compile(node, source, slots);
+
+    // A string without interpolations is a constant.
+    if (slots.empty())
+    {
+      std::string text;
+      program->templates.format(id, nullptr, text);
+      return emit(OP_LOAD_CONST, dst, constant(Value::of_string(std::move(text))));
+    }
+
+    for (uint32_t i = 0; i < slots.size(); i++)
+    {
+      if (ts_node_is_null(slots[i]))
+        return fail(node, "Empty interpolation");
+      if (!expression(slots[i], dst + i))
+        return false;
+    }
+    return emit(OP_FORMAT, dst, id, dst);
+  }
+
+  void VM::bind(uint32_t action, Action fn)
+  {
+    if (action >= actions.size())
+      actions.resize(action + 1);
+    actions[action] = std::move(fn);
+  }
+
+  bool VM::run(const Program &program, Value *variables)
+  {
+    message.clear();
+    if (registers.size() < program.register_count)
+      registers.resize(program.register_count);
+
+    const Instruction *code = program.code.data();
+    size_t size = program.code.size();
+    for (size_t pc = 0; pc < size; pc++)
+    {
+      const Instruction &in = code[pc];
+      Value &dst = registers[in.dst];
+      switch (in.op)
+      {
+      case OP_LOAD_CONST:
+        dst = program.constants[in.a];
+        break;
+      case OP_LOAD_VAR:
+        dst = variables[in.a];
+        break;
+      case OP_STORE_VAR:
+        variables[in.a] = registers[in.b];
+        break;
+      case OP_ADD:
+      case OP_SUB:
+      case OP_MUL:
+      case OP_DIV:
+      case OP_MOD:
+      {
+        Value result;
+        if (!apply_binary(in.op, registers[in.a], registers[in.b], result))
+        {
+          message = "Unsupported operands or overflow";
+          return false;
+        }
+        dst = std::move(result);
+        break;
+      }
+      case OP_NEG:
+      {
+        const Value &operand = registers[in.a];
+        if (operand.type == Value::INT && operand.i == INT64_MIN)
+        {
+          message = "Integer overflow";
+          return false;
+        }
+        if (operand.type == Value::INT)
+          dst = Value::of_int(-operand.i);
+        else if (operand.type == Value::FLOAT)
+          dst = Value::of_float(-operand.f);
+        else
+        {
+          message = "Unsupported operand";
+          return false;
+        }
+        break;
+      }
+      case OP_JUMP_IF_TRUTHY:
+        if (dst.truthy())
+          pc = size_t(in.a) - 1;
+        break;
+      case OP_FORMAT:
+      {
+        std::string result;
+        program.templates.format(in.a, &registers[in.b], result);
+        dst = Value::of_string(std::move(result));
+        break;
+      }
+      case OP_CALL:
+      {
+        if (in.a >= actions.size() || !actions[in.a])
+        {
+          message = "Unbound action";
+          return false;
+        }
+        Value result = actions[in.a](in.c ? &registers[in.b] : nullptr, in.c);
+        registers[in.dst] = std::move(result);
+        break;
+      }
+      }
+    }
+    return true;
+  }
+
+}
@@ -0,0 +1,141 @@
+#ifndef TREE_SITTER_TALON_BYTECODE_H_
+#define TREE_SITTER_TALON_BYTECODE_H_
+
+#include "talon/template.h"
+#include "talon/value.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  enum Opcode : uint8_t
+  {
+    OP_LOAD_CONST, // dst = constants[a]
+    OP_LOAD_VAR,   // dst = variables[a]
+    OP_STORE_VAR,  // variables[a] = registers[b]
+    OP_ADD,        // dst = registers[a] + registers[b]
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_NEG,             // dst = -registers[a]
+    OP_JUMP_IF_TRUTHY,  // if registers[dst] is truthy, continue at code[a]
+    OP_FORMAT, // dst = templates[a] formatted with registers[b], ...
+    OP_CALL,   // dst = actions[a](registers[b], ..., registers[b + c - 1])
+  };
+
+  struct Instruction
+  {
+    Opcode op;
+    uint8_t dst;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+  };
+
+  // The longest string that repeating a string with `*` may build.
+  static const uint64_t max_string_size = 1 << 20;
+
+  // Applies OP_ADD, OP_SUB, OP_MUL, OP_DIV or OP_MOD with Python semantics.
+  // Fails on operands Python rejects, on integer results outside 64 bits and
+  // on repeated strings longer than `max_string_size`.
+  bool apply_binary(Opcode op, const Value &left, const Value &right, Value &result);
+
+  // Interns action names, so that compiled programs refer to actions by id.
+  // The `key()` and `sleep()` actions are always interned as KEY and SLEEP.
+  class ActionTable
+  {
+  public:
+    static constexpr uint32_t KEY = 0;
+    static constexpr uint32_t SLEEP = 1;
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    ActionTable();
+
+    uint32_t intern(std::string_view name);
+    uint32_t find(std::string_view name) const;
+    const std::string &name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+  private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+  };
+
+  // The compiled form of a single command body.
+  struct Program
+  {
+    // Returns the slot of a variable, e.g., of a capture that the caller
+    // wants to set before running the program, or npos.
+    uint32_t variable_slot(std::string_view name) const;
+
+    // Appends a canonical encoding, equal for programs that behave alike when
+    // compiled against the same ActionTable.
+    void encode(std::string &out) const;
+    // The bytes the program holds, including itself.
+    size_t memory_size() const;
+
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    TemplateSet templates;
+    std::vector<std::string> variables;
+    uint32_t register_count = 0;
+  };
+
+  // Compiles a `block` of statements into a register program.
+  //
+  // Every expression is evaluated into the lowest free register, so a
+  // statement never needs more registers than the depth of its expression.
+  class Compiler
+  {
+  public:
+    explicit Compiler(ActionTable &actions) : actions(actions) {}
+
+    bool compile(TSNode block, std::string_view source, Program &out);
+    const std::string &error() const { return message; }
+
+  private:
+    bool statement(TSNode node);
+    bool expression(TSNode node, uint32_t dst);
+    bool string(TSNode node, uint32_t dst);
+    bool call(uint32_t action, uint32_t dst, uint32_t argc);
+    bool emit(Opcode op, uint32_t dst, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    uint32_t constant(Value value);
+    uint32_t variable(std::string_view name);
+    bool fail(TSNode node, const char *what);
+
+    ActionTable &actions;
+    std::string_view source;
+    Program *program = nullptr;
+    std::string message;
+  };
+
+  // Runs compiled programs. Actions are bound by id; running a program that
+  // calls an unbound action fails.
+  class VM
+  {
+  public:
+    using Action = std::function<Value(const Value *args, uint32_t argc)>;
+
+    void bind(uint32_t action, Action fn);
+
+    // `variables` must hold one value per program variable; assignments are
+    // written back to it.
+    bool run(const Program &program, Value *variables);
+    const std::string &error() const { return message; }
+
+  private:
+    std::vector<Action> actions;
+    std::vector<Value> registers;
+    std::string message;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_BYTECODE_H_
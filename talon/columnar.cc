@@ -0,0 +1,334 @@
+#include "talon/columnar.h"
+#include "talon/language.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    const char magic[8] = {'T', 'A', 'L', 'O', 'N', 'C', 'O', 'L'};
+    const uint32_t version = 1;
+    const uint32_t byte_order = 0x01020304;
+    // Sections start on a cache line.
+    const uint64_t alignment = 64;
+
+    enum Section
+    {
+      FILES,
+      SYMBOL_NAMES,
+      FIELD_NAMES,
+      SYMBOLS,
+      FIELDS,
+      STARTS,
+      ENDS,
+      PARENTS,
+      TEXTS,
+      TEXT_OFFSETS,
+      TEXT_BYTES,
+      SECTION_COUNT,
+    };
+
+    struct Header
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t byte_order;
+      uint32_t file_count;
+      uint32_t symbol_count;
+      // Including the 0 of nodes that are not in a field.
+      uint32_t field_count;
+      uint32_t reserved;
+      uint64_t node_count;
+      uint64_t text_count;
+      uint64_t text_byte_count;
+      // The byte offset of each section from the start of the file.
+      uint64_t sections[SECTION_COUNT];
+    };
+
+    // The size in bytes of each section of a file with these counts.
+    void section_sizes(const Header &header, uint64_t *sizes)
+    {
+      sizes[FILES] = uint64_t(header.file_count) * sizeof(ColumnarFileEntry);
+      sizes[SYMBOL_NAMES] = uint64_t(header.symbol_count) * sizeof(ColumnarSymbol);
+      sizes[FIELD_NAMES] = uint64_t(header.field_count) * sizeof(uint32_t);
+      sizes[SYMBOLS] = header.node_count * sizeof(uint16_t);
+      sizes[FIELDS] = header.node_count * sizeof(uint16_t);
+      sizes[STARTS] = header.node_count * sizeof(uint32_t);
+      sizes[ENDS] = header.node_count * sizeof(uint32_t);
+      sizes[PARENTS] = header.node_count * sizeof(uint32_t);
+      sizes[TEXTS] = header.node_count * sizeof(uint32_t);
+      sizes[TEXT_OFFSETS] = (header.text_count + 1) * sizeof(uint64_t);
+      sizes[TEXT_BYTES] = header.text_byte_count;
+    }
+
+  }
+
+  uint32_t ColumnarWriter::intern(std::string_view text)
+  {
+    auto inserted = text_ids.emplace(std::string(text), uint32_t(text_offsets.size() - 1));
+    if (inserted.second)
+    {
+      text_bytes += text;
+      text_offsets.push_back(text_bytes.size());
+    }
+    return inserted.first->second;
+  }
+
+  void ColumnarWriter::add_file(std::string_view name, TSNode root, std::string_view source)
+  {
+    ColumnarFileEntry entry;
+    entry.name = intern(name);
+    entry.first_node = uint32_t(symbols.size());
+    entry.byte_count = uint32_t(source.size());
+
+    // The indices of the ancestors of the cursor's node, below `first_node`.
+    std::vector<uint32_t> ancestors;
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    uint32_t index = 0;
+    for (bool done = false; !done; index++)
+    {
+      TSNode node = ts_tree_cursor_current_node(&cursor);
+      uint32_t start = ts_node_start_byte(node), end = ts_node_end_byte(node);
+      symbols.push_back(ts_node_symbol(node));
+      fields.push_back(ts_tree_cursor_current_field_id(&cursor));
+      starts.push_back(start);
+      ends.push_back(end);
+      parents.push_back(ancestors.empty() ? COLUMNAR_NONE : ancestors.back());
+      bool named_leaf = ts_node_is_named(node) && ts_node_child_count(node) == 0;
+      texts.push_back(named_leaf ? intern(source.substr(start, end - start)) : COLUMNAR_NONE);
+
+      if (ts_tree_cursor_goto_first_child(&cursor))
+      {
+        ancestors.push_back(index);
+        continue;
+      }
+      while (!ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        if (!ts_tree_cursor_goto_parent(&cursor))
+        {
+          done = true;
+          break;
+        }
+        ancestors.pop_back();
+      }
+    }
+    ts_tree_cursor_delete(&cursor);
+    entry.node_count = index;
+    files.push_back(entry);
+  }
+
+  bool ColumnarWriter::write(const std::string &path)
+  {
+    // The names go through the text table like any other text, so they are
+    // interned before the table is sized.
+    const TSLanguage *language = tree_sitter_talon();
+    std::vector<ColumnarSymbol> symbol_names;
+    for (uint32_t symbol = 0; symbol < ts_language_symbol_count(language); symbol++)
+    {
+      bool named = ts_language_symbol_type(language, symbol) == TSSymbolTypeRegular;
+      symbol_names.push_back({intern(ts_language_symbol_name(language, symbol)), named});
+    }
+    std::vector<uint32_t> field_names = {intern("")};
+    for (uint32_t field = 1; field <= ts_language_field_count(language); field++)
+      field_names.push_back(intern(ts_language_field_name_for_id(language, field)));
+    if (symbols.size() >= COLUMNAR_NONE || text_offsets.size() >= COLUMNAR_NONE)
+    {
+      message = "too many nodes or texts for one file";
+      return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byte_order = byte_order;
+    header.file_count = uint32_t(files.size());
+    header.symbol_count = uint32_t(symbol_names.size());
+    header.field_count = uint32_t(field_names.size());
+    header.node_count = symbols.size();
+    header.text_count = text_offsets.size() - 1;
+    header.text_byte_count = text_bytes.size();
+
+    const void *data[SECTION_COUNT];
+    data[FILES] = files.data();
+    data[SYMBOL_NAMES] = symbol_names.data();
+    data[FIELD_NAMES] = field_names.data();
+    data[SYMBOLS] = symbols.data();
+    data[FIELDS] = fields.data();
+    data[STARTS] = starts.data();
+    data[ENDS] = ends.data();
+    data[PARENTS] = parents.data();
+    data[TEXTS] = texts.data();
+    data[TEXT_OFFSETS] = text_offsets.data();
+    data[TEXT_BYTES] = text_bytes.data();
+    uint64_t sizes[SECTION_COUNT];
+    section_sizes(header, sizes);
+    uint64_t offset = sizeof(Header);
+    for (int i = 0; i < SECTION_COUNT; i++)
+    {
+      offset = (offset + alignment - 1) / alignment * alignment;
+      header.sections[i] = offset;
+      offset += sizes[i];
+    }
+
+    FILE *out = std::fopen(path.c_str(), "wb");
+    if (!out)
+    {
+      message = path + ": " + std::strerror(errno);
+      return false;
+    }
+    static const char padding[alignment] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    uint64_t written = sizeof(header);
+    for (int i = 0; i < SECTION_COUNT && ok; i++)
+    {
+      size_t gap = header.sections[i] - written;
+      ok = gap == 0 || std::fwrite(padding, gap, 1, out) == 1;
+      ok = ok && (sizes[i] == 0 || std::fwrite(data[i], sizes[i], 1, out) == 1);
+      written = header.sections[i] + sizes[i];
+    }
+    if (std::fclose(out) != 0)
+      ok = false;
+    if (!ok)
+      message = path + ": " + std::strerror(errno);
+    return ok;
+  }
+
+  ColumnarFile::~ColumnarFile() { close(); }
+
+  void ColumnarFile::close()
+  {
+    if (mapping)
+      munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    file_total = 0;
+    node_total = 0;
+    text_total = 0;
+    symbol_total = 0;
+    field_total = 0;
+  }
+
+  bool ColumnarFile::fail(const std::string &what)
+  {
+    close();
+    message = what;
+    return false;
+  }
+
+  bool ColumnarFile::open(const std::string &path)
+  {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return fail(path + ": " + std::strerror(errno));
+    struct stat status;
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(Header))
+    {
+      ::close(fd);
+      return fail(path + ": not a columnar export");
+    }
+    mapping_size = status.st_size;
+    mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+      mapping = nullptr;
+      return fail(path + ": " + std::strerror(errno));
+    }
+
+    const char *base = (const char *)mapping;
+    const Header &header = *(const Header *)base;
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+      return fail(path + ": not a columnar export");
+    if (header.version != version || header.byte_order != byte_order)
+      return fail(path + ": written by another version or on a machine of another byte order");
+    if (header.node_count >= COLUMNAR_NONE || header.text_count >= COLUMNAR_NONE)
+      return fail(path + ": corrupt header");
+    uint64_t sizes[SECTION_COUNT];
+    section_sizes(header, sizes);
+    for (int i = 0; i < SECTION_COUNT; i++)
+    {
+      uint64_t offset = header.sections[i];
+      if (offset % alignment != 0 || offset > mapping_size || mapping_size - offset < sizes[i])
+        return fail(path + ": truncated");
+    }
+
+    file_entries = (const ColumnarFileEntry *)(base + header.sections[FILES]);
+    symbol_entries = (const ColumnarSymbol *)(base + header.sections[SYMBOL_NAMES]);
+    field_entries = (const uint32_t *)(base + header.sections[FIELD_NAMES]);
+    symbol_column = (const uint16_t *)(base + header.sections[SYMBOLS]);
+    field_column = (const uint16_t *)(base + header.sections[FIELDS]);
+    start_column = (const uint32_t *)(base + header.sections[STARTS]);
+    end_column = (const uint32_t *)(base + header.sections[ENDS]);
+    parent_column = (const uint32_t *)(base + header.sections[PARENTS]);
+    text_column = (const uint32_t *)(base + header.sections[TEXTS]);
+    text_offsets = (const uint64_t *)(base + header.sections[TEXT_OFFSETS]);
+    text_bytes = base + header.sections[TEXT_BYTES];
+
+    // The tables are small next to the columns, and text() and file() rely on
+    // them, so they are checked in full.
+    if (text_offsets[0] != 0 || text_offsets[header.text_count] != header.text_byte_count)
+      return fail(path + ": corrupt text table");
+    for (uint64_t i = 0; i < header.text_count; i++)
+      if (text_offsets[i] > text_offsets[i + 1])
+        return fail(path + ": corrupt text table");
+    for (uint32_t i = 0; i < header.file_count; i++)
+    {
+      const ColumnarFileEntry &entry = file_entries[i];
+      if (entry.name >= header.text_count || uint64_t(entry.first_node) + entry.node_count > header.node_count)
+        return fail(path + ": corrupt file table");
+    }
+
+    file_total = header.file_count;
+    node_total = header.node_count;
+    text_total = header.text_count;
+    symbol_total = header.symbol_count;
+    field_total = header.field_count;
+    return true;
+  }
+
+  std::string_view ColumnarFile::text(uint32_t id) const
+  {
+    if (id >= text_total)
+      return std::string_view();
+    return std::string_view(text_bytes + text_offsets[id], text_offsets[id + 1] - text_offsets[id]);
+  }
+
+  std::string_view ColumnarFile::symbol_name(TSSymbol symbol) const
+  {
+    if (symbol < symbol_total)
+      return text(symbol_entries[symbol].name);
+    // The symbol of ERROR nodes is outside the grammar's table.
+    return symbol == TSSymbol(-1) ? "ERROR" : "";
+  }
+
+  std::string_view ColumnarFile::field_name(TSFieldId field) const
+  {
+    return field < field_total ? text(field_entries[field]) : std::string_view();
+  }
+
+  uint32_t ColumnarFile::find_symbol(std::string_view name, bool named) const
+  {
+    for (uint32_t symbol = 0; symbol < symbol_total; symbol++)
+      if (bool(symbol_entries[symbol].named) == named && text(symbol_entries[symbol].name) == name)
+        return symbol;
+    return COLUMNAR_NONE;
+  }
+
+  uint32_t ColumnarFile::find_field(std::string_view name) const
+  {
+    for (uint32_t field = 1; field < field_total; field++)
+      if (text(field_entries[field]) == name)
+        return field;
+    return COLUMNAR_NONE;
+  }
+
+}
@@ -0,0 +1,139 @@
+#ifndef TREE_SITTER_TALON_COLUMNAR_H_
+#define TREE_SITTER_TALON_COLUMNAR_H_
+
+#include <tree_sitter/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  // A columnar export of the trees of many files, for analyses that scan
+  // millions of nodes without parsing them again. The nodes of every file are
+  // stored in preorder, the files back to back, and each attribute of a node
+  // is a column of its own: symbol, field, start byte, end byte, parent and
+  // text. A scan that needs two attributes reads two arrays and nothing else.
+  //
+  // The file is written in the byte order of the machine and read in place
+  // through mmap. It carries the names of the symbols and fields it uses, so
+  // that it can be read without the grammar it was written with.
+  static const uint32_t COLUMNAR_NONE = UINT32_MAX;
+
+  struct ColumnarFileEntry
+  {
+    // The text id of the file name.
+    uint32_t name;
+    // The index of the root node in the columns, and the number of nodes.
+    // Parents are indices below `first_node`.
+    uint32_t first_node;
+    uint32_t node_count;
+    uint32_t byte_count;
+  };
+
+  struct ColumnarSymbol
+  {
+    uint32_t name;
+    uint32_t named;
+  };
+
+  class ColumnarWriter
+  {
+  public:
+    // Appends the nodes below `root`, a tree of `source`. Named leaves, e.g.,
+    // identifiers, words and string contents, get the id of their text;
+    // anonymous tokens and inner nodes get COLUMNAR_NONE.
+    void add_file(std::string_view name, TSNode root, std::string_view source);
+
+    bool write(const std::string &path);
+    const std::string &error() const { return message; }
+
+    size_t node_count() const { return symbols.size(); }
+
+  private:
+    uint32_t intern(std::string_view text);
+
+    std::vector<ColumnarFileEntry> files;
+    std::vector<uint16_t> symbols;
+    std::vector<uint16_t> fields;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> ends;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> texts;
+    std::unordered_map<std::string, uint32_t> text_ids;
+    std::vector<uint64_t> text_offsets = {0};
+    std::string text_bytes;
+    std::string message;
+  };
+
+  // A file written by ColumnarWriter, mapped into memory. The columns point
+  // into the mapping and live as long as the ColumnarFile.
+  class ColumnarFile
+  {
+  public:
+    ColumnarFile() = default;
+    ~ColumnarFile();
+    ColumnarFile(const ColumnarFile &) = delete;
+    ColumnarFile &operator=(const ColumnarFile &) = delete;
+
+    // Maps `path` and checks that every section lies within it. The values in
+    // the node columns are not checked.
+    bool open(const std::string &path);
+    const std::string &error() const { return message; }
+
+    uint32_t file_count() const { return file_total; }
+    const ColumnarFileEntry &file(uint32_t i) const { return file_entries[i]; }
+    std::string_view file_name(uint32_t i) const { return text(file_entries[i].name); }
+
+    size_t node_count() const { return node_total; }
+    const uint16_t *symbols() const { return symbol_column; }
+    // 0 for nodes that are not in a field.
+    const uint16_t *fields() const { return field_column; }
+    const uint32_t *start_bytes() const { return start_column; }
+    const uint32_t *end_bytes() const { return end_column; }
+    // COLUMNAR_NONE for the root of each file.
+    const uint32_t *parents() const { return parent_column; }
+    const uint32_t *text_ids() const { return text_column; }
+
+    size_t text_count() const { return text_total; }
+    // Empty for COLUMNAR_NONE.
+    std::string_view text(uint32_t id) const;
+
+    std::string_view symbol_name(TSSymbol symbol) const;
+    std::string_view field_name(TSFieldId field) const;
+    // Returns the symbol with this name, or COLUMNAR_NONE. A grammar may use
+    // a name for both a named node and an anonymous token.
+    uint32_t find_symbol(std::string_view name, bool named = true) const;
+    uint32_t find_field(std::string_view name) const;
+
+  private:
+    void close();
+    bool fail(const std::string &what);
+
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    uint32_t file_total = 0;
+    size_t node_total = 0;
+    size_t text_total = 0;
+    uint32_t symbol_total = 0;
+    uint32_t field_total = 0;
+    const ColumnarFileEntry *file_entries = nullptr;
+    const ColumnarSymbol *symbol_entries = nullptr;
+    const uint32_t *field_entries = nullptr;
+    const uint16_t *symbol_column = nullptr;
+    const uint16_t *field_column = nullptr;
+    const uint32_t *start_column = nullptr;
+    const uint32_t *end_column = nullptr;
+    const uint32_t *parent_column = nullptr;
+    const uint32_t *text_column = nullptr;
+    const uint64_t *text_offsets = nullptr;
+    const char *text_bytes = nullptr;
+    std::string message;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_COLUMNAR_H_
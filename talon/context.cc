@@ -0,0 +1,47 @@
+#include "talon/context.h"
+#include "talon/language.h"
+
+namespace talon
+{
+
+  std::vector<Match> read_matches(TSNode root, std::string_view source)
+  {
+    const Symbols &s = symbols();
+    std::vector<Match> result;
+
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode matches = ts_node_named_child(root, i);
+      if (ts_node_symbol(matches) != s.matches)
+        continue;
+
+      uint32_t match_count = ts_node_named_child_count(matches);
+      for (uint32_t j = 0; j < match_count; j++)
+      {
+        TSNode node = ts_node_named_child(matches, j);
+        if (ts_node_symbol(node) != s.match)
+          continue;
+
+        Match match;
+        uint32_t child_count = ts_node_named_child_count(node);
+        for (uint32_t k = 0; k < child_count; k++)
+        {
+          TSNode child = ts_node_named_child(node, k);
+          if (ts_node_symbol(child) != s.match_modifier)
+            break;
+          if (node_text(source, child) == "not")
+            match.negated = true;
+          else
+            match.conjunctive = true;
+        }
+        match.left = node_text(source, ts_node_child_by_field_id(node, s.left));
+        match.right = node_text(source, ts_node_child_by_field_id(node, s.right));
+        result.push_back(std::move(match));
+      }
+      break;
+    }
+    return result;
+  }
+
+}
@@ -0,0 +1,28 @@
+#ifndef TREE_SITTER_TALON_CONTEXT_H_
+#define TREE_SITTER_TALON_CONTEXT_H_
+
+#include <tree_sitter/api.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  // A single `match` line from the header of a talon file, e.g.,
+  // `and not tag: user.terminal`.
+  struct Match
+  {
+    bool conjunctive = false;
+    bool negated = false;
+    std::string left;
+    std::string right;
+  };
+
+  // Reads the `match` lines of the `matches` header below `root`, which must be
+  // the `source_file` node. Files without a header yield an empty list.
+  std::vector<Match> read_matches(TSNode root, std::string_view source);
+
+}
+
+#endif // TREE_SITTER_TALON_CONTEXT_H_
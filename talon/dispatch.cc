@@ -0,0 +1,304 @@
+#include "talon/dispatch.h"
+#include "talon/language.h"
+#include "talon/util.h"
+#include <algorithm>
+#include <cctype>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    // The seeds a bucket tries before the table is rebuilt with more room,
+    // and the number of rebuilds before unplaced keys are kept aside.
+    const uint32_t max_seed = 1 << 16;
+    const int max_rebuilds = 3;
+
+    std::string_view canonical_modifier(std::string_view modifier)
+    {
+      if (modifier == "control")
+        return "ctrl";
+      if (modifier == "command" || modifier == "super")
+        return "cmd";
+      if (modifier == "option")
+        return "alt";
+      return modifier;
+    }
+
+    int modifier_rank(std::string_view modifier)
+    {
+      static const std::string_view order[] = {"cmd", "ctrl", "alt", "shift"};
+      for (int i = 0; i < 4; i++)
+        if (modifier == order[i])
+          return i;
+      return 4;
+    }
+
+    std::string normalize_chord(std::string_view chord)
+    {
+      // Split off a trailing ":up" or ":down" before splitting on dashes.
+      std::string_view suffix;
+      size_t colon = chord.rfind(':');
+      if (colon != std::string_view::npos && colon > 0)
+      {
+        suffix = chord.substr(colon);
+        chord = chord.substr(0, colon);
+      }
+
+      std::vector<std::string_view> parts;
+      size_t start = 0;
+      while (start <= chord.size())
+      {
+        size_t dash = chord.find('-', start);
+        if (dash == std::string_view::npos)
+          dash = chord.size();
+        if (dash == start && dash < chord.size())
+        { // A dash as the key itself, e.g., "ctrl--".
+          parts.push_back(chord.substr(dash, 1));
+          start = dash + 2;
+          continue;
+        }
+        parts.push_back(chord.substr(start, dash - start));
+        start = dash + 1;
+      }
+      if (parts.empty())
+        return std::string(suffix);
+
+      std::string_view key = parts.back();
+      parts.pop_back();
+      for (std::string_view &modifier : parts)
+        modifier = canonical_modifier(modifier);
+      std::stable_sort(parts.begin(), parts.end(),
+                       [](std::string_view a, std::string_view b)
+                       {
+                         int ra = modifier_rank(a), rb = modifier_rank(b);
+                         return ra != rb ? ra < rb : a < b;
+                       });
+      parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+
+      std::string result;
+      for (std::string_view modifier : parts)
+      {
+        result += modifier;
+        result += '-';
+      }
+      result += key;
+      result += suffix;
+      return result;
+    }
+
+  }
+
+  std::string normalize_event(EventKind kind, std::string_view event)
+  {
+    // Whitespace separates the keys of a sequence, e.g., "ctrl-a b", so each
+    // run of it becomes one space rather than being dropped.
+    std::string result;
+    result.reserve(event.size());
+    size_t start = 0;
+    while (start < event.size())
+    {
+      if (std::isspace((unsigned char)event[start]))
+      {
+        start++;
+        continue;
+      }
+      size_t end = start;
+      while (end < event.size() && !std::isspace((unsigned char)event[end]))
+        end++;
+      std::string word(event.substr(start, end - start));
+      for (char &c : word)
+        c = char(std::tolower((unsigned char)c));
+      if (!result.empty())
+        result += ' ';
+      result += kind == KEY_EVENT ? normalize_chord(word) : word;
+      start = end;
+    }
+    return result;
+  }
+
+  void extract_bindings(TSNode root, std::string_view source, uint32_t file, std::vector<Binding> &out)
+  {
+    const Symbols &s = symbols();
+
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode declarations = ts_node_named_child(root, i);
+      if (ts_node_symbol(declarations) != s.declarations)
+        continue;
+
+      uint32_t declaration_count = ts_node_named_child_count(declarations);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(declarations, j);
+        TSSymbol symbol = ts_node_symbol(declaration);
+
+        EventKind kind;
+        if (symbol == s.key_binding_declaration)
+          kind = KEY_EVENT;
+        else if (symbol == s.noise_declaration)
+          kind = NOISE_EVENT;
+        else if (symbol == s.parrot_declaration)
+          kind = PARROT_EVENT;
+        else if (symbol == s.face_declaration)
+          kind = FACE_EVENT;
+        else if (symbol == s.gamepad_declaration)
+          kind = GAMEPAD_EVENT;
+        else
+          continue;
+
+        TSNode binding = ts_node_child_by_field_id(declaration, s.left);
+        TSNode argument = ts_node_child_by_field_id(binding, s.arguments);
+        std::string_view event = ts_node_is_null(argument) ? std::string_view() : node_text(source, argument);
+        out.push_back(Binding{
+            kind,
+            normalize_event(kind, event),
+            file,
+            ts_node_start_byte(declaration),
+            ts_node_end_byte(declaration),
+        });
+      }
+    }
+  }
+
+  void DispatchTable::build(std::vector<Binding> input)
+  {
+    // Group the bindings by event, keeping declaration order within a group.
+    std::stable_sort(input.begin(), input.end(),
+                     [](const Binding &a, const Binding &b)
+                     { return a.event < b.event; });
+
+    keys.clear();
+    key_offsets.assign(1, 0);
+    binding_offsets.assign(1, 0);
+    bindings = std::move(input);
+    for (size_t i = 0; i < bindings.size(); i++)
+    {
+      if (i > 0 && bindings[i].event == bindings[i - 1].event)
+      {
+        binding_offsets.back() = i + 1;
+        continue;
+      }
+      keys += bindings[i].event;
+      key_offsets.push_back(keys.size());
+      binding_offsets.push_back(i + 1);
+    }
+    key_count = key_offsets.size() - 1;
+
+    std::vector<uint64_t> hashes(key_count);
+    for (uint32_t k = 0; k < key_count; k++)
+      hashes[k] = hash_bytes(key(k));
+    size_t bucket_count = std::max<size_t>(1, key_count / 4);
+    size_t slot_count = std::max<size_t>(1, key_count + key_count / 8);
+    for (int rebuild = 0; !place(hashes, bucket_count, slot_count) && rebuild < max_rebuilds; rebuild++)
+    {
+      bucket_count *= 2;
+      slot_count *= 2;
+    }
+  }
+
+  std::string_view DispatchTable::key(uint32_t k) const
+  {
+    return std::string_view(keys).substr(key_offsets[k], key_offsets[k + 1] - key_offsets[k]);
+  }
+
+  // Places every bucket, or keeps its keys in `overflow` if no seed up to
+  // max_seed fits them, and returns whether all were placed.
+  bool DispatchTable::place(const std::vector<uint64_t> &hashes, size_t bucket_count, size_t slot_count)
+  {
+    seeds.assign(bucket_count, 0);
+    slots.assign(slot_count, UINT32_MAX);
+    overflow.clear();
+
+    std::vector<std::vector<uint32_t>> buckets(bucket_count);
+    for (uint32_t k = 0; k < key_count; k++)
+      buckets[mix(hashes[k], 0) % bucket_count].push_back(k);
+
+    // Place the largest buckets first, while most slots are still free.
+    std::vector<uint32_t> order(bucket_count);
+    for (uint32_t b = 0; b < bucket_count; b++)
+      order[b] = b;
+    std::sort(order.begin(), order.end(),
+              [&buckets](uint32_t a, uint32_t b)
+              { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<uint32_t> placed;
+    for (uint32_t b : order)
+    {
+      if (buckets[b].empty())
+        break;
+      // Seed 0 marks a bucket without keys in the table.
+      for (uint32_t seed = 1; seed <= max_seed && seeds[b] == 0; seed++)
+      {
+        placed.clear();
+        bool fits = true;
+        for (uint32_t k : buckets[b])
+        {
+          uint32_t slot = mix(hashes[k], seed) % slot_count;
+          if (slots[slot] != UINT32_MAX ||
+              std::find(placed.begin(), placed.end(), slot) != placed.end())
+          {
+            fits = false;
+            break;
+          }
+          placed.push_back(slot);
+        }
+        if (!fits)
+          continue;
+        for (size_t i = 0; i < placed.size(); i++)
+          slots[placed[i]] = buckets[b][i];
+        seeds[b] = seed;
+      }
+      if (seeds[b] == 0)
+        overflow.insert(overflow.end(), buckets[b].begin(), buckets[b].end());
+    }
+    // Keys are numbered in sorted order.
+    std::sort(overflow.begin(), overflow.end());
+    return overflow.empty();
+  }
+
+  std::pair<const Binding *, const Binding *> DispatchTable::lookup(std::string_view event) const
+  {
+    if (key_count == 0)
+      return {nullptr, nullptr};
+
+    uint64_t hash = hash_bytes(event);
+    uint32_t seed = seeds[mix(hash, 0) % seeds.size()];
+    uint32_t k = seed == 0 ? UINT32_MAX : slots[mix(hash, seed) % slots.size()];
+    if (k == UINT32_MAX || key(k) != event)
+    {
+      auto it = std::lower_bound(overflow.begin(), overflow.end(), event,
+                                 [this](uint32_t k, std::string_view event)
+                                 { return key(k) < event; });
+      if (it == overflow.end() || key(*it) != event)
+        return {nullptr, nullptr};
+      k = *it;
+    }
+    return {bindings.data() + binding_offsets[k], bindings.data() + binding_offsets[k + 1]};
+  }
+
+  uint32_t DispatchIndex::add_file(TSNode root, std::string_view source)
+  {
+    uint32_t file = contexts.size();
+    contexts.push_back(read_matches(root, source));
+    extract_bindings(root, source, file, bindings);
+    return file;
+  }
+
+  void DispatchIndex::build()
+  {
+    std::vector<Binding> by_kind[EVENT_KIND_COUNT];
+    for (const Binding &binding : bindings)
+      by_kind[binding.kind].push_back(binding);
+    for (int kind = 0; kind < EVENT_KIND_COUNT; kind++)
+      tables[kind].build(std::move(by_kind[kind]));
+  }
+
+  std::pair<const Binding *, const Binding *> DispatchIndex::lookup(EventKind kind, std::string_view event) const
+  {
+    return tables[kind].lookup(normalize_event(kind, event));
+  }
+
+}
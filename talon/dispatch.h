@@ -0,0 +1,102 @@
+#ifndef TREE_SITTER_TALON_DISPATCH_H_
+#define TREE_SITTER_TALON_DISPATCH_H_
+
+#include "talon/context.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  // The trigger events that can be bound at the top level of a talon file.
+  enum EventKind
+  {
+    KEY_EVENT,
+    NOISE_EVENT,
+    PARROT_EVENT,
+    FACE_EVENT,
+    GAMEPAD_EVENT,
+    EVENT_KIND_COUNT,
+  };
+
+  // A `key()`, `noise()`, `parrot()`, `face()` or `gamepad()` declaration.
+  struct Binding
+  {
+    EventKind kind;
+    std::string event;
+    uint32_t file;
+    uint32_t start_byte;
+    uint32_t end_byte;
+  };
+
+  // Normalizes the implicit string argument of a binding, so that equivalent
+  // spellings share a key: runs of whitespace become one space and are trimmed,
+  // ASCII is lowercased and, for the key chords of a sequence, modifiers are
+  // renamed and sorted, e.g., "Shift-Control-a  b" and "ctrl-shift-a b" both
+  // become "ctrl-shift-a b". "ctrl a" stays apart from "ctrl-a" and "ctrla".
+  std::string normalize_event(EventKind kind, std::string_view event);
+
+  // Appends the bindings declared below `root`, which must be the
+  // `source_file` node, with their events normalized.
+  void extract_bindings(TSNode root, std::string_view source, uint32_t file, std::vector<Binding> &out);
+
+  // A static perfect hash table from normalized event to the bindings for it.
+  //
+  // Keys are placed with hash-and-displace: every key hashes to a bucket, and
+  // each bucket stores the seed for which its keys land in free slots. A lookup
+  // hashes the key once, reads one seed and compares one key. If a bucket finds
+  // no seed, the table is rebuilt with twice the room, and the keys that still
+  // find none, such as keys with equal hashes, are kept in a sorted list that
+  // lookups search after a miss.
+  class DispatchTable
+  {
+  public:
+    void build(std::vector<Binding> bindings);
+
+    // Returns the bindings for an already normalized event, or an empty range.
+    std::pair<const Binding *, const Binding *> lookup(std::string_view event) const;
+
+    size_t size() const { return key_count; }
+
+  private:
+    std::string_view key(uint32_t k) const;
+    bool place(const std::vector<uint64_t> &hashes, size_t bucket_count, size_t slot_count);
+
+    std::vector<uint32_t> seeds;
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> overflow;
+    std::vector<uint32_t> key_offsets;
+    std::string keys;
+    std::vector<uint32_t> binding_offsets;
+    std::vector<Binding> bindings;
+    size_t key_count = 0;
+  };
+
+  // Dispatch tables for every event kind of a workspace, plus the headers of
+  // the files that the bindings come from.
+  class DispatchIndex
+  {
+  public:
+    // Adds a parsed file and returns its id. Call build() afterwards to make
+    // its bindings visible to lookup().
+    uint32_t add_file(TSNode root, std::string_view source);
+    void build();
+
+    // Normalizes `event` and looks it up in the table for `kind`.
+    std::pair<const Binding *, const Binding *> lookup(EventKind kind, std::string_view event) const;
+
+    const std::vector<Match> &context(uint32_t file) const { return contexts[file]; }
+    const DispatchTable &table(EventKind kind) const { return tables[kind]; }
+
+  private:
+    std::vector<std::vector<Match>> contexts;
+    std::vector<Binding> bindings;
+    DispatchTable tables[EVENT_KIND_COUNT];
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_DISPATCH_H_
@@ -0,0 +1,231 @@
+#include "talon/escape.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TALON_ESCAPE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define TALON_ESCAPE_NEON 1
+#endif
+
+namespace talon
+{
+
+  namespace
+  {
+
+    inline int hex_digit(char c)
+    {
+      if (c >= '0' && c <= '9')
+        return c - '0';
+      c |= 0x20;
+      return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    }
+
+    inline char *put_utf8(char *out, uint32_t code)
+    {
+      if (code < 0x80)
+      {
+        *out++ = char(code);
+      }
+      else if (code < 0x800)
+      {
+        *out++ = char(0xc0 | (code >> 6));
+        *out++ = char(0x80 | (code & 0x3f));
+      }
+      else if (code < 0x10000)
+      {
+        *out++ = char(0xe0 | (code >> 12));
+        *out++ = char(0x80 | ((code >> 6) & 0x3f));
+        *out++ = char(0x80 | (code & 0x3f));
+      }
+      else
+      {
+        *out++ = char(0xf0 | ((code >> 18) & 0x07));
+        *out++ = char(0x80 | ((code >> 12) & 0x3f));
+        *out++ = char(0x80 | ((code >> 6) & 0x3f));
+        *out++ = char(0x80 | (code & 0x3f));
+      }
+      return out;
+    }
+
+    inline bool read_hex(const char *p, const char *end, int digits, uint32_t &code)
+    {
+      if (end - p < digits)
+        return false;
+      code = 0;
+      for (int i = 0; i < digits; i++)
+      {
+        int value = hex_digit(p[i]);
+        if (value < 0)
+          return false;
+        code = code * 16 + value;
+      }
+      return true;
+    }
+
+    // Decodes the escape sequence at `p`, which points at a backslash, and
+    // advances both pointers past it.
+    inline void decode_one(const char *&p, const char *end, char *&out)
+    {
+      const char *next = p + 1;
+      if (next == end)
+      {
+        *out++ = *p++;
+        return;
+      }
+
+      uint32_t code;
+      switch (*next)
+      {
+      case 'a':
+        *out++ = '\a';
+        break;
+      case 'b':
+        *out++ = '\b';
+        break;
+      case 'f':
+        *out++ = '\f';
+        break;
+      case 'n':
+        *out++ = '\n';
+        break;
+      case 'r':
+        *out++ = '\r';
+        break;
+      case 't':
+        *out++ = '\t';
+        break;
+      case 'v':
+        *out++ = '\v';
+        break;
+      case '\n':
+        // a line continuation
+        break;
+      case '\r':
+        if (end - next > 1 && next[1] == '\n')
+        { // a line continuation
+          p += 3;
+          return;
+        }
+        *out++ = *p++;
+        return;
+      case '\\':
+      case '\'':
+      case '"':
+        *out++ = *next;
+        break;
+      case 'x':
+      case 'u':
+      case 'U':
+      {
+        int digits = *next == 'x' ? 2 : *next == 'u' ? 4
+                                                     : 8;
+        if (!read_hex(next + 1, end, digits, code) || code > 0x10ffff)
+        {
+          *out++ = *p++;
+          return;
+        }
+        out = put_utf8(out, code);
+        p = next + 1 + digits;
+        return;
+      }
+      default:
+        // The grammar accepts any three decimal digits, but only octal digits
+        // form an escape, as in Python.
+        if (end - next >= 3 && next[0] >= '0' && next[0] <= '7' &&
+            next[1] >= '0' && next[1] <= '7' && next[2] >= '0' && next[2] <= '7')
+        {
+          out = put_utf8(out, (next[0] - '0') * 64 + (next[1] - '0') * 8 + (next[2] - '0'));
+          p = next + 3;
+          return;
+        }
+        *out++ = *p++;
+        return;
+      }
+      p = next + 1;
+    }
+
+  }
+
+  size_t decode_escapes_scalar(const char *in, size_t length, char *out)
+  {
+    const char *p = in;
+    const char *end = in + length;
+    char *start = out;
+    while (p < end)
+    {
+      if (*p == '\\')
+        decode_one(p, end, out);
+      else
+        *out++ = *p++;
+    }
+    return out - start;
+  }
+
+  size_t decode_escapes(const char *in, size_t length, char *out)
+  {
+    const char *p = in;
+    const char *end = in + length;
+    char *start = out;
+
+#if defined(TALON_ESCAPE_SSE2) || defined(TALON_ESCAPE_NEON)
+#if defined(TALON_ESCAPE_SSE2)
+    const __m128i backslash = _mm_set1_epi8('\\');
+#else
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+#endif
+    // The output never runs ahead of the input, so writing a full block at
+    // `out` stays within the `length` bytes the caller provided.
+    while (end - p >= 16)
+    {
+#if defined(TALON_ESCAPE_SSE2)
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), block);
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, backslash));
+      if (mask == 0)
+      {
+        p += 16;
+        out += 16;
+        continue;
+      }
+      unsigned offset = __builtin_ctz(mask);
+#else
+      uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+      vst1q_u8(reinterpret_cast<uint8_t *>(out), block);
+      uint8x16_t matches = vceqq_u8(block, backslash);
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+      if (mask == 0)
+      {
+        p += 16;
+        out += 16;
+        continue;
+      }
+      unsigned offset = __builtin_ctzll(mask) / 4;
+#endif
+      p += offset;
+      out += offset;
+      decode_one(p, end, out);
+    }
+#endif
+
+    while (p < end)
+    {
+      const char *slash = static_cast<const char *>(std::memchr(p, '\\', end - p));
+      if (!slash)
+      {
+        std::memcpy(out, p, end - p);
+        out += end - p;
+        break;
+      }
+      std::memcpy(out, p, slash - p);
+      out += slash - p;
+      p = slash;
+      decode_one(p, end, out);
+    }
+    return out - start;
+  }
+
+}
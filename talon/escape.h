@@ -0,0 +1,27 @@
+#ifndef TREE_SITTER_TALON_ESCAPE_H_
+#define TREE_SITTER_TALON_ESCAPE_H_
+
+#include <cstddef>
+
+namespace talon
+{
+
+  // Decodes the `string_escape_sequence`s in the text of a string, i.e.,
+  // `\uXXXX`, `\UXXXXXXXX`, `\xXX`, octal `\ddd`, line continuations and the
+  // single-character escapes, writing UTF-8 to `out`. A backslash that does not
+  // start an escape sequence is copied as is, as the grammar parses it as
+  // `string_content`.
+  //
+  // Decoding never makes the text longer, so `out` must have room for
+  // `length` bytes. Nothing is allocated. Returns the decoded length.
+  //
+  // Runs of bytes without a backslash are copied 16 bytes at a time with SSE2
+  // or NEON where available.
+  size_t decode_escapes(const char *in, size_t length, char *out);
+
+  // The byte-at-a-time version of decode_escapes, for testing and comparison.
+  size_t decode_escapes_scalar(const char *in, size_t length, char *out);
+
+}
+
+#endif // TREE_SITTER_TALON_ESCAPE_H_
@@ -0,0 +1,128 @@
+#include "talon/hash.h"
+#include "talon/language.h"
+#include "talon/util.h"
+
+namespace talon
+{
+
+  // Walks the subtree with a cursor rather than by recursion, as expressions
+  // and rules can nest deeply, and keeps the unfinished hash of every open
+  // ancestor on a stack.
+  uint64_t structural_hash(TSNode node, std::string_view source)
+  {
+    const Symbols &s = symbols();
+    std::vector<uint64_t> open;
+    uint64_t result = 0;
+    auto finish = [&](uint64_t hash)
+    {
+      if (open.empty())
+        result = hash;
+      else
+        open.back() = mix(open.back(), hash);
+    };
+
+    TSTreeCursor cursor = ts_tree_cursor_new(node);
+    for (;;)
+    {
+      TSNode current = ts_tree_cursor_current_node(&cursor);
+      if (ts_node_symbol(current) != s.comment)
+      {
+        uint64_t hash = mix(ts_node_symbol(current), 1);
+        if (ts_tree_cursor_goto_first_child(&cursor))
+        {
+          open.push_back(hash);
+          continue;
+        }
+        // Anonymous tokens always have the same text.
+        if (ts_node_is_named(current))
+          hash = mix(hash, hash_bytes(node_text(source, current)));
+        finish(hash);
+      }
+      while (!open.empty() && !ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        ts_tree_cursor_goto_parent(&cursor);
+        uint64_t hash = open.back();
+        open.pop_back();
+        finish(hash);
+      }
+      if (open.empty())
+        break;
+    }
+    ts_tree_cursor_delete(&cursor);
+    return result;
+  }
+
+  void DeclarationHashes::update(const TSTree *tree, std::string_view source)
+  {
+    const Symbols &s = symbols();
+    std::unordered_map<const void *, uint64_t> previous_ids;
+    previous_ids.swap(by_id);
+    // The previous hashes, with their multiplicity, to tell which are gone.
+    std::unordered_map<uint64_t, uint32_t> previous;
+    for (const Declaration &declaration : current)
+      previous[declaration.hash]++;
+    current.clear();
+    rehashed = 0;
+
+    auto hash_of = [&](TSNode node)
+    {
+      auto it = previous_ids.find(node.id);
+      uint64_t hash;
+      if (it != previous_ids.end())
+      {
+        hash = it->second;
+      }
+      else
+      {
+        hash = structural_hash(node, source);
+        rehashed++;
+      }
+      by_id[node.id] = hash;
+      return hash;
+    };
+
+    header = 0;
+    TSNode root = ts_tree_root_node(tree);
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      TSSymbol symbol = ts_node_symbol(child);
+      if (symbol == s.matches)
+      {
+        header = hash_of(child);
+        continue;
+      }
+      if (symbol == s.comment)
+        continue;
+      // A top-level ERROR is compared as a declaration.
+      if (symbol != s.declarations)
+      {
+        current.push_back({child, hash_of(child), false});
+        continue;
+      }
+      uint32_t declaration_count = ts_node_named_child_count(child);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(child, j);
+        if (ts_node_symbol(declaration) != s.comment)
+          current.push_back({declaration, hash_of(declaration), false});
+      }
+    }
+
+    root_hash = mix(header, current.size());
+    for (Declaration &declaration : current)
+    {
+      root_hash = mix(root_hash, declaration.hash);
+      auto it = previous.find(declaration.hash);
+      if (it == previous.end() || it->second == 0)
+        declaration.changed = true;
+      else
+        it->second--;
+    }
+    gone.clear();
+    for (const auto &entry : previous)
+      gone.insert(gone.end(), entry.second, entry.first);
+  }
+
+}
@@ -0,0 +1,63 @@
+#ifndef TREE_SITTER_TALON_HASH_H_
+#define TREE_SITTER_TALON_HASH_H_
+
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  // Hashes the subtree below `node` bottom-up from the symbols of its nodes
+  // and the text of its named tokens. Comments are skipped, and whitespace,
+  // indentation and line continuations are not in the tree, so two subtrees
+  // hash alike when they differ only in layout. E.g., `foo: key(a)` and a
+  // `foo:` whose indented body is `key(a)` hash alike.
+  uint64_t structural_hash(TSNode node, std::string_view source);
+
+  // The structural hashes of the header and the declarations of a file, and
+  // their Merkle root, kept up to date across incremental parses.
+  //
+  // A declaration that tree-sitter reused from the previous tree keeps its
+  // hash, so an update hashes only the declarations that an edit touched.
+  // Reuse is recognized by node id, so the previous tree must not be deleted
+  // before update() is called with its successor.
+  class DeclarationHashes
+  {
+  public:
+    struct Declaration
+    {
+      TSNode node;
+      uint64_t hash;
+      // Whether no declaration of the previous version had the same hash,
+      // i.e., whether the declaration is new or changed in substance.
+      bool changed;
+    };
+
+    // Hashes the tree of `source`, usually an incremental reparse of the tree
+    // passed to the previous call.
+    void update(const TSTree *tree, std::string_view source);
+
+    uint64_t header_hash() const { return header; }
+    const std::vector<Declaration> &declarations() const { return current; }
+    // The hashes of the previous version that are gone, one per declaration.
+    const std::vector<uint64_t> &removed() const { return gone; }
+    // The Merkle root over the header and the declarations in order.
+    uint64_t root() const { return root_hash; }
+    // How many subtrees the last update() had to hash.
+    size_t rehashed_count() const { return rehashed; }
+
+  private:
+    std::vector<Declaration> current;
+    std::vector<uint64_t> gone;
+    std::unordered_map<const void *, uint64_t> by_id;
+    uint64_t header = 0;
+    uint64_t root_hash = 0;
+    size_t rehashed = 0;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_HASH_H_
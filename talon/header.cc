@@ -0,0 +1,167 @@
+#include "talon/header.h"
+
+// Kept to C++11, like src/scanner.cc, since the bindings compile it with their
+// own default flags.
+
+namespace
+{
+
+  bool is_space(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  bool is_identifier_start(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  }
+
+  bool is_identifier_char(char c)
+  {
+    return is_identifier_start(c) || (c >= '0' && c <= '9');
+  }
+
+  // Reads `word` followed by whitespace at `i`.
+  bool read_keyword(const char *line, uint32_t &i, uint32_t end, const char *word, uint32_t length)
+  {
+    if (end - i <= length)
+      return false;
+    for (uint32_t k = 0; k < length; k++)
+      if (line[i + k] != word[k])
+        return false;
+    if (!is_space(line[i + length]))
+      return false;
+    i += length;
+    while (i < end && is_space(line[i]))
+      i++;
+    return true;
+  }
+
+  // Parses the line [start, end) as a `match`, per the grammar:
+  // `match_modifier* identifier ":" implicit_string`.
+  bool read_match(const char *source, uint32_t start, uint32_t end, TalonMatch &match)
+  {
+    match.conjunctive = false;
+    match.negated = false;
+    uint32_t i = start;
+    for (;;)
+    {
+      if (read_keyword(source, i, end, "and", 3))
+        match.conjunctive = true;
+      else if (read_keyword(source, i, end, "not", 3))
+        match.negated = true;
+      else
+        break;
+    }
+
+    // identifier: ([A-Za-z_][A-Za-z0-9_]*)(\.[A-Za-z_][A-Za-z0-9_]*)*
+    match.left_start = i;
+    for (;;)
+    {
+      if (i >= end || !is_identifier_start(source[i]))
+        return false;
+      while (i < end && is_identifier_char(source[i]))
+        i++;
+      if (i + 1 < end && source[i] == '.' && is_identifier_start(source[i + 1]))
+        i++;
+      else
+        break;
+    }
+    match.left_end = i;
+
+    while (i < end && is_space(source[i]))
+      i++;
+    if (i >= end || source[i] != ':')
+      return false;
+    i++;
+
+    // implicit_string: (\S|\S.*\S)
+    while (i < end && is_space(source[i]))
+      i++;
+    uint32_t right_end = end;
+    while (right_end > i && is_space(source[right_end - 1]))
+      right_end--;
+    if (right_end == i)
+      return false;
+    match.right_start = i;
+    match.right_end = right_end;
+    return true;
+  }
+
+}
+
+extern "C" bool talon_is_separator(const char *line, uint32_t length)
+{
+  uint32_t i = 0;
+  while (i < length && line[i] == '-')
+    i++;
+  if (i == 0)
+    return false;
+  // Unlike is_space, the scanner does not count a vertical tab.
+  while (i < length && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r' || line[i] == '\f'))
+    i++;
+  return i == length;
+}
+
+extern "C" TalonHeaderStatus talon_scan_header(
+  const char *source,
+  uint32_t length,
+  bool at_end,
+  TalonMatch *matches,
+  uint32_t capacity,
+  TalonHeader *header)
+{
+  header->end_byte = 0;
+  header->match_count = 0;
+
+  uint32_t start = 0;
+  // Skip a byte order mark.
+  if (length >= 3 && source[0] == '\xef' && source[1] == '\xbb' && source[2] == '\xbf')
+    start = 3;
+
+  while (start < length)
+  {
+    uint32_t end = start;
+    while (end < length && end < TALON_MAX_HEADER_SIZE && source[end] != '\n')
+      end++;
+    if (end >= TALON_MAX_HEADER_SIZE)
+    {
+      header->match_count = 0;
+      return TALON_HEADER_NONE;
+    }
+    if (end == length && !at_end)
+      return TALON_HEADER_INCOMPLETE;
+    uint32_t next = end < length ? end + 1 : end;
+
+    uint32_t first = start;
+    while (first < end && is_space(source[first]))
+      first++;
+    if (first == end || source[first] == '#')
+    {
+      start = next;
+      continue;
+    }
+
+    if (talon_is_separator(source + start, end - start))
+    {
+      header->end_byte = next;
+      return TALON_HEADER_FOUND;
+    }
+
+    // Matches are never indented, but command bodies are.
+    TalonMatch match;
+    if (first > start || !read_match(source, start, end, match))
+    {
+      header->match_count = 0;
+      return TALON_HEADER_NONE;
+    }
+    if (header->match_count < capacity)
+      matches[header->match_count] = match;
+    header->match_count++;
+    start = next;
+  }
+  if (!at_end)
+    return TALON_HEADER_INCOMPLETE;
+  header->match_count = 0;
+  return TALON_HEADER_NONE;
+}
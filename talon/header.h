@@ -0,0 +1,69 @@
+#ifndef TREE_SITTER_TALON_HEADER_H_
+#define TREE_SITTER_TALON_HEADER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Scans the `matches` header of a talon file without the parser, for callers
+// that only need to know which contexts a file applies to. This is compiled
+// into the node and Rust bindings too, so it is a plain C interface.
+
+typedef enum {
+  TALON_HEADER_NONE,       // the file has no header
+  TALON_HEADER_FOUND,      // the header ends at `end_byte`
+  TALON_HEADER_INCOMPLETE, // more of the file is needed to decide
+} TalonHeaderStatus;
+
+// A header is only recognized if its line of dashes ends within this many
+// bytes, as in talon/stream.h.
+#define TALON_MAX_HEADER_SIZE (64 << 10)
+
+// A `match` line, e.g., `and not tag: user.terminal`, as byte ranges of its
+// identifier and its implicit string.
+typedef struct {
+  bool conjunctive;
+  bool negated;
+  uint32_t left_start;
+  uint32_t left_end;
+  uint32_t right_start;
+  uint32_t right_end;
+} TalonMatch;
+
+typedef struct {
+  // The byte after the line of dashes, where the declarations start.
+  uint32_t end_byte;
+  // The number of matches, which can be larger than the capacity passed in.
+  uint32_t match_count;
+} TalonHeader;
+
+// Whether `line`, without its newline, is the line of dashes that ends a
+// header, as the scanner decides: one or more dashes from column 0, then
+// only spaces, tabs, carriage returns or form feeds.
+bool talon_is_separator(const char *line, uint32_t length);
+
+// Scans `source` line by line up to the line of dashes that ends the header
+// and stores the first `capacity` matches in `matches`. Stops as soon as a
+// line cannot be part of a header, so the declarations are never read. A
+// headerless file that starts with lines that look like matches, such as
+// one-line commands `hello: key(a)`, is read up to TALON_MAX_HEADER_SIZE bytes
+// at worst, and then reported as TALON_HEADER_NONE.
+// `source` may be a prefix of the file, in which case TALON_HEADER_INCOMPLETE
+// asks for a longer one; `at_end` says that it is the whole file.
+TalonHeaderStatus talon_scan_header(
+  const char *source,
+  uint32_t length,
+  bool at_end,
+  TalonMatch *matches,
+  uint32_t capacity,
+  TalonHeader *header
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TREE_SITTER_TALON_HEADER_H_
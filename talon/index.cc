@@ -0,0 +1,244 @@
+#include "talon/index.h"
+#include "talon/language.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    FileIndex::Reference reference(std::string_view source, TSNode name, TSNode node)
+    {
+      return {std::string(node_text(source, name)), ts_node_start_byte(node), ts_node_end_byte(node),
+              ts_node_start_point(node)};
+    }
+
+    // Adds the actions, lists and captures below `node`.
+    void index_references(FileIndex &index, std::string_view source, TSNode node)
+    {
+      const Symbols &s = symbols();
+      TSTreeCursor cursor = ts_tree_cursor_new(node);
+      for (;;)
+      {
+        TSNode current = ts_tree_cursor_current_node(&cursor);
+        TSSymbol symbol = ts_node_symbol(current);
+        if (symbol == s.action)
+          index.actions.push_back(reference(source, ts_node_child_by_field_id(current, s.action_name), current));
+        else if (symbol == s.list)
+          index.lists.push_back(reference(source, ts_node_child_by_field_id(current, s.list_name), current));
+        else if (symbol == s.capture)
+          index.captures.push_back(reference(source, ts_node_child_by_field_id(current, s.capture_name), current));
+        if (ts_tree_cursor_goto_first_child(&cursor))
+          continue;
+        while (!ts_tree_cursor_goto_next_sibling(&cursor))
+        {
+          if (!ts_tree_cursor_goto_parent(&cursor))
+          {
+            ts_tree_cursor_delete(&cursor);
+            return;
+          }
+        }
+      }
+    }
+
+  }
+
+  FileIndex index_file(std::string path, TSNode root, std::string_view source)
+  {
+    const Symbols &s = symbols();
+    FileIndex index;
+    index.path = std::move(path);
+    index.matches = read_matches(root, source);
+
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode declarations = ts_node_named_child(root, i);
+      if (ts_node_symbol(declarations) != s.declarations)
+        continue;
+      uint32_t declaration_count = ts_node_named_child_count(declarations);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(declarations, j);
+        TSSymbol symbol = ts_node_symbol(declaration);
+        if (symbol == s.command_declaration)
+          index.commands.push_back(reference(source, ts_node_child_by_field_id(declaration, s.left), declaration));
+        else if (symbol == s.tag_import_declaration)
+          index.tags.push_back(reference(source, ts_node_child_by_field_id(declaration, s.right), declaration));
+        if (symbol != s.comment)
+          index_references(index, source, declaration);
+      }
+    }
+    return index;
+  }
+
+  IndexSnapshot::IndexSnapshot(uint64_t version, std::vector<std::shared_ptr<const FileIndex>> files)
+      : number(version), all_files(std::move(files))
+  {
+    for (const std::shared_ptr<const FileIndex> &file : all_files)
+    {
+      for (const FileIndex::Reference &reference : file->actions)
+        actions[reference.name].push_back({file.get(), &reference});
+      for (const FileIndex::Reference &reference : file->lists)
+        lists[reference.name].push_back({file.get(), &reference});
+      for (const FileIndex::Reference &reference : file->captures)
+        captures[reference.name].push_back({file.get(), &reference});
+    }
+  }
+
+  const FileIndex *IndexSnapshot::file(std::string_view path) const
+  {
+    auto before = [](const std::shared_ptr<const FileIndex> &file, std::string_view path)
+    {
+      return file->path < path;
+    };
+    auto it = std::lower_bound(all_files.begin(), all_files.end(), path, before);
+    return it != all_files.end() && (*it)->path == path ? it->get() : NULL;
+  }
+
+  const std::vector<IndexSnapshot::Entry> *IndexSnapshot::find(const Table &table, std::string_view name)
+  {
+    auto it = table.find(name);
+    return it == table.end() ? NULL : &it->second;
+  }
+
+  const std::vector<IndexSnapshot::Entry> *IndexSnapshot::find_action(std::string_view name) const
+  {
+    return find(actions, name);
+  }
+
+  const std::vector<IndexSnapshot::Entry> *IndexSnapshot::find_list(std::string_view name) const
+  {
+    return find(lists, name);
+  }
+
+  const std::vector<IndexSnapshot::Entry> *IndexSnapshot::find_capture(std::string_view name) const
+  {
+    return find(captures, name);
+  }
+
+  // The epoch a reader is pinned in, or 0 if the slot is free. Padded to a
+  // cache line, so that readers do not contend.
+  struct alignas(64) WorkspaceIndex::Slot
+  {
+    std::atomic<uint64_t> epoch{0};
+  };
+
+  WorkspaceIndex::Reader::Reader(Reader &&other) noexcept : slot(other.slot), snapshot(other.snapshot)
+  {
+    other.slot = NULL;
+  }
+
+  WorkspaceIndex::Reader::~Reader()
+  {
+    if (slot)
+      slot->store(0, std::memory_order_release);
+  }
+
+  WorkspaceIndex::WorkspaceIndex(size_t reader_slots)
+      : slots(new Slot[std::max<size_t>(reader_slots, 1)]), slot_count(std::max<size_t>(reader_slots, 1)),
+        current(new IndexSnapshot(0, {})), epoch(1)
+  {
+  }
+
+  WorkspaceIndex::~WorkspaceIndex()
+  {
+    delete current.load();
+    for (const Retired &r : retired)
+      delete r.snapshot;
+  }
+
+  // The slot is claimed with the epoch read before the snapshot pointer is
+  // loaded. If a writer replaces the snapshot in between, its scan either sees
+  // the slot, which is no later than the retiring epoch, or happened before
+  // the slot was claimed, in which case the load returns the new snapshot.
+  WorkspaceIndex::Reader WorkspaceIndex::read() const
+  {
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % slot_count;
+    for (;;)
+    {
+      for (size_t i = 0; i < slot_count; i++)
+      {
+        std::atomic<uint64_t> &slot = slots[(start + i) % slot_count].epoch;
+        uint64_t expected = 0;
+        if (slot.load(std::memory_order_relaxed) == 0 && slot.compare_exchange_strong(expected, epoch.load()))
+          return Reader(&slot, current.load());
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void WorkspaceIndex::update(std::vector<FileIndex> files, const std::vector<std::string> &removed)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    const IndexSnapshot *old = current.load();
+
+    std::vector<std::shared_ptr<const FileIndex>> changed;
+    for (FileIndex &file : files)
+      changed.push_back(std::make_shared<const FileIndex>(std::move(file)));
+    auto by_path = [](const std::shared_ptr<const FileIndex> &a, const std::shared_ptr<const FileIndex> &b)
+    {
+      return a->path < b->path;
+    };
+    std::stable_sort(changed.begin(), changed.end(), by_path);
+
+    // Merges the sorted old and changed files, with the last change of a path
+    // winning.
+    std::vector<std::shared_ptr<const FileIndex>> merged;
+    merged.reserve(old->files().size() + changed.size());
+    auto a = old->files().begin(), a_end = old->files().end();
+    auto b = changed.begin(), b_end = changed.end();
+    while (a != a_end || b != b_end)
+    {
+      if (b == b_end || (a != a_end && (*a)->path < (*b)->path))
+      {
+        merged.push_back(*a++);
+        continue;
+      }
+      if (a != a_end && (*a)->path == (*b)->path)
+        ++a;
+      while (b + 1 != b_end && (*(b + 1))->path == (*b)->path)
+        ++b;
+      merged.push_back(*b++);
+    }
+    if (!removed.empty())
+    {
+      std::vector<std::string> gone(removed);
+      std::sort(gone.begin(), gone.end());
+      auto is_gone = [&](const std::shared_ptr<const FileIndex> &file)
+      {
+        return std::binary_search(gone.begin(), gone.end(), file->path);
+      };
+      merged.erase(std::remove_if(merged.begin(), merged.end(), is_gone), merged.end());
+    }
+
+    current.store(new IndexSnapshot(old->version() + 1, std::move(merged)));
+    retired.push_back({epoch.fetch_add(1), old});
+    reclaim();
+  }
+
+  size_t WorkspaceIndex::retired_count() const
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    return retired.size();
+  }
+
+  void WorkspaceIndex::reclaim()
+  {
+    uint64_t oldest = UINT64_MAX;
+    for (size_t i = 0; i < slot_count; i++)
+    {
+      uint64_t pinned = slots[i].epoch.load();
+      if (pinned != 0)
+        oldest = std::min(oldest, pinned);
+    }
+    auto end = std::partition(retired.begin(), retired.end(), [&](const Retired &r) { return r.epoch >= oldest; });
+    for (auto it = end; it != retired.end(); ++it)
+      delete it->snapshot;
+    retired.erase(end, retired.end());
+  }
+
+}
@@ -0,0 +1,146 @@
+#ifndef TREE_SITTER_TALON_INDEX_H_
+#define TREE_SITTER_TALON_INDEX_H_
+
+#include "talon/context.h"
+#include <tree_sitter/api.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  // What a talon file declares and refers to, for completion and hover.
+  struct FileIndex
+  {
+    struct Reference
+    {
+      std::string name;
+      uint32_t start_byte;
+      uint32_t end_byte;
+      TSPoint start_point;
+    };
+
+    std::string path;
+    // The header, i.e., the context in which the file is active.
+    std::vector<Match> matches;
+    // The rule of every command, with the range of its declaration.
+    std::vector<Reference> commands;
+    // The tags activated by `tag(): name` declarations.
+    std::vector<Reference> tags;
+    // The actions called, and the lists and captures used in rules.
+    std::vector<Reference> actions;
+    std::vector<Reference> lists;
+    std::vector<Reference> captures;
+  };
+
+  // Indexes the file below `root`, which must be the `source_file` node.
+  FileIndex index_file(std::string path, TSNode root, std::string_view source);
+
+  // An immutable version of the index of a workspace. Files that did not
+  // change are shared with the previous version.
+  class IndexSnapshot
+  {
+  public:
+    struct Entry
+    {
+      const FileIndex *file;
+      const FileIndex::Reference *reference;
+    };
+
+    IndexSnapshot(uint64_t version, std::vector<std::shared_ptr<const FileIndex>> files);
+
+    uint64_t version() const { return number; }
+
+    // Sorted by path.
+    const std::vector<std::shared_ptr<const FileIndex>> &files() const { return all_files; }
+    const FileIndex *file(std::string_view path) const;
+
+    // Returns every reference to the named action, list or capture, or NULL.
+    const std::vector<Entry> *find_action(std::string_view name) const;
+    const std::vector<Entry> *find_list(std::string_view name) const;
+    const std::vector<Entry> *find_capture(std::string_view name) const;
+
+  private:
+    using Table = std::unordered_map<std::string_view, std::vector<Entry>>;
+
+    static const std::vector<Entry> *find(const Table &table, std::string_view name);
+
+    uint64_t number;
+    std::vector<std::shared_ptr<const FileIndex>> all_files;
+    Table actions;
+    Table lists;
+    Table captures;
+  };
+
+  // The index of a workspace, published as a sequence of snapshots. Readers
+  // pin the current snapshot without locks and are never blocked by writers.
+  // Replaced snapshots are freed by epoch-based reclamation: a snapshot retired
+  // in epoch E is freed once no reader is pinned in an epoch at or before E.
+  class WorkspaceIndex
+  {
+  public:
+    // Pins a snapshot until destroyed. Keep it short-lived, as it holds back
+    // the reclamation of every snapshot replaced in the meantime.
+    class Reader
+    {
+    public:
+      Reader(Reader &&other) noexcept;
+      Reader(const Reader &) = delete;
+      Reader &operator=(const Reader &) = delete;
+      Reader &operator=(Reader &&) = delete;
+      ~Reader();
+
+      const IndexSnapshot &operator*() const { return *snapshot; }
+      const IndexSnapshot *operator->() const { return snapshot; }
+
+    private:
+      friend class WorkspaceIndex;
+      Reader(std::atomic<uint64_t> *slot, const IndexSnapshot *snapshot) : slot(slot), snapshot(snapshot) {}
+
+      std::atomic<uint64_t> *slot;
+      const IndexSnapshot *snapshot;
+    };
+
+    // At most `reader_slots` readers are pinned at once; more wait for a slot.
+    explicit WorkspaceIndex(size_t reader_slots = 128);
+    ~WorkspaceIndex();
+    WorkspaceIndex(const WorkspaceIndex &) = delete;
+    WorkspaceIndex &operator=(const WorkspaceIndex &) = delete;
+
+    Reader read() const;
+
+    // Publishes a snapshot in which `files` replace the files with the same
+    // paths, and the files at `removed` are gone. Writers take turns, but
+    // readers keep reading the previous snapshot meanwhile.
+    void update(std::vector<FileIndex> files, const std::vector<std::string> &removed = {});
+
+    // Snapshots that were replaced but may still be pinned.
+    size_t retired_count() const;
+
+  private:
+    struct Slot;
+    struct Retired
+    {
+      uint64_t epoch;
+      const IndexSnapshot *snapshot;
+    };
+
+    void reclaim();
+
+    std::unique_ptr<Slot[]> slots;
+    size_t slot_count;
+    std::atomic<const IndexSnapshot *> current;
+    std::atomic<uint64_t> epoch;
+    mutable std::mutex writer;
+    std::vector<Retired> retired;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_INDEX_H_
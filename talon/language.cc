@@ -0,0 +1,93 @@
+#include "talon/language.h"
+#include <cstring>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    TSSymbol named(const TSLanguage *language, const char *name)
+    {
+      return ts_language_symbol_for_name(language, name, std::strlen(name), true);
+    }
+
+    TSFieldId field(const TSLanguage *language, const char *name)
+    {
+      return ts_language_field_id_for_name(language, name, std::strlen(name));
+    }
+
+    Symbols load_symbols()
+    {
+      const TSLanguage *language = tree_sitter_talon();
+      Symbols s;
+      s.source_file = named(language, "source_file");
+      s.comment = named(language, "comment");
+      s.matches = named(language, "matches");
+      s.match = named(language, "match");
+      s.match_modifier = named(language, "match_modifier");
+      s.declarations = named(language, "declarations");
+      s.command_declaration = named(language, "command_declaration");
+      s.app_declaration = named(language, "app_declaration");
+      s.face_declaration = named(language, "face_declaration");
+      s.gamepad_declaration = named(language, "gamepad_declaration");
+      s.noise_declaration = named(language, "noise_declaration");
+      s.parrot_declaration = named(language, "parrot_declaration");
+      s.tag_import_declaration = named(language, "tag_import_declaration");
+      s.key_binding_declaration = named(language, "key_binding_declaration");
+      s.settings_declaration = named(language, "settings_declaration");
+      s.rule = named(language, "rule");
+      s.choice = named(language, "choice");
+      s.seq = named(language, "seq");
+      s.word = named(language, "word");
+      s.list = named(language, "list");
+      s.capture = named(language, "capture");
+      s.optional = named(language, "optional");
+      s.repeat = named(language, "repeat");
+      s.repeat1 = named(language, "repeat1");
+      s.parenthesized_rule = named(language, "parenthesized_rule");
+      s.start_anchor = named(language, "start_anchor");
+      s.end_anchor = named(language, "end_anchor");
+      s.block = named(language, "block");
+      s.assignment_statement = named(language, "assignment_statement");
+      s.expression_statement = named(language, "expression_statement");
+      s.variable = named(language, "variable");
+      s.parenthesized_expression = named(language, "parenthesized_expression");
+      s.binary_operator = named(language, "binary_operator");
+      s.unary_operator = named(language, "unary_operator");
+      s.key_action = named(language, "key_action");
+      s.sleep_action = named(language, "sleep_action");
+      s.action = named(language, "action");
+      s.argument_list = named(language, "argument_list");
+      s.identifier = named(language, "identifier");
+      s.integer = named(language, "integer");
+      s.float_ = named(language, "float");
+      s.string = named(language, "string");
+      s.string_content = named(language, "string_content");
+      s.string_escape_sequence = named(language, "string_escape_sequence");
+      s.interpolation = named(language, "interpolation");
+      s.implicit_string = named(language, "implicit_string");
+      s.operator_ = named(language, "operator");
+
+      s.action_name = field(language, "action_name");
+      s.arguments = field(language, "arguments");
+      s.capture_name = field(language, "capture_name");
+      s.expression = field(language, "expression");
+      s.left = field(language, "left");
+      s.list_name = field(language, "list_name");
+      s.modifiers = field(language, "modifiers");
+      s.operator_field = field(language, "operator");
+      s.right = field(language, "right");
+      s.variable_name = field(language, "variable_name");
+      return s;
+    }
+
+  }
+
+  const Symbols &symbols()
+  {
+    static const Symbols instance = load_symbols();
+    return instance;
+  }
+
+}
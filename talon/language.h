@@ -0,0 +1,87 @@
+#ifndef TREE_SITTER_TALON_LANGUAGE_H_
+#define TREE_SITTER_TALON_LANGUAGE_H_
+
+#include <tree_sitter/api.h>
+#include <string_view>
+
+extern "C" const TSLanguage *tree_sitter_talon(void);
+
+namespace talon
+{
+
+  // Symbol and field ids of the talon grammar, looked up once by name so that
+  // tree walks compare integers rather than node type strings.
+  struct Symbols
+  {
+    TSSymbol source_file;
+    TSSymbol comment;
+    TSSymbol matches;
+    TSSymbol match;
+    TSSymbol match_modifier;
+    TSSymbol declarations;
+    TSSymbol command_declaration;
+    TSSymbol app_declaration;
+    TSSymbol face_declaration;
+    TSSymbol gamepad_declaration;
+    TSSymbol noise_declaration;
+    TSSymbol parrot_declaration;
+    TSSymbol tag_import_declaration;
+    TSSymbol key_binding_declaration;
+    TSSymbol settings_declaration;
+    TSSymbol rule;
+    TSSymbol choice;
+    TSSymbol seq;
+    TSSymbol word;
+    TSSymbol list;
+    TSSymbol capture;
+    TSSymbol optional;
+    TSSymbol repeat;
+    TSSymbol repeat1;
+    TSSymbol parenthesized_rule;
+    TSSymbol start_anchor;
+    TSSymbol end_anchor;
+    TSSymbol block;
+    TSSymbol assignment_statement;
+    TSSymbol expression_statement;
+    TSSymbol variable;
+    TSSymbol parenthesized_expression;
+    TSSymbol binary_operator;
+    TSSymbol unary_operator;
+    TSSymbol key_action;
+    TSSymbol sleep_action;
+    TSSymbol action;
+    TSSymbol argument_list;
+    TSSymbol identifier;
+    TSSymbol integer;
+    TSSymbol float_;
+    TSSymbol string;
+    TSSymbol string_content;
+    TSSymbol string_escape_sequence;
+    TSSymbol interpolation;
+    TSSymbol implicit_string;
+    TSSymbol operator_;
+
+    TSFieldId action_name;
+    TSFieldId arguments;
+    TSFieldId capture_name;
+    TSFieldId expression;
+    TSFieldId left;
+    TSFieldId list_name;
+    TSFieldId modifiers;
+    TSFieldId operator_field;
+    TSFieldId right;
+    TSFieldId variable_name;
+  };
+
+  const Symbols &symbols();
+
+  inline std::string_view node_text(std::string_view source, TSNode node)
+  {
+    uint32_t start = ts_node_start_byte(node);
+    uint32_t end = ts_node_end_byte(node);
+    return source.substr(start, end - start);
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_LANGUAGE_H_
@@ -0,0 +1,117 @@
+#include "talon/lazy.h"
+#include "talon/language.h"
+#include <tree_sitter/parser.h>
+
+extern "C" void *tree_sitter_talon_lazy_external_scanner_create(void);
+
+extern "C" const TSLanguage *tree_sitter_talon_lazy(void)
+{
+  // The tables are shared; only the scanner differs.
+  static const TSLanguage language = []()
+  {
+    TSLanguage copy = *tree_sitter_talon();
+    copy.external_scanner.create = tree_sitter_talon_lazy_external_scanner_create;
+    return copy;
+  }();
+  return &language;
+}
+
+namespace talon
+{
+
+  namespace
+  {
+
+    TSNode first_declaration(TSNode root)
+    {
+      const Symbols &s = symbols();
+      uint32_t count = ts_node_named_child_count(root);
+      for (uint32_t i = 0; i < count; i++)
+      {
+        TSNode child = ts_node_named_child(root, i);
+        if (ts_node_symbol(child) != s.declarations)
+          continue;
+        uint32_t declaration_count = ts_node_named_child_count(child);
+        for (uint32_t j = 0; j < declaration_count; j++)
+        {
+          TSNode declaration = ts_node_named_child(child, j);
+          if (ts_node_symbol(declaration) != s.comment)
+            return declaration;
+        }
+      }
+      return TSNode{};
+    }
+
+  }
+
+  bool is_lazy_block(TSNode block)
+  {
+    // A parsed block always has a statement, since the scanner only indents
+    // before content that is not a comment.
+    const Symbols &s = symbols();
+    if (ts_node_symbol(block) != s.block)
+      return false;
+    uint32_t count = ts_node_named_child_count(block);
+    bool has_comment = false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSSymbol symbol = ts_node_symbol(ts_node_named_child(block, i));
+      if (symbol != s.comment)
+        return false;
+      has_comment = true;
+    }
+    return has_comment;
+  }
+
+  LazyBodies::LazyBodies() : parser(ts_parser_new())
+  {
+    ts_parser_set_language(parser, tree_sitter_talon());
+  }
+
+  LazyBodies::~LazyBodies()
+  {
+    clear();
+    ts_parser_delete(parser);
+  }
+
+  void LazyBodies::clear()
+  {
+    for (auto &entry : trees)
+      ts_tree_delete(entry.second);
+    trees.clear();
+  }
+
+  void LazyBodies::reset(const TSTree *tree, std::string_view source)
+  {
+    clear();
+    this->tree = tree;
+    this->source = source;
+  }
+
+  TSNode LazyBodies::body(TSNode declaration)
+  {
+    const Symbols &s = symbols();
+    if (ts_node_is_null(declaration) || declaration.tree != tree)
+      return TSNode{};
+    TSNode right = ts_node_child_by_field_id(declaration, s.right);
+    if (ts_node_is_null(right) || !is_lazy_block(right))
+      return right;
+
+    uint32_t start = ts_node_start_byte(declaration);
+    TSTree *&parsed_tree = trees[start];
+    if (!parsed_tree)
+    {
+      TSRange range = {
+          ts_node_start_point(declaration),
+          ts_node_end_point(declaration),
+          start,
+          ts_node_end_byte(declaration),
+      };
+      ts_parser_set_included_ranges(parser, &range, 1);
+      parsed_tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    }
+    TSNode parsed = first_declaration(ts_tree_root_node(parsed_tree));
+    return ts_node_is_null(parsed) ? parsed : ts_node_child_by_field_id(parsed, s.right);
+  }
+
+}
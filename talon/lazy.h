@@ -0,0 +1,57 @@
+#ifndef TREE_SITTER_TALON_LAZY_H_
+#define TREE_SITTER_TALON_LAZY_H_
+
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+// A copy of the talon language whose scanner skips indented command bodies:
+// every such `block` holds a single `comment` that spans its statements, found
+// by a line-based scan, and its `dedent`. One-line bodies are parsed as usual.
+// The parse tables are those of tree_sitter_talon(), so the copy must be built
+// against the same tree-sitter version as src/parser.c.
+extern "C" const TSLanguage *tree_sitter_talon_lazy(void);
+
+namespace talon
+{
+
+  // Whether `block` is a body that tree_sitter_talon_lazy() skipped.
+  bool is_lazy_block(TSNode block);
+
+  // Parses the bodies of declarations in a tree_sitter_talon_lazy() tree when
+  // they are first asked for, and keeps the result. The bodies are cached by
+  // the start of their declaration, so they belong to the tree and source
+  // given to reset().
+  class LazyBodies
+  {
+  public:
+    LazyBodies();
+    ~LazyBodies();
+    LazyBodies(const LazyBodies &) = delete;
+    LazyBodies &operator=(const LazyBodies &) = delete;
+
+    // Drops the bodies parsed so far and binds to `tree` and its `source`.
+    void reset(const TSTree *tree, std::string_view source);
+
+    // Returns the `right` field of `declaration`, or a null node if it does
+    // not come from the bound tree. A skipped body is parsed from the range of
+    // the declaration only, so the nodes have the same positions as in a full
+    // parse. They stay valid until the next reset().
+    TSNode body(TSNode declaration);
+
+    size_t parsed_count() const { return trees.size(); }
+
+  private:
+    void clear();
+
+    TSParser *parser;
+    const TSTree *tree = nullptr;
+    std::string_view source;
+    // Trees of single declarations, by their start byte.
+    std::unordered_map<uint32_t, TSTree *> trees;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_LAZY_H_
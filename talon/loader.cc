@@ -0,0 +1,292 @@
+#include "talon/loader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace talon
+{
+
+  namespace
+  {
+
+    // Opens `file` and makes room for its contents. Returns the descriptor, or
+    // -1 with the error set.
+    int open_file(LoadedFile &file)
+    {
+      int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+      {
+        file.error = errno;
+        return -1;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+      {
+        file.error = errno;
+        ::close(fd);
+        return -1;
+      }
+      file.contents.resize(st.st_size);
+      return fd;
+    }
+
+    // Reads the contents of `file` from `offset` on, and trims them if the file
+    // shrank since it was opened.
+    void read_rest(int fd, LoadedFile &file, size_t offset)
+    {
+      while (offset < file.contents.size())
+      {
+        ssize_t n = pread(fd, &file.contents[offset], file.contents.size() - offset, offset);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n < 0)
+        {
+          file.error = errno;
+          return;
+        }
+        if (n == 0)
+          break;
+        offset += n;
+      }
+      file.contents.resize(offset);
+    }
+
+  }
+
+#ifdef __linux__
+
+  // The submission and completion rings shared with the kernel, set up with
+  // the raw system calls rather than liburing, so that there is nothing to
+  // install.
+  struct FileLoader::Ring
+  {
+    int fd = -1;
+    unsigned entries = 0;
+    void *sq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    void *cq_ring = MAP_FAILED;
+    size_t cq_ring_size = 0;
+    io_uring_sqe *sqes = (io_uring_sqe *)MAP_FAILED;
+    size_t sqes_size = 0;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    io_uring_cqe *cqes;
+
+    ~Ring()
+    {
+      if (sqes != MAP_FAILED)
+        munmap(sqes, sqes_size);
+      if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+        munmap(cq_ring, cq_ring_size);
+      if (sq_ring != MAP_FAILED)
+        munmap(sq_ring, sq_ring_size);
+      if (fd >= 0)
+        ::close(fd);
+    }
+
+    // Returns NULL if io_uring is not available.
+    static Ring *create(unsigned depth)
+    {
+      io_uring_params params;
+      std::memset(&params, 0, sizeof(params));
+      int fd = syscall(__NR_io_uring_setup, depth, &params);
+      if (fd < 0)
+        return nullptr;
+      Ring *ring = new Ring();
+      ring->fd = fd;
+      ring->entries = params.sq_entries;
+      ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+      if (single_mmap)
+        ring->sq_ring_size = ring->cq_ring_size = std::max(ring->sq_ring_size, ring->cq_ring_size);
+      ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                           IORING_OFF_SQ_RING);
+      ring->cq_ring = single_mmap ? ring->sq_ring
+                                  : mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                         fd, IORING_OFF_CQ_RING);
+      ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+      ring->sqes = (io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                        IORING_OFF_SQES);
+      if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+      {
+        delete ring;
+        return nullptr;
+      }
+      char *sq = (char *)ring->sq_ring;
+      char *cq = (char *)ring->cq_ring;
+      ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+      ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+      ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+      ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+      ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+      ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+      ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+      ring->cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+      return ring;
+    }
+
+    void submit_read(int file_fd, const iovec *iov, uint64_t user_data)
+    {
+      unsigned tail = *sq_tail;
+      unsigned index = tail & *sq_mask;
+      io_uring_sqe &sqe = sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READV;
+      sqe.fd = file_fd;
+      sqe.addr = (uint64_t)(uintptr_t)iov;
+      sqe.len = 1;
+      sqe.off = 0;
+      sqe.user_data = user_data;
+      sq_array[index] = index;
+      __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Calls `f(user_data, result)` for every completion so far.
+    template <typename F>
+    unsigned reap(F f)
+    {
+      unsigned head = *cq_head, count = 0;
+      for (; head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE); head++, count++)
+      {
+        const io_uring_cqe &cqe = cqes[head & *cq_mask];
+        f(cqe.user_data, cqe.res);
+      }
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+      return count;
+    }
+
+    // Reads the batch `files[begin, end)`, which is no larger than the ring.
+    // Returns false if the ring failed, in which case the reads it did not
+    // complete were made synchronously.
+    bool load(std::vector<LoadedFile> &files, size_t begin, size_t end)
+    {
+      std::vector<int> fds(end - begin, -1);
+      std::vector<bool> done(end - begin, true);
+      std::vector<iovec> iovs(end - begin);
+      unsigned to_submit = 0, pending = 0;
+      for (size_t i = begin; i < end; i++)
+      {
+        LoadedFile &file = files[i];
+        int file_fd = fds[i - begin] = open_file(file);
+        if (file_fd < 0 || file.contents.empty())
+          continue;
+        iovs[i - begin].iov_base = &file.contents[0];
+        iovs[i - begin].iov_len = file.contents.size();
+        submit_read(file_fd, &iovs[i - begin], i);
+        done[i - begin] = false;
+        to_submit++;
+      }
+      pending = to_submit;
+
+      auto complete = [&](uint64_t i, int result)
+      {
+        LoadedFile &file = files[i];
+        if (result < 0)
+          file.error = -result;
+        else if (size_t(result) < file.contents.size())
+          read_rest(fds[i - begin], file, result);
+        done[i - begin] = true;
+        pending--;
+      };
+      bool ok = true;
+      while (pending > 0)
+      {
+        int submitted = syscall(__NR_io_uring_enter, fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+          // Entries the kernel has not consumed can be taken back. The ones it
+          // has consumed may still be reading into the buffers, so wait for
+          // all of them before reading the rest again synchronously, closing
+          // the files or giving up on the ring.
+          unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+          unsigned unconsumed = *sq_tail - head;
+          __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+          reap(complete);
+          while (pending > unconsumed)
+          {
+            // Completions are posted without entering, so poll if waiting
+            // fails too.
+            if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+              sched_yield();
+            reap(complete);
+          }
+          for (size_t i = begin; i < end; i++)
+            if (!done[i - begin])
+              read_rest(fds[i - begin], files[i], 0);
+          ok = false;
+          break;
+        }
+        if (submitted > 0)
+          to_submit -= submitted;
+        reap(complete);
+      }
+      for (int file_fd : fds)
+        if (file_fd >= 0)
+          ::close(file_fd);
+      return ok;
+    }
+  };
+
+  FileLoader::FileLoader(bool use_io_uring, unsigned queue_depth)
+  {
+    if (use_io_uring)
+      ring = Ring::create(std::max(queue_depth, 1u));
+  }
+
+  FileLoader::~FileLoader() { delete ring; }
+
+#else
+
+  struct FileLoader::Ring
+  {
+  };
+
+  FileLoader::FileLoader(bool, unsigned) {}
+
+  FileLoader::~FileLoader() {}
+
+#endif
+
+  void FileLoader::load(std::vector<LoadedFile> &files)
+  {
+    size_t begin = 0;
+#ifdef __linux__
+    while (ring && begin < files.size())
+    {
+      size_t end = std::min<size_t>(begin + ring->entries, files.size());
+      if (!ring->load(files, begin, end))
+      {
+        delete ring;
+        ring = nullptr;
+      }
+      begin = end;
+    }
+#endif
+    for (; begin < files.size(); begin++)
+    {
+      int fd = open_file(files[begin]);
+      if (fd < 0)
+        continue;
+      read_rest(fd, files[begin], 0);
+      ::close(fd);
+    }
+  }
+
+}
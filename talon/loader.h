@@ -0,0 +1,47 @@
+#ifndef TREE_SITTER_TALON_LOADER_H_
+#define TREE_SITTER_TALON_LOADER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace talon
+{
+
+  struct LoadedFile
+  {
+    std::string path;
+    std::string contents;
+    // The errno of a failed open, stat or read, or 0.
+    int error = 0;
+  };
+
+  // Reads whole files in batches. On Linux, the reads of a batch are submitted
+  // to io_uring together and complete in one system call. Where io_uring is
+  // not available, e.g., on other systems, on older kernels or when it is
+  // blocked by a seccomp filter, files are read one after another, and callers
+  // should read batches on several threads instead.
+  class FileLoader
+  {
+  public:
+    // `queue_depth` is the largest number of reads in flight.
+    explicit FileLoader(bool use_io_uring = true, unsigned queue_depth = 64);
+    ~FileLoader();
+    FileLoader(const FileLoader &) = delete;
+    FileLoader &operator=(const FileLoader &) = delete;
+
+    bool uses_io_uring() const { return ring != nullptr; }
+
+    // Fills in the contents, or the error, of every file in `files`, whose
+    // paths must be set.
+    void load(std::vector<LoadedFile> &files);
+
+  private:
+    struct Ring;
+
+    Ring *ring = nullptr;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_LOADER_H_
@@ -0,0 +1,196 @@
+#include "talon/number.h"
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    inline bool is_decimal(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    inline int digit_value(char c)
+    {
+      if (c >= '0' && c <= '9')
+        return c - '0';
+      c |= 0x20;
+      if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+      return 16;
+    }
+
+    inline void accumulate(Number &number, uint64_t base, uint64_t digit)
+    {
+      if (__builtin_mul_overflow(number.integer, base, &number.integer) ||
+          __builtin_add_overflow(number.integer, digit, &number.integer))
+        number.overflow = true;
+    }
+
+    // Reads `(_?[digit]+)+` after a `0x`, `0o` or `0b` prefix.
+    bool prefixed_digits(const char *&p, const char *end, uint64_t base, Number &number)
+    {
+      bool any = false;
+      for (;;)
+      {
+        const char *group = p;
+        if (p < end && *p == '_')
+          p++;
+        if (p == end || uint64_t(digit_value(*p)) >= base)
+        {
+          p = group;
+          return any;
+        }
+        while (p < end && uint64_t(digit_value(*p)) < base)
+          accumulate(number, base, digit_value(*p++));
+        any = true;
+      }
+    }
+
+    // Reads `([0-9]+_?)*` and returns the number of digits.
+    size_t decimal_digits(const char *&p, const char *end, Number *number, bool &separated)
+    {
+      size_t count = 0;
+      while (p < end && is_decimal(*p))
+      {
+        while (p < end && is_decimal(*p))
+        {
+          if (number)
+            accumulate(*number, 10, *p - '0');
+          p++;
+          count++;
+        }
+        if (p < end && *p == '_')
+        {
+          separated = true;
+          p++;
+        }
+      }
+      return count;
+    }
+
+    double to_double(const char *begin, const char *end, bool separated)
+    {
+      char stack[256];
+      std::string heap;
+      if (separated)
+      {
+        char *out = stack;
+        if (size_t(end - begin) >= sizeof(stack))
+        {
+          heap.resize(end - begin);
+          out = &heap[0];
+        }
+        char *start = out;
+        for (const char *p = begin; p < end; p++)
+          if (*p != '_')
+            *out++ = *p;
+        begin = start;
+        end = out;
+      }
+
+      double value = 0;
+      auto result = std::from_chars(begin, end, value);
+      if (result.ec == std::errc::result_out_of_range)
+      { // Fall back to strtod, which rounds to infinity or zero like Python.
+        std::string text(begin, end);
+        value = std::strtod(text.c_str(), NULL);
+      }
+      return value;
+    }
+
+  }
+
+  Number decode_number(std::string_view text)
+  {
+    Number number;
+    const char *p = text.data();
+    const char *end = p + text.size();
+    if (p == end)
+      return number;
+
+    // 0x, 0o and 0b integers, with an optional L suffix.
+    if (end - p >= 2 && p[0] == '0')
+    {
+      char prefix = p[1] | 0x20;
+      uint64_t base = prefix == 'x' ? 16 : prefix == 'o' ? 8
+                                       : prefix == 'b'   ? 2
+                                                         : 0;
+      if (base)
+      {
+        p += 2;
+        if (!prefixed_digits(p, end, base, number))
+          return Number();
+        if (p < end && (*p | 0x20) == 'l')
+        {
+          number.is_long = true;
+          p++;
+        }
+        if (p != end)
+          return Number();
+        number.kind = Number::INTEGER;
+        return number;
+      }
+    }
+
+    bool separated = false;
+    const char *start = p;
+    size_t whole = decimal_digits(p, end, &number, separated);
+
+    bool is_float = false;
+    if (p < end && *p == '.')
+    {
+      p++;
+      size_t fraction = decimal_digits(p, end, NULL, separated);
+      if (whole == 0 && fraction == 0)
+        return Number();
+      is_float = true;
+    }
+    else if (whole == 0)
+    {
+      return Number();
+    }
+
+    if (p < end && (*p | 0x20) == 'e')
+    {
+      p++;
+      if (p < end && (*p == '+' || *p == '-'))
+        p++;
+      if (decimal_digits(p, end, NULL, separated) == 0)
+        return Number();
+      is_float = true;
+    }
+    const char *numeric_end = p;
+
+    if (p < end)
+    {
+      char suffix = *p | 0x20;
+      if (suffix == 'l')
+        number.is_long = true;
+      else if (suffix == 'j')
+        number.is_imaginary = true;
+      else
+        return Number();
+      if (++p != end)
+        return Number();
+    }
+
+    if (is_float)
+    {
+      number.kind = Number::FLOAT;
+      number.integer = 0;
+      number.overflow = false;
+      number.real = to_double(start, numeric_end, separated);
+    }
+    else
+    {
+      number.kind = Number::INTEGER;
+    }
+    return number;
+  }
+
+}
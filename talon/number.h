@@ -0,0 +1,38 @@
+#ifndef TREE_SITTER_TALON_NUMBER_H_
+#define TREE_SITTER_TALON_NUMBER_H_
+
+#include <cstdint>
+#include <string_view>
+
+namespace talon
+{
+
+  // A decoded `integer` or `float` token.
+  struct Number
+  {
+    enum Kind : uint8_t
+    {
+      INVALID,
+      INTEGER,
+      FLOAT,
+    };
+
+    Kind kind = INVALID;
+    bool is_long = false;      // an `L` suffix
+    bool is_imaginary = false; // a `j` suffix
+    bool overflow = false;     // an integer that does not fit in 64 bits
+    uint64_t integer = 0;
+    double real = 0;
+  };
+
+  // Decodes the text of an `integer` or `float` token in place, accepting
+  // exactly the forms in grammar.js: `0x`, `0o` and `0b` prefixes, `_` digit
+  // separators, exponents, and `L` or `j` suffixes. Anything else is INVALID.
+  //
+  // The text is never copied, except for floats with `_` separators, which
+  // are compacted into a stack buffer before conversion.
+  Number decode_number(std::string_view text);
+
+}
+
+#endif // TREE_SITTER_TALON_NUMBER_H_
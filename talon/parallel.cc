@@ -0,0 +1,186 @@
+#include "talon/parallel.h"
+#include "talon/language.h"
+#include "talon/split.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    // Returns the ranges of the pieces of `source` that start at `points`, as
+    // returned by find_split_points().
+    std::vector<TSRange> piece_ranges(std::string_view source, const std::vector<size_t> &points)
+    {
+      std::vector<TSRange> ranges(points.size() - 1);
+      TSPoint point = {0, 0};
+      for (size_t i = 0; i + 1 < points.size(); i++)
+      {
+        ranges[i].start_byte = points[i];
+        ranges[i].end_byte = points[i + 1];
+        ranges[i].start_point = point;
+        // Pieces start at column 0, so only the rows need counting.
+        point.row += std::count(source.begin() + points[i], source.begin() + points[i + 1], '\n');
+        ranges[i].end_point = point;
+      }
+      // The last piece ends at the end of the file, which may be mid-line.
+      if (!ranges.empty())
+      {
+        size_t line_start = source.rfind('\n');
+        ranges.back().end_point.column = source.size() - (line_start == std::string_view::npos ? 0 : line_start + 1);
+      }
+      return ranges;
+    }
+
+  }
+
+  SplitTree::~SplitTree()
+  {
+    for (Piece &piece : parts)
+      ts_tree_delete(piece.tree);
+  }
+
+  SplitTree::SplitTree(SplitTree &&other) noexcept : parts(std::move(other.parts)) { other.parts.clear(); }
+
+  SplitTree &SplitTree::operator=(SplitTree &&other) noexcept
+  {
+    std::swap(parts, other.parts);
+    return *this;
+  }
+
+  void SplitTree::for_each_declaration(const std::function<void(TSNode)> &f) const
+  {
+    const Symbols &s = symbols();
+    for (const Piece &piece : parts)
+    {
+      TSNode root = ts_tree_root_node(piece.tree);
+      uint32_t count = ts_node_named_child_count(root);
+      for (uint32_t i = 0; i < count; i++)
+      {
+        TSNode child = ts_node_named_child(root, i);
+        TSSymbol symbol = ts_node_symbol(child);
+        if (symbol == s.comment)
+          continue;
+        if (symbol != s.declarations)
+        {
+          f(child);
+          continue;
+        }
+        uint32_t declaration_count = ts_node_named_child_count(child);
+        for (uint32_t j = 0; j < declaration_count; j++)
+        {
+          TSNode declaration = ts_node_named_child(child, j);
+          if (ts_node_symbol(declaration) != s.comment)
+            f(declaration);
+        }
+      }
+    }
+  }
+
+  SplitTree parse_parallel(std::string_view source, unsigned threads, size_t min_piece_size)
+  {
+    threads = std::max(1u, threads);
+    // More pieces than threads, so that a piece that happens to be slow does
+    // not hold up the rest.
+    size_t count = std::min<size_t>(threads * 4, source.size() / std::max<size_t>(min_piece_size, 1));
+    std::vector<size_t> points = find_split_points(source, std::max<size_t>(count, 1));
+
+    SplitTree result;
+    std::vector<TSRange> ranges = piece_ranges(source, points);
+    for (const TSRange &range : ranges)
+      result.parts.push_back({range.start_byte, range.end_byte, NULL});
+
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+      TSParser *parser = ts_parser_new();
+      ts_parser_set_language(parser, tree_sitter_talon());
+      for (size_t i; (i = next.fetch_add(1)) < ranges.size();)
+      {
+        ts_parser_set_included_ranges(parser, &ranges[i], 1);
+        result.parts[i].tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      }
+      ts_parser_delete(parser);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(threads, ranges.size()); t++)
+      pool.emplace_back(work);
+    work();
+    for (std::thread &thread : pool)
+      thread.join();
+    return result;
+  }
+
+  std::vector<SplitTree> parse_workspace(const std::vector<std::string_view> &sources, const WorkspaceOptions &options,
+                                         Scheduler::Stats *stats)
+  {
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t split_size = std::max<size_t>(options.split_size, 1);
+    std::vector<SplitTree> result(sources.size());
+    // The ranges of the pieces of split files, set by the task that splits
+    // them before it pushes the tasks that parse them.
+    std::vector<std::vector<TSRange>> ranges(sources.size());
+    std::vector<TSParser *> parsers(threads);
+    for (TSParser *&parser : parsers)
+    {
+      parser = ts_parser_new();
+      ts_parser_set_language(parser, tree_sitter_talon());
+    }
+
+    auto parse_piece = [&](unsigned thread, size_t file, size_t piece)
+    {
+      TSParser *parser = parsers[thread];
+      if (ranges[file].empty())
+        ts_parser_set_included_ranges(parser, NULL, 0);
+      else
+        ts_parser_set_included_ranges(parser, &ranges[file][piece], 1);
+      std::string_view source = sources[file];
+      result[file].parts[piece].tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    };
+
+    // Dealt round-robin by decreasing size, so that every thread starts on
+    // one of the largest files and the small ones fill the gaps at the end.
+    std::vector<size_t> order(sources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return sources[a].size() > sources[b].size(); });
+
+    Scheduler scheduler(threads);
+    for (size_t k = 0; k < order.size(); k++)
+    {
+      size_t file = order[k];
+      if (sources[file].size() <= split_size)
+      {
+        result[file].parts.push_back({0, uint32_t(sources[file].size()), NULL});
+        scheduler.push_back(k, [&, file](unsigned thread) { parse_piece(thread, file, 0); });
+        continue;
+      }
+      // The thread that takes a large file cuts it, so that large files are
+      // scanned for split points in parallel too. It parses the pieces in
+      // order from the front of its deque, while idle threads steal them from
+      // the back.
+      scheduler.push_back(k, [&, file](unsigned thread)
+      {
+        std::string_view source = sources[file];
+        std::vector<size_t> points = find_split_points(source, (source.size() + split_size - 1) / split_size);
+        ranges[file] = piece_ranges(source, points);
+        for (const TSRange &range : ranges[file])
+          result[file].parts.push_back({range.start_byte, range.end_byte, NULL});
+        for (size_t i = ranges[file].size(); i-- > 0;)
+          scheduler.push_front(thread, [&, file, i](unsigned thread) { parse_piece(thread, file, i); });
+      });
+    }
+
+    Scheduler::Stats run_stats = scheduler.run();
+    for (TSParser *parser : parsers)
+      ts_parser_delete(parser);
+    if (stats)
+      *stats = std::move(run_stats);
+    return result;
+  }
+
+}
@@ -0,0 +1,74 @@
+#ifndef TREE_SITTER_TALON_PARALLEL_H_
+#define TREE_SITTER_TALON_PARALLEL_H_
+
+#include "talon/scheduler.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  struct WorkspaceOptions
+  {
+    // The number of threads, or 0 for one per core.
+    unsigned threads = 0;
+    // Files larger than this are parsed in pieces of about this size.
+    size_t split_size = 1 << 20;
+  };
+
+  // A file parsed as independent pieces, cut before top-level declarations
+  // (see talon/split.h). Every piece is parsed from the whole source with its
+  // byte range as the only included range, so its nodes have the positions
+  // they would have in a parse of the whole file.
+  class SplitTree
+  {
+  public:
+    struct Piece
+    {
+      uint32_t start_byte;
+      uint32_t end_byte;
+      TSTree *tree;
+    };
+
+    SplitTree() = default;
+    ~SplitTree();
+    SplitTree(SplitTree &&other) noexcept;
+    SplitTree &operator=(SplitTree &&other) noexcept;
+    SplitTree(const SplitTree &) = delete;
+    SplitTree &operator=(const SplitTree &) = delete;
+
+    // Calls `f` on every `matches` node, declaration and top-level ERROR, in
+    // the order of the file.
+    void for_each_declaration(const std::function<void(TSNode)> &f) const;
+
+    const std::vector<Piece> &pieces() const { return parts; }
+
+  private:
+    friend SplitTree parse_parallel(std::string_view, unsigned, size_t);
+    friend std::vector<SplitTree> parse_workspace(const std::vector<std::string_view> &, const WorkspaceOptions &,
+                                                  Scheduler::Stats *);
+
+    std::vector<Piece> parts;
+  };
+
+  // Parses `source` on `threads` threads, with one parser each, in pieces of
+  // at least `min_piece_size` bytes. Every piece starts with the scanner in its
+  // initial state, as a file does.
+  SplitTree parse_parallel(std::string_view source, unsigned threads, size_t min_piece_size = 64 << 10);
+
+  // Parses every file of a workspace on a Scheduler with one parser per
+  // thread, starting with the largest files. Files larger than
+  // `options.split_size` are cut into pieces as by parse_parallel(), which
+  // idle threads steal, so that a few huge files do not hold up the rest.
+  // Returns the tree of every file, in the order of `sources`, and the
+  // scheduler's statistics in `*stats`.
+  std::vector<SplitTree> parse_workspace(const std::vector<std::string_view> &sources,
+                                         const WorkspaceOptions &options = WorkspaceOptions(),
+                                         Scheduler::Stats *stats = nullptr);
+
+}
+
+#endif // TREE_SITTER_TALON_PARALLEL_H_
@@ -0,0 +1,68 @@
+#include "talon/parse.h"
+#include <algorithm>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    struct Reader
+    {
+      std::string_view source;
+      const ParseOptions *options;
+      uint32_t bytes_read;
+    };
+
+    const char *read_chunk(void *payload, uint32_t byte, TSPoint, uint32_t *bytes_read)
+    {
+      Reader *reader = static_cast<Reader *>(payload);
+      uint32_t size = reader->source.size();
+      if (byte >= size)
+      {
+        *bytes_read = 0;
+        return "";
+      }
+      *bytes_read = std::min(size - byte, std::max(reader->options->chunk_size, 1u));
+      // Incremental parses reuse subtrees and read out of order, so report the
+      // furthest byte seen.
+      uint32_t end = byte + *bytes_read;
+      if (end > reader->bytes_read)
+      {
+        reader->bytes_read = end;
+        if (reader->options->progress)
+          reader->options->progress(end, size);
+      }
+      return reader->source.data() + byte;
+    }
+
+  }
+
+  TSTree *parse(TSParser *parser, const TSTree *old_tree, std::string_view source, const ParseOptions &options,
+                ParseStatus *status)
+  {
+    uint64_t timeout = ts_parser_timeout_micros(parser);
+    const size_t *flag = ts_parser_cancellation_flag(parser);
+    ts_parser_set_timeout_micros(parser, options.timeout_micros);
+    ts_parser_set_cancellation_flag(parser, options.cancellation_flag);
+
+    Reader reader = {source, &options, 0};
+    TSInput input = {&reader, read_chunk, TSInputEncodingUTF8};
+    TSTree *tree = ts_parser_parse(parser, old_tree, input);
+
+    ts_parser_set_timeout_micros(parser, timeout);
+    ts_parser_set_cancellation_flag(parser, flag);
+    if (!tree)
+      ts_parser_reset(parser);
+    if (!status)
+      return tree;
+    if (tree)
+      *status = PARSE_OK;
+    else if (options.cancellation_flag && *options.cancellation_flag)
+      *status = PARSE_CANCELLED;
+    else
+      *status = PARSE_TIMED_OUT;
+    return tree;
+  }
+
+}
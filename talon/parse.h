@@ -0,0 +1,42 @@
+#ifndef TREE_SITTER_TALON_PARSE_H_
+#define TREE_SITTER_TALON_PARSE_H_
+
+#include <tree_sitter/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace talon
+{
+
+  struct ParseOptions
+  {
+    // Gives up after this many microseconds, or never if 0.
+    uint64_t timeout_micros = 0;
+    // Gives up soon after another thread sets `*cancellation_flag` to nonzero.
+    const size_t *cancellation_flag = nullptr;
+    // Called with the number of bytes read so far and the size of the source.
+    std::function<void(uint32_t bytes_read, uint32_t total)> progress;
+    // How many bytes the parser is given at a time, which sets how often
+    // `progress` is called.
+    uint32_t chunk_size = 4096;
+  };
+
+  enum ParseStatus
+  {
+    PARSE_OK,
+    PARSE_TIMED_OUT,
+    PARSE_CANCELLED,
+  };
+
+  // Parses `source` with `parser`, bounded by `options`. Returns NULL if the
+  // parse timed out or was cancelled. Either way, the parser is left reset,
+  // with its own timeout and cancellation flag, so the next parse starts
+  // afresh instead of resuming this one.
+  TSTree *parse(TSParser *parser, const TSTree *old_tree, std::string_view source, const ParseOptions &options,
+                ParseStatus *status = nullptr);
+
+}
+
+#endif // TREE_SITTER_TALON_PARSE_H_
@@ -0,0 +1,279 @@
+#include "talon/phrases.h"
+#include <algorithm>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    uint64_t add_saturated(uint64_t a, uint64_t b) { return a > UINT64_MAX - b ? UINT64_MAX : a + b; }
+
+    uint64_t multiply_saturated(uint64_t a, uint64_t b)
+    {
+      if (a == 0 || b == 0)
+        return 0;
+      return a > UINT64_MAX / b ? UINT64_MAX : a * b;
+    }
+
+    uint64_t reference_size(const PhraseOptions &options, const RuleOp &op)
+    {
+      return options.size ? options.size(op) : 1;
+    }
+
+    // The operands of every op, by index, from the postfix order. Fails on a
+    // rule that is not well formed.
+    bool operands_of(const RuleIR &rule, std::vector<std::vector<uint32_t>> &operands)
+    {
+      operands.assign(rule.ops.size(), {});
+      std::vector<uint32_t> stack;
+      for (uint32_t i = 0; i < rule.ops.size(); i++)
+      {
+        const RuleOp &op = rule.ops[i];
+        uint32_t arity = 0;
+        if (op.kind == RULE_SEQ || op.kind == RULE_CHOICE)
+          arity = op.arity;
+        else if (op.kind == RULE_OPTIONAL || op.kind == RULE_REPEAT || op.kind == RULE_REPEAT1)
+          arity = 1;
+        if (stack.size() < arity)
+          return false;
+        operands[i].assign(stack.end() - arity, stack.end());
+        stack.resize(stack.size() - arity);
+        stack.push_back(i);
+      }
+      return stack.size() == 1;
+    }
+
+  }
+
+  uint64_t count_phrases(const RuleIR &rule, const PhraseOptions &options)
+  {
+    std::vector<uint64_t> stack;
+    for (const RuleOp &op : rule.ops)
+    {
+      switch (op.kind)
+      {
+      case RULE_WORD:
+      case RULE_START_ANCHOR:
+      case RULE_END_ANCHOR:
+        stack.push_back(1);
+        break;
+      case RULE_LIST:
+      case RULE_CAPTURE:
+        stack.push_back(reference_size(options, op));
+        break;
+      case RULE_SEQ:
+      case RULE_CHOICE:
+      {
+        if (stack.size() < op.arity)
+          return 0;
+        uint64_t count = op.kind == RULE_SEQ ? 1 : 0;
+        for (size_t i = stack.size() - op.arity; i < stack.size(); i++)
+          count = op.kind == RULE_SEQ ? multiply_saturated(count, stack[i]) : add_saturated(count, stack[i]);
+        stack.resize(stack.size() - op.arity);
+        stack.push_back(count);
+        break;
+      }
+      case RULE_OPTIONAL:
+        if (stack.empty())
+          return 0;
+        stack.back() = add_saturated(stack.back(), 1);
+        break;
+      case RULE_REPEAT:
+      case RULE_REPEAT1:
+      {
+        if (stack.empty())
+          return 0;
+        // The sum of count^k over the allowed numbers k of repetitions.
+        uint64_t count = 0, power = 1;
+        for (uint32_t k = 0; k <= options.max_repeat; k++)
+        {
+          if (k >= (op.kind == RULE_REPEAT1 ? 1u : 0u))
+            count = add_saturated(count, power);
+          power = multiply_saturated(power, stack.back());
+        }
+        stack.back() = count;
+        break;
+      }
+      }
+    }
+    return stack.size() == 1 ? stack.back() : 0;
+  }
+
+  PhraseGenerator::PhraseGenerator(const RuleIR &rule, const PhraseOptions &options) : rule(rule), options(options)
+  {
+    std::vector<std::vector<uint32_t>> operands;
+    if (!operands_of(rule, operands))
+    {
+      done = true;
+      return;
+    }
+    root = instantiate(operands, rule.ops.size() - 1);
+
+    // Operands are instantiated after their op, so the longest phrase of
+    // every instance is known by the time its op is reached from the back.
+    std::vector<uint64_t> longest(instances.size());
+    for (size_t i = instances.size(); i-- > 0;)
+    {
+      const Instance &instance = instances[i];
+      RuleKind kind = instance.op->kind;
+      if (kind == RULE_WORD || kind == RULE_LIST || kind == RULE_CAPTURE)
+        longest[i] = 1;
+      for (uint32_t c = 0; c < instance.child_count; c++)
+      {
+        uint64_t child = longest[children[instance.first_child + c]];
+        longest[i] = kind == RULE_CHOICE ? std::max(longest[i], child) : longest[i] + child;
+      }
+    }
+    tokens.reserve(longest[root]);
+  }
+
+  uint32_t PhraseGenerator::instantiate(const std::vector<std::vector<uint32_t>> &operands, uint32_t op)
+  {
+    uint32_t index = instances.size();
+    const RuleOp &rule_op = rule.ops[op];
+    bool repeat = rule_op.kind == RULE_REPEAT || rule_op.kind == RULE_REPEAT1;
+    uint32_t count = repeat ? options.max_repeat : operands[op].size();
+    uint64_t size = rule_op.kind == RULE_LIST || rule_op.kind == RULE_CAPTURE ? reference_size(options, rule_op) : 1;
+    instances.push_back({&rule_op, uint32_t(children.size()), count, size, 0});
+    children.resize(children.size() + count);
+    for (uint32_t c = 0; c < count; c++)
+    {
+      uint32_t child = instantiate(operands, operands[op][repeat ? 0 : c]);
+      children[instances[index].first_child + c] = child;
+    }
+    return index;
+  }
+
+  bool PhraseGenerator::first_copies(const Instance &instance, uint64_t count)
+  {
+    for (uint64_t c = 0; c < count; c++)
+      if (!first(children[instance.first_child + c]))
+        return false;
+    return true;
+  }
+
+  // Moves the last of `count` operands that has a next phrase to it, and
+  // starts the ones after it over, like an odometer.
+  bool PhraseGenerator::advance_sequence(uint32_t first_child, uint64_t count)
+  {
+    for (uint64_t c = count; c-- > 0;)
+    {
+      if (advance(children[first_child + c]))
+        return true;
+      first(children[first_child + c]);
+    }
+    return false;
+  }
+
+  bool PhraseGenerator::first(uint32_t index)
+  {
+    Instance &instance = instances[index];
+    instance.state = 0;
+    switch (instance.op->kind)
+    {
+    case RULE_LIST:
+    case RULE_CAPTURE:
+      return instance.size > 0;
+    case RULE_SEQ:
+      return first_copies(instance, instance.child_count);
+    case RULE_CHOICE:
+      for (; instance.state < instance.child_count; instance.state++)
+        if (first(children[instance.first_child + instance.state]))
+          return true;
+      return false;
+    case RULE_REPEAT1:
+      instance.state = 1;
+      return instance.child_count > 0 && first_copies(instance, 1);
+    default:
+      return true;
+    }
+  }
+
+  bool PhraseGenerator::advance(uint32_t index)
+  {
+    Instance &instance = instances[index];
+    switch (instance.op->kind)
+    {
+    case RULE_LIST:
+    case RULE_CAPTURE:
+      if (instance.state + 1 >= instance.size)
+        return false;
+      instance.state++;
+      return true;
+    case RULE_SEQ:
+      return advance_sequence(instance.first_child, instance.child_count);
+    case RULE_CHOICE:
+      if (advance(children[instance.first_child + instance.state]))
+        return true;
+      while (++instance.state < instance.child_count)
+        if (first(children[instance.first_child + instance.state]))
+          return true;
+      return false;
+    case RULE_OPTIONAL:
+      if (instance.state == 1)
+        return advance(children[instance.first_child]);
+      instance.state = 1;
+      return first(children[instance.first_child]);
+    case RULE_REPEAT:
+    case RULE_REPEAT1:
+      if (advance_sequence(instance.first_child, instance.state))
+        return true;
+      // With no phrase of the operand, there is no longer repetition either.
+      if (instance.state >= instance.child_count || !first_copies(instance, instance.state + 1))
+        return false;
+      instance.state++;
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  void PhraseGenerator::emit(uint32_t index)
+  {
+    const Instance &instance = instances[index];
+    switch (instance.op->kind)
+    {
+    case RULE_WORD:
+    case RULE_LIST:
+    case RULE_CAPTURE:
+      tokens.push_back({instance.op, instance.state});
+      break;
+    case RULE_START_ANCHOR:
+    case RULE_END_ANCHOR:
+      break;
+    case RULE_SEQ:
+      for (uint32_t c = 0; c < instance.child_count; c++)
+        emit(children[instance.first_child + c]);
+      break;
+    case RULE_CHOICE:
+      emit(children[instance.first_child + instance.state]);
+      break;
+    case RULE_OPTIONAL:
+    case RULE_REPEAT:
+    case RULE_REPEAT1:
+      for (uint64_t c = 0; c < instance.state; c++)
+        emit(children[instance.first_child + c]);
+      break;
+    }
+  }
+
+  bool PhraseGenerator::next()
+  {
+    if (!started)
+    {
+      started = true;
+      done = instances.empty() || !first(root);
+    }
+    else if (!done)
+    {
+      done = !advance(root);
+    }
+    tokens.clear();
+    if (done)
+      return false;
+    emit(root);
+    return true;
+  }
+
+}
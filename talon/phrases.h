@@ -0,0 +1,86 @@
+#ifndef TREE_SITTER_TALON_PHRASES_H_
+#define TREE_SITTER_TALON_PHRASES_H_
+
+#include "talon/rule.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace talon
+{
+
+  struct PhraseOptions
+  {
+    // The number of items of a `{list}` or `<capture>` reference, or 1 for
+    // every reference if unset.
+    std::function<uint64_t(const RuleOp &reference)> size;
+    // The most times `a*` and `a+` repeat `a`, since they repeat without
+    // bound in Talon.
+    uint32_t max_repeat = 2;
+  };
+
+  // The number of phrases `rule` stands for, without listing them, saturated
+  // at UINT64_MAX. Phrases are counted the way an expansion lists them, so
+  // e.g. `[a] a*` counts `a` twice.
+  uint64_t count_phrases(const RuleIR &rule, const PhraseOptions &options = PhraseOptions());
+
+  // One word of a phrase: a word of the rule, or item `item` of a list or
+  // capture reference.
+  struct PhraseToken
+  {
+    const RuleOp *op;
+    uint64_t item;
+  };
+
+  // Lists the phrases of a rule one at a time, in the order of the rule: the
+  // later parts of a sequence vary first, and alternatives, optional parts
+  // and repetitions come shortest first. Memory is allocated once, in the
+  // constructor, and grows with the size of the rule and `max_repeat` but
+  // not with the number of phrases. `rule` must outlive the generator.
+  class PhraseGenerator
+  {
+  public:
+    PhraseGenerator(const RuleIR &rule, const PhraseOptions &options = PhraseOptions());
+
+    // Moves to the next phrase. Returns false when there are no more.
+    bool next();
+    const std::vector<PhraseToken> &phrase() const { return tokens; }
+
+    // Starts over from the first phrase.
+    void reset() { started = false; }
+
+  private:
+    struct Instance
+    {
+      const RuleOp *op;
+      // The operands, in `children`. A repetition has `max_repeat` copies of
+      // its operand.
+      uint32_t first_child;
+      uint32_t child_count;
+      // The items of a reference.
+      uint64_t size;
+      // The item of a reference, the alternative of a choice, whether an
+      // optional part is present, or the number of repetitions.
+      uint64_t state;
+    };
+
+    uint32_t instantiate(const std::vector<std::vector<uint32_t>> &operands, uint32_t op);
+    bool first(uint32_t instance);
+    bool advance(uint32_t instance);
+    bool first_copies(const Instance &instance, uint64_t count);
+    bool advance_sequence(uint32_t first_child, uint64_t count);
+    void emit(uint32_t instance);
+
+    const RuleIR &rule;
+    PhraseOptions options;
+    std::vector<Instance> instances;
+    std::vector<uint32_t> children;
+    uint32_t root = 0;
+    bool started = false;
+    bool done = false;
+    std::vector<PhraseToken> tokens;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_PHRASES_H_
@@ -0,0 +1,303 @@
+#include "talon/pipeline.h"
+#include "talon/language.h"
+#include "talon/loader.h"
+#include "talon/queue.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    uint64_t now_ns()
+    {
+      using namespace std::chrono;
+      return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct ParsedFile
+    {
+      LoadedFile file;
+      TSTree *tree;
+    };
+
+    // The counters of a stage, shared by its threads.
+    struct Stage
+    {
+      std::atomic<uint64_t> items{0};
+      std::atomic<uint64_t> busy_ns{0};
+      unsigned threads = 0;
+
+      StageStats stats(const char *name) const { return {name, threads, items.load(), busy_ns.load()}; }
+    };
+
+    // Times the work of one thread of a stage, which excludes waiting on the
+    // queues around it.
+    class BusyTimer
+    {
+    public:
+      explicit BusyTimer(Stage &stage) : stage(stage) {}
+      ~BusyTimer() { stage.busy_ns += total; }
+
+      void start() { started = now_ns(); }
+      void stop() { total += now_ns() - started; }
+
+    private:
+      Stage &stage;
+      uint64_t started = 0;
+      uint64_t total = 0;
+    };
+
+    // Starts `threads` threads that run `work`, and calls `finish` after the
+    // last of them returns, to close the queue they write to.
+    void start_stage(std::vector<std::thread> &pool, Stage &stage, unsigned threads,
+                     const std::function<void(unsigned)> &work, const std::function<void()> &finish)
+    {
+      stage.threads = threads;
+      auto remaining = std::make_shared<std::atomic<unsigned>>(threads);
+      for (unsigned t = 0; t < threads; t++)
+      {
+        pool.emplace_back([work, finish, remaining, t]()
+        {
+          work(t);
+          if (--*remaining == 0)
+            finish();
+        });
+      }
+    }
+
+    bool is_talon_file(const std::filesystem::directory_entry &entry)
+    {
+      std::error_code error;
+      return entry.is_regular_file(error) && entry.path().extension() == ".talon";
+    }
+
+    std::string relative_name(const std::string &path, const std::string &root)
+    {
+      return std::filesystem::path(path).lexically_relative(root).generic_string();
+    }
+
+  }
+
+  double PipelineStats::utilization(const StageStats &stage) const
+  {
+    return total_ns > 0 && stage.threads > 0 ? double(stage.busy_ns) / (double(total_ns) * stage.threads) : 0;
+  }
+
+  PipelineStats index_directory(const std::string &root, WorkspaceIndex &index, const PipelineOptions &options)
+  {
+    PipelineStats result;
+    uint64_t start = now_ns();
+    size_t read_batch = std::max<size_t>(options.read_batch, 1);
+    BoundedQueue<std::vector<LoadedFile>> batches(std::max<size_t>(options.queue_capacity / read_batch, 1));
+    BoundedQueue<LoadedFile> loaded(options.queue_capacity);
+    BoundedQueue<ParsedFile> parsed(options.queue_capacity);
+    BoundedQueue<FileIndex> extracted(options.queue_capacity);
+    Stage list_stage, read_stage, parse_stage, extract_stage, publish_stage;
+    std::atomic<uint64_t> bytes(0), failed(0);
+    std::vector<std::thread> pool;
+
+    start_stage(pool, list_stage, 1, [&](unsigned)
+    {
+      BusyTimer timer(list_stage);
+      timer.start();
+      std::vector<LoadedFile> batch;
+      std::error_code error;
+      auto walk_options = std::filesystem::directory_options::skip_permission_denied;
+      for (std::filesystem::recursive_directory_iterator it(root, walk_options, error), end; !error && it != end;
+           it.increment(error))
+      {
+        if (!is_talon_file(*it))
+          continue;
+        batch.emplace_back();
+        batch.back().path = it->path().string();
+        list_stage.items++;
+        if (batch.size() < read_batch)
+          continue;
+        timer.stop();
+        batches.push(std::move(batch));
+        timer.start();
+        batch.clear();
+      }
+      timer.stop();
+      if (!batch.empty())
+        batches.push(std::move(batch));
+    }, [&]() { batches.close(); });
+
+    // With io_uring, one thread keeps a batch of reads in flight. Without it,
+    // several threads each wait for one read at a time.
+    std::vector<std::unique_ptr<FileLoader>> loaders;
+    loaders.emplace_back(new FileLoader(options.use_io_uring, unsigned(read_batch)));
+    result.io_uring = loaders[0]->uses_io_uring();
+    while (!result.io_uring && loaders.size() < std::max(options.read_threads, 1u))
+      loaders.emplace_back(new FileLoader(false));
+    start_stage(pool, read_stage, unsigned(loaders.size()), [&](unsigned thread)
+    {
+      BusyTimer timer(read_stage);
+      std::vector<LoadedFile> batch;
+      while (batches.pop(batch))
+      {
+        timer.start();
+        loaders[thread]->load(batch);
+        timer.stop();
+        for (LoadedFile &file : batch)
+        {
+          read_stage.items++;
+          if (file.error)
+          {
+            failed++;
+            continue;
+          }
+          bytes += file.contents.size();
+          loaded.push(std::move(file));
+        }
+      }
+    }, [&]() { loaded.close(); });
+
+    unsigned parse_threads = options.parse_threads ? options.parse_threads
+                                                   : std::max(1u, std::thread::hardware_concurrency());
+    start_stage(pool, parse_stage, parse_threads, [&](unsigned)
+    {
+      BusyTimer timer(parse_stage);
+      TSParser *parser = ts_parser_new();
+      ts_parser_set_language(parser, tree_sitter_talon());
+      LoadedFile file;
+      while (loaded.pop(file))
+      {
+        timer.start();
+        TSTree *tree = ts_parser_parse_string(parser, NULL, file.contents.data(), file.contents.size());
+        parse_stage.items++;
+        timer.stop();
+        parsed.push({std::move(file), tree});
+      }
+      ts_parser_delete(parser);
+    }, [&]() { parsed.close(); });
+
+    start_stage(pool, extract_stage, std::max(options.extract_threads, 1u), [&](unsigned)
+    {
+      BusyTimer timer(extract_stage);
+      ParsedFile file;
+      while (parsed.pop(file))
+      {
+        timer.start();
+        FileIndex file_index = index_file(relative_name(file.file.path, root), ts_tree_root_node(file.tree),
+                                          file.file.contents);
+        ts_tree_delete(file.tree);
+        extract_stage.items++;
+        timer.stop();
+        extracted.push(std::move(file_index));
+      }
+    }, [&]() { extracted.close(); });
+
+    // Publishing runs on the calling thread.
+    {
+      publish_stage.threads = 1;
+      BusyTimer timer(publish_stage);
+      std::vector<FileIndex> files;
+      FileIndex file;
+      while (extracted.pop(file))
+      {
+        publish_stage.items++;
+        files.push_back(std::move(file));
+        if (options.publish_every == 0 || files.size() < options.publish_every)
+          continue;
+        timer.start();
+        index.update(std::move(files));
+        timer.stop();
+        files.clear();
+      }
+      timer.start();
+      if (!files.empty())
+        index.update(std::move(files));
+      timer.stop();
+    }
+    for (std::thread &thread : pool)
+      thread.join();
+
+    result.total_ns = now_ns() - start;
+    result.files = publish_stage.items;
+    result.bytes = bytes;
+    result.failed = failed;
+    result.stages = {list_stage.stats("list"), read_stage.stats("read"), parse_stage.stats("parse"),
+                     extract_stage.stats("extract"), publish_stage.stats("publish")};
+    return result;
+  }
+
+  PipelineStats index_directory_serial(const std::string &root, WorkspaceIndex &index)
+  {
+    PipelineStats result;
+    uint64_t start = now_ns();
+    Stage list_stage, read_stage, parse_stage, extract_stage, publish_stage;
+    for (Stage *stage : {&list_stage, &read_stage, &parse_stage, &extract_stage, &publish_stage})
+      stage->threads = 1;
+    FileLoader loader(false);
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_talon());
+    std::vector<FileIndex> files;
+    {
+      BusyTimer list_timer(list_stage), read_timer(read_stage), parse_timer(parse_stage),
+          extract_timer(extract_stage);
+      std::error_code error;
+      auto walk_options = std::filesystem::directory_options::skip_permission_denied;
+      list_timer.start();
+      for (std::filesystem::recursive_directory_iterator it(root, walk_options, error), end; !error && it != end;
+           it.increment(error))
+      {
+        if (!is_talon_file(*it))
+          continue;
+        std::vector<LoadedFile> file(1);
+        file[0].path = it->path().string();
+        list_timer.stop();
+        list_stage.items++;
+
+        read_timer.start();
+        loader.load(file);
+        read_timer.stop();
+        read_stage.items++;
+        if (file[0].error)
+        {
+          result.failed++;
+          list_timer.start();
+          continue;
+        }
+        result.bytes += file[0].contents.size();
+
+        parse_timer.start();
+        TSTree *tree = ts_parser_parse_string(parser, NULL, file[0].contents.data(), file[0].contents.size());
+        parse_timer.stop();
+        parse_stage.items++;
+
+        extract_timer.start();
+        files.push_back(index_file(relative_name(file[0].path, root), ts_tree_root_node(tree), file[0].contents));
+        ts_tree_delete(tree);
+        extract_timer.stop();
+        extract_stage.items++;
+        list_timer.start();
+      }
+      list_timer.stop();
+    }
+    ts_parser_delete(parser);
+
+    {
+      BusyTimer timer(publish_stage);
+      timer.start();
+      publish_stage.items = files.size();
+      if (!files.empty())
+        index.update(std::move(files));
+      timer.stop();
+    }
+
+    result.total_ns = now_ns() - start;
+    result.files = publish_stage.items;
+    result.stages = {list_stage.stats("list"), read_stage.stats("read"), parse_stage.stats("parse"),
+                     extract_stage.stats("extract"), publish_stage.stats("publish")};
+    return result;
+  }
+
+}
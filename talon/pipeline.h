@@ -0,0 +1,65 @@
+#ifndef TREE_SITTER_TALON_PIPELINE_H_
+#define TREE_SITTER_TALON_PIPELINE_H_
+
+#include "talon/index.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace talon
+{
+
+  struct PipelineOptions
+  {
+    // Reads are batched through io_uring where available. Otherwise, and if
+    // this is off, `read_threads` threads read one file at a time.
+    bool use_io_uring = true;
+    unsigned read_threads = 4;
+    size_t read_batch = 64;
+    // The number of parser threads, or 0 for one per core.
+    unsigned parse_threads = 0;
+    unsigned extract_threads = 2;
+    // The number of files each queue between two stages holds. A stage that
+    // gets ahead blocks until the next one catches up.
+    size_t queue_capacity = 256;
+    // Publish a snapshot every this many files, or only once at the end if 0.
+    size_t publish_every = 0;
+  };
+
+  struct StageStats
+  {
+    std::string name;
+    unsigned threads = 0;
+    uint64_t items = 0;
+    // The time the threads of the stage spent working rather than waiting
+    // for input or for room in the next queue.
+    uint64_t busy_ns = 0;
+  };
+
+  struct PipelineStats
+  {
+    uint64_t total_ns = 0;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    // Files that could not be read.
+    uint64_t failed = 0;
+    bool io_uring = false;
+    std::vector<StageStats> stages;
+
+    // The share of the total time the threads of `stage` were busy.
+    double utilization(const StageStats &stage) const;
+  };
+
+  // Indexes every .talon file below `root` into `index`, in five stages that
+  // run at once and pass files through bounded queues: list the directory,
+  // read files in batches, parse them with a parser per thread, extract their
+  // FileIndex, and publish. Files are named by their path below `root`.
+  PipelineStats index_directory(const std::string &root, WorkspaceIndex &index,
+                                const PipelineOptions &options = PipelineOptions());
+
+  // Does the same one file at a time, on the calling thread, for comparison.
+  PipelineStats index_directory_serial(const std::string &root, WorkspaceIndex &index);
+
+}
+
+#endif // TREE_SITTER_TALON_PIPELINE_H_
@@ -0,0 +1,69 @@
+#ifndef TREE_SITTER_TALON_QUEUE_H_
+#define TREE_SITTER_TALON_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace talon
+{
+
+  // A multi-producer, multi-consumer queue of at most `capacity` items.
+  // Producers block while it is full, which holds back a fast stage until the
+  // next one catches up.
+  template <typename T>
+  class BoundedQueue
+  {
+  public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    // Blocks while the queue is full. Returns false, dropping `item`, if the
+    // queue was closed.
+    bool push(T item)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      not_full.wait(lock, [&] { return items.size() < capacity || closed; });
+      if (closed)
+        return false;
+      items.push_back(std::move(item));
+      not_empty.notify_one();
+      return true;
+    }
+
+    // Blocks while the queue is empty and open. Returns false once it is
+    // closed and empty.
+    bool pop(T &item)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      not_empty.wait(lock, [&] { return !items.empty() || closed; });
+      if (items.empty())
+        return false;
+      item = std::move(items.front());
+      items.pop_front();
+      not_full.notify_one();
+      return true;
+    }
+
+    // Wakes every waiting consumer once the queue is drained, and makes
+    // further pushes fail.
+    void close()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+      not_empty.notify_all();
+      not_full.notify_all();
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_QUEUE_H_
@@ -0,0 +1,156 @@
+#include "talon/rule.h"
+#include "talon/language.h"
+
+namespace talon
+{
+
+  namespace
+  {
+
+    void append_varint(std::string &out, uint64_t value)
+    {
+      while (value >= 0x80)
+      {
+        out += char(value | 0x80);
+        value >>= 7;
+      }
+      out += char(value);
+    }
+
+    class RuleCompiler
+    {
+    public:
+      RuleCompiler(std::string_view source, RuleIR &out) : s(symbols()), source(source), out(out) {}
+
+      // Compiles `nodes[begin, end)` as one operand: an alternative with its
+      // anchors, or the rule inside brackets.
+      bool group(const std::vector<TSNode> &nodes, size_t begin, size_t end)
+      {
+        if (begin == end)
+          return false;
+        for (size_t i = begin; i < end; i++)
+          if (!compile(nodes[i]))
+            return false;
+        if (end - begin > 1)
+          out.ops.push_back({RULE_SEQ, uint32_t(end - begin), std::string()});
+        return true;
+      }
+
+      bool compile(TSNode node)
+      {
+        TSSymbol symbol = ts_node_symbol(node);
+        if (symbol == s.word)
+          return leaf(RULE_WORD, node);
+        if (symbol == s.list)
+          return leaf(RULE_LIST, ts_node_child_by_field_id(node, s.list_name));
+        if (symbol == s.capture)
+          return leaf(RULE_CAPTURE, ts_node_child_by_field_id(node, s.capture_name));
+        if (symbol == s.start_anchor)
+          return leaf(RULE_START_ANCHOR, TSNode());
+        if (symbol == s.end_anchor)
+          return leaf(RULE_END_ANCHOR, TSNode());
+        if (symbol == s.repeat || symbol == s.repeat1)
+        {
+          if (ts_node_named_child_count(node) != 1 || !compile(ts_node_named_child(node, 0)))
+            return false;
+          out.ops.push_back({symbol == s.repeat ? RULE_REPEAT : RULE_REPEAT1, 1, std::string()});
+          return true;
+        }
+        if (symbol == s.choice)
+          return choice(node);
+
+        std::vector<TSNode> children = named_children(node);
+        if (symbol == s.seq)
+        {
+          for (TSNode child : children)
+            if (!compile(child))
+              return false;
+          out.ops.push_back({RULE_SEQ, uint32_t(children.size()), std::string()});
+          return true;
+        }
+        if (symbol == s.optional)
+        {
+          if (!group(children, 0, children.size()))
+            return false;
+          out.ops.push_back({RULE_OPTIONAL, 1, std::string()});
+          return true;
+        }
+        if (symbol == s.parenthesized_rule || symbol == s.rule)
+          return group(children, 0, children.size());
+        return false;
+      }
+
+    private:
+      bool leaf(RuleKind kind, TSNode name)
+      {
+        out.ops.push_back({kind, 0, ts_node_is_null(name) ? std::string() : std::string(node_text(source, name))});
+        return true;
+      }
+
+      // The alternatives of a choice are separated by `|` tokens, and may
+      // each have anchors, which are siblings of the alternative in the tree.
+      bool choice(TSNode node)
+      {
+        std::vector<TSNode> children;
+        uint32_t alternatives = 0;
+        uint32_t count = ts_node_child_count(node);
+        for (uint32_t i = 0; i <= count; i++)
+        {
+          TSNode child = i < count ? ts_node_child(node, i) : TSNode();
+          if (i < count && ts_node_is_named(child))
+          {
+            if (ts_node_symbol(child) != s.comment)
+              children.push_back(child);
+            continue;
+          }
+          if (!group(children, 0, children.size()))
+            return false;
+          children.clear();
+          alternatives++;
+        }
+        out.ops.push_back({RULE_CHOICE, alternatives, std::string()});
+        return true;
+      }
+
+      std::vector<TSNode> named_children(TSNode node) const
+      {
+        std::vector<TSNode> result;
+        uint32_t count = ts_node_named_child_count(node);
+        for (uint32_t i = 0; i < count; i++)
+        {
+          TSNode child = ts_node_named_child(node, i);
+          if (ts_node_symbol(child) != s.comment)
+            result.push_back(child);
+        }
+        return result;
+      }
+
+      const Symbols &s;
+      std::string_view source;
+      RuleIR &out;
+    };
+
+  }
+
+  void RuleIR::encode(std::string &out) const
+  {
+    append_varint(out, ops.size());
+    for (const RuleOp &op : ops)
+    {
+      out += char(op.kind);
+      append_varint(out, op.arity);
+      append_varint(out, op.name.size());
+      out += op.name;
+    }
+  }
+
+  bool compile_rule(TSNode rule, std::string_view source, RuleIR &out)
+  {
+    out.ops.clear();
+    if (ts_node_is_null(rule) || ts_node_has_error(rule))
+      return false;
+    RuleCompiler compiler(source, out);
+    return compiler.compile(rule);
+  }
+
+}
@@ -0,0 +1,52 @@
+#ifndef TREE_SITTER_TALON_RULE_H_
+#define TREE_SITTER_TALON_RULE_H_
+
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  enum RuleKind : uint8_t
+  {
+    RULE_WORD,
+    RULE_LIST,    // {name}
+    RULE_CAPTURE, // <name>
+    RULE_START_ANCHOR,
+    RULE_END_ANCHOR,
+    RULE_SEQ,
+    RULE_CHOICE,
+    RULE_OPTIONAL, // [a]
+    RULE_REPEAT,   // a*
+    RULE_REPEAT1,  // a+
+  };
+
+  struct RuleOp
+  {
+    RuleKind kind;
+    // The number of operands of RULE_SEQ and RULE_CHOICE.
+    uint32_t arity;
+    // The word, or the name of the list or capture.
+    std::string name;
+  };
+
+  // A command rule in postfix order: the operands of every op come right
+  // before it, and the last op is the whole rule. Parentheses are dropped, and
+  // nested sequences and choices are kept as written.
+  struct RuleIR
+  {
+    std::vector<RuleOp> ops;
+
+    // Appends a canonical encoding, equal for equal rules.
+    void encode(std::string &out) const;
+  };
+
+  // Compiles a `rule` node. Fails on rules with syntax errors.
+  bool compile_rule(TSNode rule, std::string_view source, RuleIR &out);
+
+}
+
+#endif // TREE_SITTER_TALON_RULE_H_
@@ -0,0 +1,139 @@
+#include "talon/scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    uint64_t now_ns()
+    {
+      using namespace std::chrono;
+      return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+  }
+
+  // Padded to a cache line, so that threads working on their own deques do
+  // not contend.
+  struct alignas(64) Scheduler::Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  double Scheduler::Stats::utilization() const
+  {
+    uint64_t busy = 0;
+    for (uint64_t ns : busy_ns)
+      busy += ns;
+    return makespan_ns > 0 && !busy_ns.empty() ? double(busy) / (double(makespan_ns) * busy_ns.size()) : 0;
+  }
+
+  Scheduler::Scheduler(unsigned threads) : pending(0), steal_count(0)
+  {
+    for (unsigned t = 0; t < std::max(1u, threads); t++)
+      queues.emplace_back(new Queue());
+  }
+
+  Scheduler::~Scheduler() = default;
+
+  void Scheduler::push_back(unsigned thread, Task task)
+  {
+    pending.fetch_add(1);
+    Queue &queue = *queues[thread % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  void Scheduler::push_front(unsigned thread, Task task)
+  {
+    pending.fetch_add(1);
+    Queue &queue = *queues[thread % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_front(std::move(task));
+  }
+
+  bool Scheduler::pop(unsigned thread, Task &task)
+  {
+    Queue &queue = *queues[thread];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      return false;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+  }
+
+  // Takes from the back, which the owner would reach last, so that owner and
+  // thief rarely want the same task.
+  bool Scheduler::steal(unsigned thread, Task &task)
+  {
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+      Queue &queue = *queues[(thread + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty())
+        continue;
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      steal_count.fetch_add(1);
+      return true;
+    }
+    return false;
+  }
+
+  Scheduler::Stats Scheduler::run()
+  {
+    Stats stats;
+    stats.busy_ns.assign(queues.size(), 0);
+    std::atomic<uint64_t> tasks(0);
+    steal_count = 0;
+
+    auto work = [&](unsigned thread)
+    {
+      Task task;
+      for (;;)
+      {
+        if (pop(thread, task) || steal(thread, task))
+        {
+          uint64_t start = now_ns();
+          task(thread);
+          stats.busy_ns[thread] += now_ns() - start;
+          // Released before `pending` drops, so that what the task captured
+          // is gone when run() returns.
+          task = nullptr;
+          tasks.fetch_add(1);
+          pending.fetch_sub(1);
+        }
+        else if (pending.load() == 0)
+        {
+          return;
+        }
+        else
+        {
+          // A running task may still push more work.
+          std::this_thread::yield();
+        }
+      }
+    };
+
+    uint64_t start = now_ns();
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < queues.size(); t++)
+      pool.emplace_back(work, t);
+    work(0);
+    for (std::thread &thread : pool)
+      thread.join();
+    stats.makespan_ns = now_ns() - start;
+    stats.tasks = tasks;
+    stats.steals = steal_count;
+    return stats;
+  }
+
+}
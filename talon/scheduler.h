@@ -0,0 +1,66 @@
+#ifndef TREE_SITTER_TALON_SCHEDULER_H_
+#define TREE_SITTER_TALON_SCHEDULER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace talon
+{
+
+  // Runs tasks on a fixed number of threads with a deque each. A thread takes
+  // tasks from the front of its own deque, and when that is empty, steals from
+  // the back of the others, so that no thread idles while work is queued. A
+  // task may push more tasks, e.g., the pieces of a file it split.
+  class Scheduler
+  {
+  public:
+    // Called with the index of the thread that runs it, below threads(), so
+    // that tasks can keep per-thread state such as a parser.
+    using Task = std::function<void(unsigned thread)>;
+
+    struct Stats
+    {
+      uint64_t makespan_ns = 0;
+      // The time each thread spent running tasks.
+      std::vector<uint64_t> busy_ns;
+      uint64_t tasks = 0;
+      uint64_t steals = 0;
+
+      // The share of the makespan times the threads spent running tasks.
+      double utilization() const;
+    };
+
+    explicit Scheduler(unsigned threads);
+    ~Scheduler();
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    unsigned threads() const { return unsigned(queues.size()); }
+
+    // Adds `task` to the back of the deque of `thread`, or to the front, to run
+    // it next. Safe to call from tasks.
+    void push_back(unsigned thread, Task task);
+    void push_front(unsigned thread, Task task);
+
+    // Runs tasks on the calling thread and threads() - 1 others until every
+    // deque is empty and no task is running.
+    Stats run();
+
+  private:
+    struct Queue;
+
+    bool pop(unsigned thread, Task &task);
+    bool steal(unsigned thread, Task &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    // Tasks queued or running.
+    std::atomic<size_t> pending;
+    std::atomic<uint64_t> steal_count;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_SCHEDULER_H_
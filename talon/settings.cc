@@ -0,0 +1,259 @@
+#include "talon/settings.h"
+#include "talon/context.h"
+#include "talon/language.h"
+#include "talon/util.h"
+#include <algorithm>
+
+namespace talon
+{
+
+  void ContextSet::set(uint32_t id, bool active)
+  {
+    size_t word = id / 64;
+    if (word >= words.size())
+    {
+      if (!active)
+        return;
+      words.resize(word + 1, 0);
+    }
+    if (active)
+      words[word] |= uint64_t(1) << (id % 64);
+    else
+      words[word] &= ~(uint64_t(1) << (id % 64));
+  }
+
+  bool ContextSet::test(uint32_t id) const
+  {
+    size_t word = id / 64;
+    return word < words.size() && (words[word] >> (id % 64)) & 1;
+  }
+
+  bool ContextSet::operator==(const ContextSet &other) const
+  {
+    // Trailing zero words do not change the set.
+    size_t common = std::min(words.size(), other.words.size());
+    for (size_t i = 0; i < common; i++)
+      if (words[i] != other.words[i])
+        return false;
+    for (size_t i = common; i < words.size(); i++)
+      if (words[i])
+        return false;
+    for (size_t i = common; i < other.words.size(); i++)
+      if (other.words[i])
+        return false;
+    return true;
+  }
+
+  size_t ContextSet::hash() const
+  {
+    size_t length = words.size();
+    while (length > 0 && words[length - 1] == 0)
+      length--;
+
+    return size_t(hash_bytes(std::string_view((const char *)words.data(), length * sizeof(words[0]))));
+  }
+
+  SettingsResolver::SettingsResolver() : parser(ts_parser_new())
+  {
+    ts_parser_set_language(parser, tree_sitter_talon());
+  }
+
+  SettingsResolver::~SettingsResolver()
+  {
+    ts_parser_delete(parser);
+  }
+
+  uint32_t SettingsResolver::file_id(std::string_view path) const
+  {
+    auto it = file_ids.find(std::string(path));
+    return it == file_ids.end() ? npos : it->second;
+  }
+
+  uint32_t SettingsResolver::setting_id(std::string_view name) const
+  {
+    auto it = setting_ids.find(std::string(name));
+    return it == setting_ids.end() ? npos : it->second;
+  }
+
+  uint32_t SettingsResolver::intern_setting(std::string_view name)
+  {
+    auto [it, inserted] = setting_ids.emplace(std::string(name), uint32_t(setting_names.size()));
+    if (inserted)
+    {
+      setting_names.emplace_back(name);
+      candidates.emplace_back();
+    }
+    return it->second;
+  }
+
+  uint32_t SettingsResolver::update_file(std::string_view path, std::string_view source)
+  {
+    auto [it, inserted] = file_ids.emplace(std::string(path), uint32_t(files.size()));
+    uint32_t id = it->second;
+    if (inserted)
+    {
+      files.emplace_back();
+      files.back().path = std::string(path);
+    }
+    File &file = files[id];
+
+    std::vector<uint32_t> affected;
+    for (const Assignment &assignment : file.assignments)
+      affected.push_back(assignment.setting);
+
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    const Symbols &s = symbols();
+
+    std::vector<Match> matches = read_matches(root, source);
+    file.specificity = matches.size();
+    file.always_active = matches.empty();
+    file.assignments.clear();
+
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode declarations = ts_node_named_child(root, i);
+      if (ts_node_symbol(declarations) != s.declarations)
+        continue;
+
+      uint32_t declaration_count = ts_node_named_child_count(declarations);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(declarations, j);
+        if (ts_node_symbol(declaration) != s.settings_declaration)
+          continue;
+
+        TSNode block = ts_node_child_by_field_id(declaration, s.right);
+        uint32_t statement_count = ts_node_named_child_count(block);
+        for (uint32_t k = 0; k < statement_count; k++)
+        {
+          TSNode statement = ts_node_named_child(block, k);
+          if (ts_node_symbol(statement) != s.assignment_statement)
+            continue;
+
+          TSNode left = ts_node_child_by_field_id(statement, s.left);
+          TSNode right = ts_node_child_by_field_id(statement, s.right);
+          if (ts_node_is_null(left) || ts_node_is_null(right))
+            continue;
+
+          uint32_t setting = intern_setting(node_text(source, left));
+
+          // A later assignment in the same file overrides an earlier one.
+          auto previous = std::find_if(
+              file.assignments.begin(), file.assignments.end(),
+              [setting](const Assignment &a)
+              { return a.setting == setting; });
+          if (previous != file.assignments.end())
+            file.assignments.erase(previous);
+
+          file.assignments.push_back(Assignment{
+              setting,
+              id,
+              std::string(node_text(source, right)),
+              ts_node_start_byte(right),
+              ts_node_end_byte(right),
+          });
+          affected.push_back(setting);
+        }
+      }
+    }
+    ts_tree_delete(tree);
+
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+    for (uint32_t setting : affected)
+      reorder(setting, id);
+    refresh(affected);
+    return id;
+  }
+
+  void SettingsResolver::remove_file(std::string_view path)
+  {
+    uint32_t id = file_id(path);
+    if (id == npos)
+      return;
+
+    // Keep the id reserved, so that existing ContextSets keep their meaning.
+    File &file = files[id];
+    std::vector<uint32_t> affected;
+    for (const Assignment &assignment : file.assignments)
+      affected.push_back(assignment.setting);
+    file.assignments.clear();
+    file.specificity = 0;
+    file.always_active = false;
+
+    for (uint32_t setting : affected)
+      reorder(setting, id);
+    refresh(affected);
+  }
+
+  void SettingsResolver::reorder(uint32_t setting, uint32_t file)
+  {
+    std::vector<Candidate> &list = candidates[setting];
+    list.erase(
+        std::remove_if(list.begin(), list.end(),
+                       [file](const Candidate &c)
+                       { return c.file == file; }),
+        list.end());
+
+    const std::vector<Assignment> &assignments = files[file].assignments;
+    for (uint32_t i = 0; i < assignments.size(); i++)
+    {
+      if (assignments[i].setting == setting)
+      {
+        list.push_back(Candidate{file, i});
+        break;
+      }
+    }
+
+    std::stable_sort(list.begin(), list.end(),
+                     [this](const Candidate &a, const Candidate &b)
+                     {
+                       const File &fa = files[a.file];
+                       const File &fb = files[b.file];
+                       if (fa.specificity != fb.specificity)
+                         return fa.specificity > fb.specificity;
+                       return fa.path < fb.path;
+                     });
+  }
+
+  bool SettingsResolver::is_active(const ContextSet &active, uint32_t file) const
+  {
+    return files[file].always_active || active.test(file);
+  }
+
+  const SettingsResolver::Assignment *SettingsResolver::pick(uint32_t setting, const ContextSet &active) const
+  {
+    for (const Candidate &candidate : candidates[setting])
+    {
+      if (is_active(active, candidate.file))
+        return &files[candidate.file].assignments[candidate.assignment];
+    }
+    return nullptr;
+  }
+
+  void SettingsResolver::refresh(const std::vector<uint32_t> &affected)
+  {
+    for (auto &[active, resolution] : cache)
+    {
+      resolution.values.resize(setting_names.size(), nullptr);
+      for (uint32_t setting : affected)
+        resolution.values[setting] = pick(setting, active);
+    }
+  }
+
+  const SettingsResolver::Resolution &SettingsResolver::resolve(const ContextSet &active)
+  {
+    auto [it, inserted] = cache.try_emplace(active);
+    Resolution &resolution = it->second;
+    if (inserted)
+    {
+      resolution.values.resize(setting_names.size(), nullptr);
+      for (uint32_t setting = 0; setting < setting_names.size(); setting++)
+        resolution.values[setting] = pick(setting, active);
+    }
+    return resolution;
+  }
+
+}
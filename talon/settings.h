@@ -0,0 +1,121 @@
+#ifndef TREE_SITTER_TALON_SETTINGS_H_
+#define TREE_SITTER_TALON_SETTINGS_H_
+
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  // A set of active file contexts, with one bit per file id.
+  struct ContextSet
+  {
+    void set(uint32_t id, bool active = true);
+    bool test(uint32_t id) const;
+    bool operator==(const ContextSet &other) const;
+    size_t hash() const;
+
+    std::vector<uint64_t> words;
+  };
+
+  struct ContextSetHash
+  {
+    size_t operator()(const ContextSet &set) const { return set.hash(); }
+  };
+
+  // Resolves the `settings()` blocks of a workspace of talon files.
+  //
+  // Every `assignment_statement` in a `settings_declaration` becomes a
+  // candidate for its setting. Candidates are ordered by the specificity of
+  // their file's `matches` header, i.e., by the number of `match` lines, with
+  // ties broken by path. Files without a header are always active; any other
+  // file is active when its id is set in the ContextSet passed to resolve().
+  //
+  // Resolutions are memoized per ContextSet. When a file changes, only the
+  // settings that it defined before or after the change are recomputed in the
+  // cached resolutions, so lookups stay a single array access.
+  class SettingsResolver
+  {
+  public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    struct Assignment
+    {
+      uint32_t setting;
+      uint32_t file;
+      std::string value;
+      uint32_t start_byte;
+      uint32_t end_byte;
+    };
+
+    // The settings in effect for one ContextSet, indexed by setting id.
+    struct Resolution
+    {
+      const Assignment *get(uint32_t setting) const
+      {
+        return setting < values.size() ? values[setting] : nullptr;
+      }
+
+      std::vector<const Assignment *> values;
+    };
+
+    SettingsResolver();
+    ~SettingsResolver();
+    SettingsResolver(const SettingsResolver &) = delete;
+    SettingsResolver &operator=(const SettingsResolver &) = delete;
+
+    // Parses `source` and replaces whatever was recorded for `path`. Returns
+    // the file id, which is stable for the lifetime of the resolver.
+    uint32_t update_file(std::string_view path, std::string_view source);
+    void remove_file(std::string_view path);
+
+    uint32_t file_id(std::string_view path) const;
+    uint32_t setting_id(std::string_view name) const;
+    const std::string &setting_name(uint32_t setting) const { return setting_names[setting]; }
+    size_t setting_count() const { return setting_names.size(); }
+
+    // The returned reference stays valid until the next call to clear_cache().
+    // It is updated in place by update_file() and remove_file().
+    const Resolution &resolve(const ContextSet &active);
+
+    size_t cache_size() const { return cache.size(); }
+    void clear_cache() { cache.clear(); }
+
+  private:
+    struct File
+    {
+      std::string path;
+      uint32_t specificity = 0;
+      bool always_active = false;
+      std::vector<Assignment> assignments;
+    };
+
+    struct Candidate
+    {
+      uint32_t file;
+      uint32_t assignment;
+    };
+
+    uint32_t intern_setting(std::string_view name);
+    bool is_active(const ContextSet &active, uint32_t file) const;
+    const Assignment *pick(uint32_t setting, const ContextSet &active) const;
+    void reorder(uint32_t setting, uint32_t file);
+    void refresh(const std::vector<uint32_t> &affected);
+
+    TSParser *parser;
+    std::deque<File> files;
+    std::unordered_map<std::string, uint32_t> file_ids;
+    std::vector<std::string> setting_names;
+    std::unordered_map<std::string, uint32_t> setting_ids;
+    std::vector<std::vector<Candidate>> candidates;
+    std::unordered_map<ContextSet, Resolution, ContextSetHash> cache;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_SETTINGS_H_
@@ -0,0 +1,100 @@
+#include "talon/split.h"
+#include "talon/header.h"
+#include <algorithm>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    const size_t npos = std::string_view::npos;
+
+    // Whether the line before `line_start` ends in a backslash, which joins
+    // it with the next line.
+    bool is_continued(std::string_view text, size_t line_start)
+    {
+      if (line_start < 2)
+        return false;
+      size_t end = line_start - 1;
+      if (text[end - 1] == '\r')
+        end--;
+      return end > 0 && text[end - 1] == '\\';
+    }
+
+  }
+
+  size_t find_header_end(std::string_view text, bool at_end)
+  {
+    size_t start = 0;
+    while (start < text.size())
+    {
+      size_t newline = text.find('\n', start);
+      if (newline == npos && !at_end)
+        return 0;
+      size_t end = newline == npos ? text.size() : newline;
+      std::string_view line = text.substr(start, end - start);
+      size_t first = line.find_first_not_of(" \t\r\f");
+      if (talon_is_separator(line.data(), uint32_t(line.size())))
+        return newline == npos ? text.size() : newline + 1;
+      // Matches are never indented, but command bodies are.
+      if (first != npos && first > 0 && line[first] != '#' && !is_continued(text, start))
+        return npos;
+      start = end + 1;
+    }
+    return at_end ? npos : 0;
+  }
+
+  size_t find_declaration_start(std::string_view text, size_t from)
+  {
+    size_t start = from;
+    if (start > 0 && (start > text.size() || text[start - 1] != '\n'))
+    {
+      start = text.find('\n', start > text.size() ? text.size() : start);
+      if (start == npos)
+        return npos;
+      start++;
+    }
+    while (start < text.size())
+    {
+      switch (text[start])
+      {
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+      case '\f':
+      case '#':
+        break;
+      default:
+        if (!is_continued(text, start))
+          return start;
+      }
+      start = text.find('\n', start);
+      if (start == npos)
+        return npos;
+      start++;
+    }
+    return npos;
+  }
+
+  std::vector<size_t> find_split_points(std::string_view text, size_t count)
+  {
+    size_t header_end = find_header_end(text, true);
+    if (header_end == npos)
+      header_end = 0;
+
+    std::vector<size_t> points = {0};
+    for (size_t i = 1; i < count; i++)
+    {
+      size_t target = text.size() / count * i;
+      size_t point = find_declaration_start(text, std::max({target, header_end, points.back() + 1}));
+      if (point == npos)
+        break;
+      points.push_back(point);
+    }
+    points.push_back(text.size());
+    return points;
+  }
+
+}
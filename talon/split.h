@@ -0,0 +1,32 @@
+#ifndef TREE_SITTER_TALON_SPLIT_H_
+#define TREE_SITTER_TALON_SPLIT_H_
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  // Finds where the `matches` header of `text` ends, i.e., the byte after its
+  // line of dashes. Returns std::string_view::npos if `text` has no header,
+  // because an indented line comes before any line of dashes, and 0 if that
+  // cannot be decided from `text` yet. If `at_end` is set, `text` is the whole
+  // file and the result is never 0.
+  size_t find_header_end(std::string_view text, bool at_end);
+
+  // Finds the first line at or after `from` that starts a top-level
+  // declaration: one that begins at column 0 with something other than
+  // whitespace or a comment, and that does not continue a line ending in a
+  // backslash. The text before such a line can be parsed on its own. Returns
+  // std::string_view::npos if there is none. Only valid after the header.
+  size_t find_declaration_start(std::string_view text, size_t from);
+
+  // Cuts the whole file `text` into at most `count` pieces of about equal
+  // size that can be parsed independently, the first of which holds the
+  // header. Returns the start of every piece followed by the size of `text`.
+  std::vector<size_t> find_split_points(std::string_view text, size_t count);
+
+}
+
+#endif // TREE_SITTER_TALON_SPLIT_H_
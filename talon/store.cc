@@ -0,0 +1,170 @@
+#include "talon/store.h"
+#include "talon/language.h"
+#include "talon/util.h"
+
+namespace talon
+{
+
+  namespace
+  {
+
+    void append_string(std::string &out, const std::string &s)
+    {
+      uint32_t size = s.size();
+      out.append((const char *)&size, sizeof(size));
+      out += s;
+    }
+
+    void encode(const RuleIR &rule, std::string &out) { rule.encode(out); }
+
+    void encode(const Program &program, std::string &out) { program.encode(out); }
+
+    void encode(const std::vector<Match> &header, std::string &out)
+    {
+      for (const Match &match : header)
+      {
+        out += char(match.conjunctive | match.negated << 1);
+        append_string(out, match.left);
+        append_string(out, match.right);
+      }
+    }
+
+    // Rules and bodies are stored once each, so equal commands point to the
+    // same ones.
+    void encode(const StoredCommand &command, std::string &out)
+    {
+      const void *parts[] = {command.rule.get(), command.body.get()};
+      out.append((const char *)parts, sizeof(parts));
+    }
+
+    size_t memory_size(const RuleIR &rule)
+    {
+      size_t size = sizeof(RuleIR) + rule.ops.capacity() * sizeof(RuleOp);
+      for (const RuleOp &op : rule.ops)
+        size += heap_size(op.name);
+      return size;
+    }
+
+    size_t memory_size(const Program &program) { return program.memory_size(); }
+
+    size_t memory_size(const std::vector<Match> &header)
+    {
+      size_t size = sizeof(header) + header.capacity() * sizeof(Match);
+      for (const Match &match : header)
+        size += heap_size(match.left) + heap_size(match.right);
+      return size;
+    }
+
+    size_t memory_size(const StoredCommand &) { return sizeof(StoredCommand); }
+
+  }
+
+  template <typename T>
+  std::shared_ptr<const T> DeclarationStore::intern(Table<T> &table, T &&value)
+  {
+    std::string encoding;
+    encode(value, encoding);
+    uint64_t hash = hash_bytes(encoding);
+    table.references++;
+    table.referenced_bytes += memory_size(value);
+
+    auto range = table.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second;)
+    {
+      std::shared_ptr<const T> existing = it->second.lock();
+      if (!existing)
+      {
+        it = table.entries.erase(it);
+        continue;
+      }
+      std::string other;
+      encode(*existing, other);
+      if (other == encoding)
+        return existing;
+      ++it;
+    }
+    // Not make_shared, whose single allocation would outlive the value for as
+    // long as the table holds the weak reference.
+    std::shared_ptr<const T> stored(new T(std::move(value)));
+    table.entries.emplace(hash, stored);
+    return stored;
+  }
+
+  template <typename T>
+  DeclarationStore::KindStats DeclarationStore::table_stats(const Table<T> &table)
+  {
+    KindStats stats;
+    stats.references = table.references;
+    stats.referenced_bytes = table.referenced_bytes;
+    for (const auto &entry : table.entries)
+    {
+      std::shared_ptr<const T> value = entry.second.lock();
+      if (!value)
+        continue;
+      stats.unique++;
+      stats.stored_bytes += memory_size(*value);
+    }
+    return stats;
+  }
+
+  StoredFile DeclarationStore::add_file(TSNode root, std::string_view source)
+  {
+    const Symbols &s = symbols();
+    StoredFile file;
+    file.header = intern(headers, read_matches(root, source));
+
+    Compiler compiler(action_table);
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode declarations = ts_node_named_child(root, i);
+      if (ts_node_symbol(declarations) != s.declarations)
+        continue;
+      uint32_t declaration_count = ts_node_named_child_count(declarations);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(declarations, j);
+        if (ts_node_symbol(declaration) != s.command_declaration)
+          continue;
+        StoredCommand command;
+        RuleIR rule;
+        if (compile_rule(ts_node_child_by_field_id(declaration, s.left), source, rule))
+          command.rule = intern(rules, std::move(rule));
+        else
+          failures++;
+        Program program;
+        if (compiler.compile(ts_node_child_by_field_id(declaration, s.right), source, program))
+          command.body = intern(bodies, std::move(program));
+        else
+          failures++;
+        file.commands.push_back(intern(commands, std::move(command)));
+      }
+    }
+    return file;
+  }
+
+  DeclarationStore::Stats DeclarationStore::stats() const
+  {
+    Stats result;
+    result.rules = table_stats(rules);
+    result.bodies = table_stats(bodies);
+    result.headers = table_stats(headers);
+    result.commands = table_stats(commands);
+    result.failures = failures;
+    return result;
+  }
+
+  void DeclarationStore::collect()
+  {
+    auto collect_table = [](auto &table)
+    {
+      for (auto it = table.entries.begin(); it != table.entries.end();)
+        it = it->second.expired() ? table.entries.erase(it) : std::next(it);
+    };
+    collect_table(rules);
+    collect_table(bodies);
+    collect_table(headers);
+    collect_table(commands);
+  }
+
+}
@@ -0,0 +1,98 @@
+#ifndef TREE_SITTER_TALON_STORE_H_
+#define TREE_SITTER_TALON_STORE_H_
+
+#include "talon/bytecode.h"
+#include "talon/context.h"
+#include "talon/rule.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace talon
+{
+
+  // The compiled parts of a `command_declaration`. Either is NULL if it did
+  // not compile.
+  struct StoredCommand
+  {
+    std::shared_ptr<const RuleIR> rule;
+    std::shared_ptr<const Program> body;
+  };
+
+  struct StoredFile
+  {
+    std::shared_ptr<const std::vector<Match>> header;
+    std::vector<std::shared_ptr<const StoredCommand>> commands;
+  };
+
+  // Content-addressed storage for the compiled parts of talon files, so that
+  // equal rules, bodies, headers and whole commands are stored once however
+  // many files, users and revisions have them. A value is found by the hash of
+  // its canonical encoding and confirmed by comparing encodings. The store
+  // holds weak references only: a value is freed with the last file that uses
+  // it. All bodies are compiled against the store's ActionTable, so that equal
+  // bodies have equal action ids.
+  class DeclarationStore
+  {
+  public:
+    struct KindStats
+    {
+      // Every value added, and the bytes they would take if none were shared.
+      uint64_t references = 0;
+      uint64_t referenced_bytes = 0;
+      // The distinct values still alive, and the bytes they take.
+      uint64_t unique = 0;
+      uint64_t stored_bytes = 0;
+    };
+
+    struct Stats
+    {
+      KindStats rules;
+      KindStats bodies;
+      KindStats headers;
+      KindStats commands;
+      // Rules or bodies that did not compile.
+      uint64_t failures = 0;
+    };
+
+    // Compiles the header and commands of the file below `root`, which must be
+    // the `source_file` node, and returns them from the store.
+    StoredFile add_file(TSNode root, std::string_view source);
+
+    Stats stats() const;
+
+    // Forgets the values that no file uses anymore.
+    void collect();
+
+    const ActionTable &actions() const { return action_table; }
+
+  private:
+    template <typename T>
+    struct Table
+    {
+      std::unordered_multimap<uint64_t, std::weak_ptr<const T>> entries;
+      uint64_t references = 0;
+      uint64_t referenced_bytes = 0;
+    };
+
+    template <typename T>
+    std::shared_ptr<const T> intern(Table<T> &table, T &&value);
+
+    template <typename T>
+    static KindStats table_stats(const Table<T> &table);
+
+    Table<RuleIR> rules;
+    Table<Program> bodies;
+    Table<std::vector<Match>> headers;
+    Table<StoredCommand> commands;
+    uint64_t failures = 0;
+    ActionTable action_table;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_STORE_H_
@@ -0,0 +1,151 @@
+#include "talon/stream.h"
+#include "talon/language.h"
+#include "talon/split.h"
+#include <algorithm>
+
+namespace talon
+{
+
+  namespace
+  {
+
+    const char *read_buffer(void *payload, uint32_t byte, TSPoint, uint32_t *bytes_read)
+    {
+      std::string_view *text = static_cast<std::string_view *>(payload);
+      if (byte >= text->size())
+      {
+        *bytes_read = 0;
+        return "";
+      }
+      *bytes_read = text->size() - byte;
+      return text->data() + byte;
+    }
+
+  }
+
+  DeclarationStream::DeclarationStream(size_t chunk_size)
+      : parser(ts_parser_new()), chunk_size(std::max<size_t>(chunk_size, 1))
+  {
+    ts_parser_set_language(parser, tree_sitter_talon());
+  }
+
+  DeclarationStream::~DeclarationStream() { ts_parser_delete(parser); }
+
+  bool DeclarationStream::fill(const Reader &read)
+  {
+    size_t size = buffer.size();
+    buffer.resize(size + chunk_size);
+    size_t count = read(&buffer[size], chunk_size);
+    buffer.resize(size + count);
+    peak_size = std::max(peak_size, buffer.size());
+    at_end = count == 0;
+    return count > 0;
+  }
+
+  // Parses the first `end` bytes of the buffer, reports their top-level nodes
+  // and drops them.
+  bool DeclarationStream::parse(size_t end, StreamEvent::Kind kind, const Callback &callback)
+  {
+    const Symbols &s = symbols();
+    std::string_view source(buffer.data(), end);
+    TSInput input = {&source, read_buffer, TSInputEncodingUTF8};
+    TSTree *tree = ts_parser_parse(parser, NULL, input);
+    if (!tree)
+    {
+      ts_parser_reset(parser);
+      message = "Parsing was cancelled";
+      return false;
+    }
+
+    StreamEvent event;
+    event.source = source;
+    event.offset = offset;
+    event.row = row;
+    TSNode root = ts_tree_root_node(tree);
+    uint32_t count = ts_node_named_child_count(root);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      TSSymbol symbol = ts_node_symbol(child);
+      event.kind = kind;
+      event.rule = TSNode{};
+      event.body_start = event.body_end = 0;
+      if (symbol == s.matches)
+      {
+        event.kind = StreamEvent::HEADER;
+        event.node = child;
+        callback(event);
+        continue;
+      }
+      if (symbol != s.declarations)
+      {
+        event.node = child;
+        if (symbol != s.comment)
+          callback(event);
+        continue;
+      }
+      uint32_t declaration_count = ts_node_named_child_count(child);
+      for (uint32_t j = 0; j < declaration_count; j++)
+      {
+        TSNode declaration = ts_node_named_child(child, j);
+        if (ts_node_symbol(declaration) == s.comment)
+          continue;
+        TSNode body = ts_node_child_by_field_id(declaration, s.right);
+        event.kind = StreamEvent::DECLARATION;
+        event.node = declaration;
+        event.rule = ts_node_child_by_field_id(declaration, s.left);
+        event.body_start = ts_node_is_null(body) ? 0 : offset + ts_node_start_byte(body);
+        event.body_end = ts_node_is_null(body) ? 0 : offset + ts_node_end_byte(body);
+        callback(event);
+      }
+    }
+    ts_tree_delete(tree);
+
+    offset += end;
+    row += std::count(buffer.begin(), buffer.begin() + end, '\n');
+    buffer.erase(0, end);
+    return true;
+  }
+
+  bool DeclarationStream::run(const Reader &read, const Callback &callback)
+  {
+    buffer.clear();
+    offset = 0;
+    row = 0;
+    at_end = false;
+    peak_size = 0;
+    message.clear();
+
+    // The header is parsed on its own, so that the pieces after it parse as
+    // declarations only.
+    size_t header_end;
+    while ((header_end = find_header_end(buffer, at_end)) == 0 && buffer.size() < max_header_size)
+      fill(read);
+    if (header_end != 0 && header_end != std::string_view::npos &&
+        !parse(header_end, StreamEvent::HEADER, callback))
+      return false;
+
+    // Lines that were already searched for a split point are not searched
+    // again when a declaration spans several chunks.
+    size_t from = chunk_size;
+    while (!buffer.empty() || !at_end)
+    {
+      size_t end = find_declaration_start(buffer, from);
+      if (end == std::string_view::npos)
+      {
+        if (!at_end)
+        {
+          from = std::max(chunk_size, buffer.size());
+          fill(read);
+          continue;
+        }
+        end = buffer.size();
+      }
+      if (!parse(end, StreamEvent::DECLARATION, callback))
+        return false;
+      from = chunk_size;
+    }
+    return true;
+  }
+
+}
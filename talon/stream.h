@@ -0,0 +1,88 @@
+#ifndef TREE_SITTER_TALON_STREAM_H_
+#define TREE_SITTER_TALON_STREAM_H_
+
+#include "talon/header.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace talon
+{
+
+  // A top-level node of a streamed file. The nodes and the source they were
+  // parsed from are only valid during the callback.
+  struct StreamEvent
+  {
+    enum Kind
+    {
+      HEADER,      // `node` is the `matches` node
+      DECLARATION, // `node` is a declaration, or an ERROR between declarations
+    };
+
+    Kind kind;
+    TSNode node;
+    // The `left` field of a declaration, e.g., its rule.
+    TSNode rule;
+    // The text that `node` was parsed from, and its position in the file.
+    std::string_view source;
+    uint64_t offset;
+    uint32_t row;
+    // The `right` field of a declaration, in bytes from the start of the file.
+    uint64_t body_start;
+    uint64_t body_end;
+
+    uint64_t start_byte() const { return offset + ts_node_start_byte(node); }
+    uint64_t end_byte() const { return offset + ts_node_end_byte(node); }
+    std::string_view text(TSNode n) const
+    {
+      return source.substr(ts_node_start_byte(n), ts_node_end_byte(n) - ts_node_start_byte(n));
+    }
+  };
+
+  // Extracts the top-level declarations of a file of any size in bounded
+  // memory. The file is read in chunks and cut before top-level declarations
+  // (see talon/split.h) into pieces of about `chunk_size` bytes, which are
+  // parsed one at a time and discarded once their declarations are reported.
+  // Memory use is bounded by the chunk size plus the largest declaration.
+  //
+  // A header is only recognized within the first `max_header_size` bytes.
+  class DeclarationStream
+  {
+  public:
+    static const size_t max_header_size = TALON_MAX_HEADER_SIZE;
+
+    // Fills `buffer` with up to `capacity` bytes and returns how many it
+    // wrote, or 0 at the end of the file.
+    using Reader = std::function<size_t(char *buffer, size_t capacity)>;
+    using Callback = std::function<void(const StreamEvent &)>;
+
+    explicit DeclarationStream(size_t chunk_size = 64 << 10);
+    ~DeclarationStream();
+    DeclarationStream(const DeclarationStream &) = delete;
+    DeclarationStream &operator=(const DeclarationStream &) = delete;
+
+    bool run(const Reader &read, const Callback &callback);
+
+    const std::string &error() const { return message; }
+    // The largest number of bytes buffered at once in the last run.
+    size_t peak_buffer_size() const { return peak_size; }
+
+  private:
+    bool fill(const Reader &read);
+    bool parse(size_t end, StreamEvent::Kind kind, const Callback &callback);
+
+    TSParser *parser;
+    size_t chunk_size;
+    std::string buffer;
+    uint64_t offset = 0;
+    uint32_t row = 0;
+    bool at_end = false;
+    size_t peak_size = 0;
+    std::string message;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_STREAM_H_
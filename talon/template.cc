@@ -0,0 +1,112 @@
+#include "talon/template.h"
+#include "talon/escape.h"
+#include "talon/language.h"
+
+namespace talon
+{
+
+  void TemplateSet::add_literal(std::string_view text)
+  {
+    // Extend the previous segment when it is a literal of this template.
+    const Entry &entry = templates.back();
+    if (segments.size() > entry.first_segment && segments.back().slot == LITERAL)
+      segments.back().length += text.size();
+    else
+      segments.push_back(Segment{LITERAL, uint32_t(arena.size()), uint32_t(text.size())});
+    arena += text;
+    templates.back().literal_length += text.size();
+  }
+
+  void TemplateSet::decode_escape(std::string_view sequence)
+  {
+    // Escape sequences are at most ten bytes, and never grow when decoded.
+    char decoded[16];
+    size_t length = sequence.size() <= sizeof(decoded)
+                        ? decode_escapes(sequence.data(), sequence.size(), decoded)
+                        : 0;
+    if (length > 0)
+      add_literal(std::string_view(decoded, length));
+  }
+
+  uint32_t TemplateSet::compile(TSNode string, std::string_view source, std::vector<TSNode> &slots)
+  {
+    const Symbols &s = symbols();
+    templates.push_back(Entry{uint32_t(segments.size()), 0, 0, 0});
+
+    uint32_t count = ts_node_named_child_count(string);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode child = ts_node_named_child(string, i);
+      TSSymbol symbol = ts_node_symbol(child);
+      std::string_view text = node_text(source, child);
+
+      if (symbol == s.string_content)
+      { // The scanner stops string content at braces, so "{{" and "}}" can
+        // only be escaped braces.
+        if (text == "{{" || text == "}}")
+          add_literal(text.substr(0, 1));
+        else
+          add_literal(text);
+      }
+      else if (symbol == s.string_escape_sequence)
+      {
+        decode_escape(text);
+      }
+      else if (symbol == s.interpolation)
+      {
+        Entry &entry = templates.back();
+        segments.push_back(Segment{entry.slot_count++, 0, 0});
+        TSNode expression = ts_node_named_child(child, 0);
+        for (uint32_t j = 1; ts_node_is_extra(expression) && j < ts_node_named_child_count(child); j++)
+          expression = ts_node_named_child(child, j);
+        slots.push_back(expression);
+      }
+    }
+
+    Entry &entry = templates.back();
+    entry.segment_count = segments.size() - entry.first_segment;
+    return templates.size() - 1;
+  }
+
+  void TemplateSet::format(uint32_t id, const Value *values, std::string &out) const
+  {
+    const Entry &entry = templates[id];
+    out.reserve(out.size() + entry.literal_length + 16 * entry.slot_count);
+
+    const char *literals = arena.data();
+    const Segment *segment = segments.data() + entry.first_segment;
+    const Segment *end = segment + entry.segment_count;
+    for (; segment != end; segment++)
+    {
+      if (segment->slot == LITERAL)
+        out.append(literals + segment->offset, segment->length);
+      else
+        append_value(out, values[segment->slot]);
+    }
+  }
+
+  void TemplateSet::encode(std::string &out) const
+  {
+    auto append = [&](uint32_t value) { out.append((const char *)&value, sizeof(value)); };
+    append(templates.size());
+    for (const Entry &entry : templates)
+    {
+      append(entry.segment_count);
+      append(entry.slot_count);
+      for (uint32_t i = entry.first_segment; i < entry.first_segment + entry.segment_count; i++)
+      {
+        const Segment &segment = segments[i];
+        append(segment.slot);
+        if (segment.slot != LITERAL)
+          continue;
+        append(segment.length);
+        out.append(arena, segment.offset, segment.length);
+      }
+    }
+  }
+
+  size_t TemplateSet::memory_size() const
+  {
+    return arena.capacity() + segments.capacity() * sizeof(Segment) + templates.capacity() * sizeof(Entry);
+  }
+}
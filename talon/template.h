@@ -0,0 +1,67 @@
+#ifndef TREE_SITTER_TALON_TEMPLATE_H_
+#define TREE_SITTER_TALON_TEMPLATE_H_
+
+#include "talon/value.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace talon
+{
+
+  // Precompiled `string` nodes.
+  //
+  // Compiling a string decodes its escape sequences and `{{`/`}}` braces once,
+  // and stores the resulting literal text in a single arena shared by every
+  // template in the set. Each `interpolation` becomes a numbered slot. Formatting
+  // a template is then a single pass of appends, without re-reading the source.
+  class TemplateSet
+  {
+  public:
+    static constexpr uint32_t LITERAL = UINT32_MAX;
+
+    struct Segment
+    {
+      uint32_t slot; // LITERAL, or the index of the interpolation
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    // Compiles a `string` node and returns its id. The expressions of its
+    // interpolations are appended to `slots`, in slot order.
+    uint32_t compile(TSNode string, std::string_view source, std::vector<TSNode> &slots);
+
+    // Appends the template with its slots filled in from `values`.
+    void format(uint32_t id, const Value *values, std::string &out) const;
+
+    size_t size() const { return templates.size(); }
+    uint32_t slot_count(uint32_t id) const { return templates[id].slot_count; }
+    const std::string &literals() const { return arena; }
+
+    // Appends a canonical encoding, equal for sets that format alike.
+    void encode(std::string &out) const;
+    // The bytes the set holds on the heap.
+    size_t memory_size() const;
+
+  private:
+    struct Entry
+    {
+      uint32_t first_segment;
+      uint32_t segment_count;
+      uint32_t slot_count;
+      uint32_t literal_length;
+    };
+
+    void add_literal(std::string_view text);
+    void decode_escape(std::string_view sequence);
+
+    std::string arena;
+    std::vector<Segment> segments;
+    std::vector<Entry> templates;
+  };
+
+}
+
+#endif // TREE_SITTER_TALON_TEMPLATE_H_
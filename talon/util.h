@@ -0,0 +1,45 @@
+#ifndef TREE_SITTER_TALON_UTIL_H_
+#define TREE_SITTER_TALON_UTIL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace talon
+{
+
+  // 64-bit FNV-1a of `bytes`.
+  inline uint64_t hash_bytes(std::string_view bytes)
+  {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes)
+    {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // The splitmix64 finalizer applied to `hash` plus a multiple of `value`.
+  // Chaining it depends on the order of the values, and every seed `value`
+  // gives an independent hash.
+  inline uint64_t mix(uint64_t hash, uint64_t value)
+  {
+    uint64_t z = hash + value * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // The heap bytes of a string, or 0 while its characters fit in the small-
+  // string buffer inside the object, whatever size the library gives it.
+  inline size_t heap_size(const std::string &s)
+  {
+    uintptr_t data = uintptr_t(s.data()), object = uintptr_t(&s);
+    return data >= object && data < object + sizeof(s) ? 0 : s.capacity() + 1;
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_UTIL_H_
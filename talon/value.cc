@@ -0,0 +1,96 @@
+#include "talon/value.h"
+#include <charconv>
+#include <cmath>
+#include <string_view>
+
+namespace talon
+{
+
+  bool Value::truthy() const
+  {
+    switch (type)
+    {
+    case INT:
+      return i != 0;
+    case FLOAT:
+      return f != 0;
+    case STRING:
+      return !s.empty();
+    default:
+      return false;
+    }
+  }
+
+  void append_value(std::string &out, const Value &value)
+  {
+    switch (value.type)
+    {
+    case Value::NONE:
+      out += "None";
+      break;
+    case Value::INT:
+      out += std::to_string(value.i);
+      break;
+    case Value::FLOAT:
+    {
+      if (std::isnan(value.f))
+      {
+        out += "nan";
+        break;
+      }
+      if (std::isinf(value.f))
+      {
+        out += value.f < 0 ? "-inf" : "inf";
+        break;
+      }
+      // Like Python's repr(): the shortest digits that read back the same,
+      // in fixed notation with at least one decimal if 1e-4 <= |f| < 1e16,
+      // and otherwise as e.g. 1e+16 or 1.5e-05.
+      char buffer[32];
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.f, std::chars_format::scientific);
+      std::string_view text(buffer, result.ptr - buffer);
+      size_t e = text.find('e');
+      int exponent = 0;
+      const char *sign = buffer + e + 1;
+      std::from_chars(sign + (*sign == '+'), result.ptr, exponent);
+      if (exponent < -4 || exponent >= 16)
+      {
+        out += text;
+        break;
+      }
+      if (text[0] == '-')
+      {
+        out += '-';
+        text.remove_prefix(1);
+        e--;
+      }
+      std::string digits(text.substr(0, 1));
+      if (e > 1)
+        digits += text.substr(2, e - 2);
+      if (exponent < 0)
+      {
+        out += "0.";
+        out.append(-exponent - 1, '0');
+        out += digits;
+      }
+      else if (digits.size() > size_t(exponent) + 1)
+      {
+        out.append(digits, 0, exponent + 1);
+        out += '.';
+        out.append(digits, exponent + 1);
+      }
+      else
+      {
+        out += digits;
+        out.append(exponent + 1 - digits.size(), '0');
+        out += ".0";
+      }
+      break;
+    }
+    case Value::STRING:
+      out += value.s;
+      break;
+    }
+  }
+
+}
@@ -0,0 +1,57 @@
+#ifndef TREE_SITTER_TALON_VALUE_H_
+#define TREE_SITTER_TALON_VALUE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace talon
+{
+
+  // A runtime value of a command body.
+  struct Value
+  {
+    enum Type : uint8_t
+    {
+      NONE,
+      INT,
+      FLOAT,
+      STRING,
+    };
+
+    Value() : type(NONE), i(0), f(0) {}
+    static Value of_int(int64_t i)
+    {
+      Value v;
+      v.type = INT;
+      v.i = i;
+      return v;
+    }
+    static Value of_float(double f)
+    {
+      Value v;
+      v.type = FLOAT;
+      v.f = f;
+      return v;
+    }
+    static Value of_string(std::string s)
+    {
+      Value v;
+      v.type = STRING;
+      v.s = std::move(s);
+      return v;
+    }
+
+    bool truthy() const;
+
+    Type type;
+    int64_t i;
+    double f;
+    std::string s;
+  };
+
+  // Appends the value as Python's str() would format it.
+  void append_value(std::string &out, const Value &value);
+
+}
+
+#endif // TREE_SITTER_TALON_VALUE_H_
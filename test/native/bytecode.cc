@@ -0,0 +1,187 @@
+// Test for talon/bytecode.h.
+//
+// Compiles and runs command bodies of arithmetic, string operations and
+// action calls, and checks the variables they leave and the actions they
+// call. Then checks that every failure the grammar can reach is reported:
+// literals that do not fit a value and bodies with too many registers when
+// compiling, and operands Python rejects, division by zero, integer overflow,
+// oversized repeats and unbound actions when running.
+
+#include "talon/bytecode.h"
+#include "talon/language.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <map>
+
+namespace
+{
+
+  struct Run
+  {
+    bool compiled = false;
+    bool ran = false;
+    std::string error;
+    // Variables and action calls, formatted by append_value.
+    std::map<std::string, std::string> variables;
+    std::vector<std::string> calls;
+  };
+
+  // Compiles `body`, one statement per line, as the body of a command, and
+  // runs it with every action bound except `unbound`. An action returns the
+  // number of its arguments.
+  Run run(const std::string &body, const std::string &unbound = "")
+  {
+    std::string source = "test:\n";
+    for (size_t start = 0; start < body.size();)
+    {
+      size_t end = body.find('\n', start);
+      if (end == std::string::npos)
+        end = body.size();
+      source += "    " + body.substr(start, end - start) + "\n";
+      start = end + 1;
+    }
+
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_talon());
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode declarations = ts_node_named_child(ts_tree_root_node(tree), 0);
+    TSNode block = ts_node_child_by_field_id(ts_node_named_child(declarations, 0), talon::symbols().right);
+
+    Run result;
+    talon::ActionTable actions;
+    talon::Compiler compiler(actions);
+    talon::Program program;
+    result.compiled = !ts_node_is_null(block) && compiler.compile(block, source, program);
+    result.error = compiler.error();
+    ts_tree_delete(tree);
+    ts_parser_delete(parser);
+    if (!result.compiled)
+      return result;
+
+    talon::VM vm;
+    for (uint32_t id = 0; id < actions.size(); id++)
+    {
+      if (actions.name(id) == unbound)
+        continue;
+      vm.bind(id,
+              [&result, &actions, id](const talon::Value *args, uint32_t argc)
+              {
+                std::string call = actions.name(id) + "(";
+                for (uint32_t i = 0; i < argc; i++)
+                {
+                  call += i > 0 ? ", " : "";
+                  talon::append_value(call, args[i]);
+                }
+                result.calls.push_back(call + ")");
+                return talon::Value::of_int(argc);
+              });
+    }
+    std::vector<talon::Value> variables(program.variables.size());
+    result.ran = vm.run(program, variables.data());
+    result.error = vm.error();
+    for (size_t i = 0; i < variables.size(); i++)
+      talon::append_value(result.variables[program.variables[i]], variables[i]);
+    return result;
+  }
+
+  void expect_variables(const std::string &body, const std::map<std::string, std::string> &expected)
+  {
+    Run result = run(body);
+    if (!result.compiled || !result.ran)
+    {
+      test::fail("%s: %s", body.c_str(), result.error.c_str());
+      return;
+    }
+    for (const auto &[name, value] : expected)
+    {
+      auto it = result.variables.find(name);
+      std::string actual = it == result.variables.end() ? "<unset>" : it->second;
+      if (actual != value)
+        test::fail("%s: %s is %s, expected %s", body.c_str(), name.c_str(), actual.c_str(), value.c_str());
+    }
+  }
+
+  void expect_compile_error(const std::string &body, const std::string &error)
+  {
+    Run result = run(body);
+    if (result.compiled || result.error.find(error) != 0)
+      test::fail("%s: compiling gave \"%s\", expected \"%s\"", body.c_str(), result.error.c_str(), error.c_str());
+  }
+
+  void expect_run_error(const std::string &body, const std::string &error, const std::string &unbound = "")
+  {
+    Run result = run(body, unbound);
+    if (!result.compiled || result.ran || result.error != error)
+      test::fail("%s: running gave \"%s\", expected \"%s\"", body.c_str(), result.error.c_str(), error.c_str());
+  }
+
+}
+
+int main()
+{
+  // Arithmetic, with Python's precedence, division and modulo.
+  expect_variables("x = 5 + 3 * 2\ny = (5 + 3) * 2\nz = x - y - 1",
+                   {{"x", "11"}, {"y", "16"}, {"z", "-6"}});
+  expect_variables("a = 7 / 2\nb = 6 / 3\nc = 7 % 3\nd = -7 % 3\ne = 7 % -3\nf = -(2)",
+                   {{"a", "3.5"}, {"b", "2.0"}, {"c", "1"}, {"d", "2"}, {"e", "-2"}, {"f", "-2"}});
+  expect_variables("a = 2.5 * 2\nb = 1 + 0.5\nc = -7.5 % 2\nd = 1e16 + 1\ne = 0.0001 * 1",
+                   {{"a", "5.0"}, {"b", "1.5"}, {"c", "0.5"}, {"d", "1e+16"}, {"e", "0.0001"}});
+  // A zero remainder takes the sign of the divisor, as in Python.
+  expect_variables("a = -4.0 % 2.0\nb = 4.0 % -2.0\nc = -4.0 % -2.0",
+                   {{"a", "0.0"}, {"b", "-0.0"}, {"c", "-0.0"}});
+  expect_variables("a = 0x10 + 0o10 + 0b10 + 1_000\nb = 9223372036854775807\n"
+                   "c = -9223372036854775807 - 1\nd = c % -1",
+                   {{"a", "1026"}, {"b", "9223372036854775807"}, {"c", "-9223372036854775808"}, {"d", "0"}});
+  // `or` evaluates its right operand only when the left one is falsy.
+  expect_variables("a = 0 or 4\nb = 3 or user.never()\nc = \"\" or \"x\"\nd = 0.0 or 0",
+                   {{"a", "4"}, {"b", "3"}, {"c", "x"}, {"d", "0"}});
+  test::expect(run("b = 3 or user.never()").calls.empty(), "or evaluated its right operand");
+
+  // Strings.
+  expect_variables("a = \"ab\" + \"cd\"\nb = \"ab\" * 3\nc = 2 * \"x\"\nd = \"ab\" * 0\ne = \"ab\" * -1",
+                   {{"a", "abcd"}, {"b", "ababab"}, {"c", "xx"}, {"d", ""}, {"e", ""}});
+  expect_variables("n = 7 / 2\ns = \"n={n}, {n * 2}, {1 + 1} {{n}}\\t.\"",
+                   {{"s", "n=3.5, 7.0, 2 {n}\t."}});
+
+  // Actions, with their arguments in registers and their results assigned.
+  Run calls = run("key(ctrl-a)\nsleep(50ms)\nr = user.f(1, \"two\", 3.0)\nuser.g(r + 1)");
+  test::expect(calls.ran, "actions: " + calls.error);
+  const std::vector<std::string> expected_calls = {"key(ctrl-a)", "sleep(50ms)", "user.f(1, two, 3.0)", "user.g(4)"};
+  test::expect(calls.calls == expected_calls, "actions called");
+  test::expect(calls.variables["r"] == "3", "action result");
+
+  // Compile errors.
+  expect_compile_error("x = 2j", "Unsupported imaginary number");
+  expect_compile_error("x = 1.5j", "Unsupported imaginary number");
+  expect_compile_error("x = 9223372036854775808", "Integer is too large");
+  expect_compile_error("x = 99999999999999999999999", "Integer is too large");
+  std::string arguments = "0";
+  for (int i = 1; i < 300; i++)
+    arguments += ", " + std::to_string(i);
+  expect_compile_error("user.f(" + arguments + ")", "Command body is too large to compile");
+  std::string nested = "0";
+  for (int i = 1; i < 300; i++)
+    nested = "1 + (" + nested + ")";
+  expect_compile_error("x = " + nested, "Command body is too large to compile");
+
+  // Run errors.
+  const std::string unsupported = "Unsupported operands or overflow";
+  expect_run_error("x = 1 / 0", unsupported);
+  expect_run_error("x = 1 % 0", unsupported);
+  expect_run_error("x = 1.5 / 0", unsupported);
+  expect_run_error("x = 1.5 % 0.0", unsupported);
+  expect_run_error("x = 9223372036854775807 + 1", unsupported);
+  expect_run_error("x = -9223372036854775807 - 2", unsupported);
+  expect_run_error("x = 3037000500 * 3037000500", unsupported);
+  expect_run_error("x = \"a\" - 1", unsupported);
+  expect_run_error("x = \"a\" + 1", unsupported);
+  expect_run_error("x = \"a\" * 1.5", unsupported);
+  expect_run_error("x = \"a\" * \"b\"", unsupported);
+  expect_run_error("x = \"ab\" * " + std::to_string(talon::max_string_size), unsupported);
+  expect_run_error("x = -9223372036854775807 - 1\ny = -x", "Integer overflow");
+  expect_run_error("x = -\"a\"", "Unsupported operand");
+  expect_run_error("user.f()\nuser.missing()", "Unbound action", "user.missing");
+
+  std::printf("%d failures\n", test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,127 @@
+// Test for talon/columnar.h.
+//
+// Exports every corpus test as a file, maps the export, and checks every node
+// against a walk of the tree: symbol name, byte range, parent and text, and
+// the field of every child that ts_node_child_by_field_id finds. Then checks
+// that a truncated export and a file of another kind do not open.
+
+#include "talon/columnar.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace
+{
+
+  struct Node
+  {
+    TSNode node;
+    uint32_t parent;
+  };
+
+  // The nodes below `node` in preorder, with the index of their parent.
+  void preorder(TSNode node, uint32_t parent, std::vector<Node> &out)
+  {
+    uint32_t index = out.size();
+    out.push_back({node, parent});
+    for (uint32_t i = 0; i < ts_node_child_count(node); i++)
+      preorder(ts_node_child(node, i), index, out);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  std::vector<test::Example> examples = test::load_corpus(corpus_path);
+  std::vector<TSTree *> trees;
+  talon::ColumnarWriter writer;
+  for (size_t i = 0; i < examples.size(); i++)
+  {
+    const std::string &source = examples[i].source;
+    trees.push_back(ts_parser_parse_string(parser, NULL, source.data(), source.size()));
+    writer.add_file(examples[i].file + "/" + examples[i].name, ts_tree_root_node(trees.back()), source);
+  }
+  std::string name = "tree-sitter-talon-" + std::to_string(getpid());
+  std::string path = (std::filesystem::temp_directory_path() / name).string();
+  test::expect(writer.write(path), "write failed: " + writer.error());
+
+  talon::ColumnarFile file;
+  test::expect(file.open(path), "open failed: " + file.error());
+  test::expect(file.file_count() == examples.size(), "file count");
+  test::expect(file.node_count() == writer.node_count(), "node count");
+  size_t compared = 0;
+  for (uint32_t f = 0; f < file.file_count() && f < examples.size(); f++)
+  {
+    const std::string &source = examples[f].source;
+    const talon::ColumnarFileEntry &entry = file.file(f);
+    std::string where = examples[f].file + ": " + examples[f].name;
+    test::expect(file.file_name(f) == examples[f].file + "/" + examples[f].name, "file name of " + where);
+    std::vector<Node> nodes;
+    preorder(ts_tree_root_node(trees[f]), talon::COLUMNAR_NONE, nodes);
+    if (entry.node_count != nodes.size() || entry.byte_count != source.size())
+    {
+      test::expect(false, "node or byte count of " + where);
+      continue;
+    }
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+      TSNode node = nodes[i].node;
+      uint32_t n = entry.first_node + i;
+      std::string at = where + " at node " + std::to_string(i);
+      test::expect(file.symbols()[n] == ts_node_symbol(node), "symbol of " + at);
+      test::expect(file.symbol_name(file.symbols()[n]) == ts_node_type(node), "symbol name of " + at);
+      uint32_t start = ts_node_start_byte(node), end = ts_node_end_byte(node);
+      test::expect(file.start_bytes()[n] == start && file.end_bytes()[n] == end, "range of " + at);
+      test::expect(file.parents()[n] == nodes[i].parent, "parent of " + at);
+      bool named_leaf = ts_node_is_named(node) && ts_node_child_count(node) == 0;
+      if (named_leaf)
+        test::expect(file.text(file.text_ids()[n]) == source.substr(start, end - start), "text of " + at);
+      else
+        test::expect(file.text_ids()[n] == talon::COLUMNAR_NONE, "text of inner node or token " + at);
+      compared++;
+    }
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+      for (TSFieldId field = 1; field <= ts_language_field_count(tree_sitter_talon()); field++)
+      {
+        TSNode child = ts_node_child_by_field_id(nodes[i].node, field);
+        if (ts_node_is_null(child))
+          continue;
+        uint32_t j = i + 1;
+        while (j < nodes.size() && !ts_node_eq(nodes[j].node, child))
+          j++;
+        bool found = j < nodes.size() && nodes[j].parent == i;
+        std::string at = where + " at node " + std::to_string(i);
+        test::expect(found && file.fields()[entry.first_node + j] == field,
+                     "field " + std::string(file.field_name(field)) + " of " + at);
+      }
+    }
+  }
+  const talon::Symbols &s = talon::symbols();
+  test::expect(file.find_symbol("command_declaration") == s.command_declaration, "find_symbol");
+  test::expect(file.find_field("action_name") == s.action_name, "find_field");
+  test::expect(file.find_symbol("no_such_symbol") == talon::COLUMNAR_NONE, "find_symbol of a missing name");
+
+  for (TSTree *tree : trees)
+    ts_tree_delete(tree);
+  ts_parser_delete(parser);
+
+  // A truncated export.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  test::expect(!file.open(path), "a truncated export opened");
+  test::expect(file.node_count() == 0, "a failed open left nodes");
+  // A file of another kind.
+  std::ofstream(path, std::ios::binary) << "match: app.name() == \"foo\"\n-\nhello: key(a)\n";
+  test::expect(!file.open(path), "a talon file opened");
+  std::filesystem::remove(path);
+
+  std::printf("%zu files, %zu nodes compared, %d failures\n", examples.size(), compared, test::failures.load());
+  return test::status();
+}
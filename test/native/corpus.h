@@ -0,0 +1,102 @@
+#ifndef TREE_SITTER_TALON_TEST_NATIVE_CORPUS_H_
+#define TREE_SITTER_TALON_TEST_NATIVE_CORPUS_H_
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace test
+{
+
+  // One test from a tree-sitter corpus file.
+  struct Example
+  {
+    std::string file;  // e.g., "knausj_talon/commands.txt"
+    std::string group; // the corpus file name without extension, e.g., "commands"
+    std::string name;
+    std::string source;
+  };
+
+  inline bool is_rule(const std::string &line, char c)
+  {
+    size_t end = line.size();
+    while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r'))
+      end--;
+    if (end < 3)
+      return false;
+    for (size_t i = 0; i < end; i++)
+      if (line[i] != c)
+        return false;
+    return true;
+  }
+
+  // Extracts the source sections of the corpus files below `root`, in the
+  // format read by `tree-sitter test`: a name between two `===` lines, then
+  // the source, then a `---` line followed by the expected tree.
+  inline std::vector<Example> load_corpus(const std::string &root = "test/corpus")
+  {
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(root))
+      if (entry.is_regular_file() && entry.path().extension() == ".txt")
+        paths.push_back(entry.path());
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Example> examples;
+    for (const auto &path : paths)
+    {
+      std::ifstream in(path, std::ios::binary);
+      std::string file = std::filesystem::relative(path, root).generic_string();
+      std::string group = path.stem().string();
+
+      enum
+      {
+        OUTSIDE,
+        NAME,
+        SOURCE,
+      } state = OUTSIDE;
+      Example example;
+      std::string line;
+      while (std::getline(in, line))
+      {
+        line += '\n';
+        if (state == OUTSIDE && is_rule(line, '='))
+        {
+          state = NAME;
+          example = Example{file, group, "", ""};
+        }
+        else if (state == NAME && is_rule(line, '='))
+        {
+          state = SOURCE;
+        }
+        else if (state == NAME)
+        {
+          example.name += line.substr(0, line.find_last_not_of("\r\n") + 1);
+        }
+        else if (state == SOURCE && is_rule(line, '-'))
+        {
+          // Drop the line break before the divider, as tree-sitter does.
+          std::string &source = example.source;
+          if (!source.empty() && source.back() == '\n')
+            source.pop_back();
+          if (!source.empty() && source.back() == '\r')
+            source.pop_back();
+          if (!source.empty() && source.front() == '\n')
+            source.erase(0, 1);
+          examples.push_back(std::move(example));
+          state = OUTSIDE;
+        }
+        else if (state == SOURCE)
+        {
+          example.source += line;
+        }
+      }
+    }
+    return examples;
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_TEST_NATIVE_CORPUS_H_
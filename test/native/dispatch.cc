@@ -0,0 +1,121 @@
+// Test for talon/dispatch.h.
+//
+// Checks normalize_event on spellings that must and must not share a key.
+// Then builds a table of many events, each bound a few times, and checks
+// that every event finds its bindings in declaration order and that events
+// not in the table find none. Then checks lookups through a DispatchIndex of
+// parsed files.
+
+#include "talon/dispatch.h"
+#include "talon/language.h"
+#include "test/native/test.h"
+#include <cstdio>
+
+namespace
+{
+
+  void expect_normalized(talon::EventKind kind, const std::string &event, const std::string &expected)
+  {
+    std::string actual = talon::normalize_event(kind, event);
+    if (actual != expected)
+      test::fail("normalize_event(\"%s\") is \"%s\", expected \"%s\"", event.c_str(), actual.c_str(),
+                 expected.c_str());
+  }
+
+  size_t count(std::pair<const talon::Binding *, const talon::Binding *> range)
+  {
+    return range.second - range.first;
+  }
+
+}
+
+int main()
+{
+  using talon::KEY_EVENT;
+
+  // Equivalent spellings of a chord.
+  expect_normalized(KEY_EVENT, "ctrl-shift-a", "ctrl-shift-a");
+  expect_normalized(KEY_EVENT, "Shift-Control-A", "ctrl-shift-a");
+  expect_normalized(KEY_EVENT, "alt-option-a", "alt-a");
+  expect_normalized(KEY_EVENT, "super-command-cmd-a", "cmd-a");
+  expect_normalized(KEY_EVENT, "shift-ctrl-a:up", "ctrl-shift-a:up");
+  expect_normalized(KEY_EVENT, "ctrl--", "ctrl--");
+  expect_normalized(KEY_EVENT, " \tctrl-a\n", "ctrl-a");
+  expect_normalized(KEY_EVENT, "", "");
+  expect_normalized(KEY_EVENT, "   ", "");
+  // Whitespace separates the keys of a sequence instead of vanishing.
+  expect_normalized(KEY_EVENT, "ctrl a", "ctrl a");
+  expect_normalized(KEY_EVENT, "ctrla", "ctrla");
+  expect_normalized(KEY_EVENT, "Shift-Control-a  \t b", "ctrl-shift-a b");
+  expect_normalized(KEY_EVENT, "control-a shift-ctrl-b", "ctrl-a ctrl-shift-b");
+  // Other events are only lowercased and spaced.
+  expect_normalized(talon::NOISE_EVENT, " Hiss:Stop ", "hiss:stop");
+  expect_normalized(talon::PARROT_EVENT, "Palate_Click", "palate_click");
+  expect_normalized(talon::GAMEPAD_EVENT, "dpad  up", "dpad up");
+  expect_normalized(talon::FACE_EVENT, "ctrl-Smile", "ctrl-smile");
+
+  // Event i is bound (i % 3) + 1 times, the bindings of all events
+  // interleaved, so that grouping must keep declaration order.
+  const uint32_t event_count = 2000;
+  std::vector<talon::Binding> bindings;
+  for (uint32_t round = 0; round < 3; round++)
+    for (uint32_t i = 0; i < event_count; i++)
+      if (round <= i % 3)
+        bindings.push_back({KEY_EVENT, "ctrl-f" + std::to_string(i), round, i, i + 1});
+  talon::DispatchTable table;
+  table.build(bindings);
+  test::expect(table.size() == event_count, "table size");
+  for (uint32_t i = 0; i < event_count; i++)
+  {
+    std::string event = "ctrl-f" + std::to_string(i);
+    auto range = table.lookup(event);
+    if (count(range) != i % 3 + 1)
+    {
+      test::fail("%s: %zu bindings, expected %u", event.c_str(), count(range), i % 3 + 1);
+      continue;
+    }
+    for (uint32_t round = 0; round < count(range); round++)
+    {
+      const talon::Binding &binding = range.first[round];
+      test::expect(binding.event == event && binding.file == round && binding.start_byte == i,
+                   event + ": wrong binding");
+    }
+  }
+  // Misses, including prefixes and extensions of keys in the table.
+  for (const char *event : {"", "ctrl-f", "ctrl-f2000", "ctrl-f12x", "ctrl-f1 ", "shift-f1", "f1"})
+    test::expect(count(table.lookup(event)) == 0, std::string("\"") + event + "\" was found");
+  talon::DispatchTable empty;
+  empty.build({});
+  test::expect(empty.size() == 0 && count(empty.lookup("a")) == 0, "empty table");
+
+  // Lookups through an index of parsed files normalize their event.
+  const std::string sources[] = {
+      "app: editor\n-\nkey(ctrl-shift-a): user.first()\nnoise(pop): user.click()\nkey(ctrl a): user.sequence()\n",
+      "key(Shift-Control-a): user.second()\nparrot(tut): user.tut()\n",
+  };
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  talon::DispatchIndex index;
+  for (const std::string &source : sources)
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    index.add_file(ts_tree_root_node(tree), source);
+    ts_tree_delete(tree);
+  }
+  ts_parser_delete(parser);
+  index.build();
+
+  auto chord = index.lookup(KEY_EVENT, "control-SHIFT-a");
+  test::expect(count(chord) == 2, "key(ctrl-shift-a) is bound twice");
+  test::expect(count(chord) == 2 && chord.first[0].file == 0 && chord.first[1].file == 1, "binding order");
+  test::expect(count(index.lookup(KEY_EVENT, "ctrl  a")) == 1, "key(ctrl a) by another spacing");
+  test::expect(count(index.lookup(KEY_EVENT, "ctrla")) == 0, "key(ctrla) matched key(ctrl a)");
+  test::expect(count(index.lookup(KEY_EVENT, "ctrl-a")) == 0, "key(ctrl-a) matched key(ctrl a)");
+  test::expect(count(index.lookup(talon::NOISE_EVENT, "Pop")) == 1, "noise(pop)");
+  test::expect(count(index.lookup(talon::PARROT_EVENT, "pop")) == 0, "parrot(pop) matched noise(pop)");
+  test::expect(count(index.lookup(talon::PARROT_EVENT, "tut")) == 1, "parrot(tut)");
+  test::expect(index.context(0).size() == 1 && index.context(1).empty(), "file headers");
+
+  std::printf("%zu events, %d failures\n", table.size(), test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,90 @@
+// Test for talon/escape.h.
+//
+// Checks decode_escapes on known strings, then fuzzes it against
+// decode_escapes_scalar at every alignment around the 16-byte blocks.
+
+#include "talon/escape.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+  std::string decode(const std::string &text)
+  {
+    std::vector<char> out(text.size() + 1);
+    size_t length = talon::decode_escapes(text.data(), text.size(), out.data());
+    return std::string(out.data(), length);
+  }
+
+  std::string decode_scalar(const std::string &text)
+  {
+    std::vector<char> out(text.size() + 1);
+    size_t length = talon::decode_escapes_scalar(text.data(), text.size(), out.data());
+    return std::string(out.data(), length);
+  }
+
+  void expect(const std::string &text, const std::string &expected)
+  {
+    std::string actual = decode(text);
+    if (actual != expected)
+      test::fail("\"%s\": got \"%s\", expected \"%s\"", text.c_str(), actual.c_str(), expected.c_str());
+  }
+
+  uint64_t state = 56;
+
+  uint32_t below(uint32_t bound)
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return uint32_t((state * 0x2545f4914f6cdd1dull) % bound);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+
+  expect("plain text", "plain text");
+  expect("a\\nb\\tc", "a\nb\tc");
+  expect("\\a\\b\\f\\r\\v", "\a\b\f\r\v");
+  expect("\\\\ \\' \\\"", "\\ ' \"");
+  expect("\\x41\\x7a", "Az");
+  expect("caf\\u00e9", "caf\xc3\xa9");
+  expect("\\U0001F600", "\xf0\x9f\x98\x80");
+  expect("\\101\\060", "A0");
+  expect("line \\\ncontinued", "line continued");
+  expect("line \\\r\ncontinued", "line continued");
+  expect("not \\q an escape", "not \\q an escape");
+  expect("\\999 \\xZZ \\u12", "\\999 \\xZZ \\u12");
+  expect("trailing \\", "trailing \\");
+  expect("0123456789abcdef\\n0123456789abcdef", "0123456789abcdef\n0123456789abcdef");
+
+  static const char *const pieces[] = {
+      "a", "bc", "0123456789", "\\", "\\n", "\\t", "\\\\", "\\\"", "\\x4", "\\x41", "\\u00e9",
+      "\\U0001f600", "\\U00110000", "\\777", "\\08", "\\\n", "\\\r\n", "\\\r", "{", "\xc3\xa9",
+  };
+  for (size_t n = 0; n < iterations; n++)
+  {
+    std::string text;
+    uint32_t count = below(24);
+    for (uint32_t i = 0; i < count; i++)
+      text += pieces[below(sizeof(pieces) / sizeof(pieces[0]))];
+
+    std::string expected = decode_scalar(text);
+    for (size_t shift = 0; shift < 16; shift++)
+    {
+      std::string shifted = std::string(shift, 'x') + text;
+      if (decode(shifted) != std::string(shift, 'x') + expected)
+        test::fail("SIMD and scalar differ on \"%s\"", shifted.c_str());
+    }
+  }
+
+  std::printf("Decoded %zu strings: %d failures\n", iterations * 16, test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,156 @@
+// Test for talon/hash.h.
+//
+// Builds a file from the error-free corpus tests and checks that comments and
+// blank lines between declarations leave every hash as it was. Then edits
+// declarations one at a time and reparses incrementally, and checks that an
+// edit of layout changes no hash, that an edit of a rule changes the hash of
+// its declaration only, and that each update rehashes a few declarations
+// rather than the file, while agreeing with hashing the new tree afresh.
+
+#include "talon/hash.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+
+namespace
+{
+
+  TSPoint point_at(const std::string &text, uint32_t byte)
+  {
+    TSPoint point = {0, 0};
+    for (uint32_t i = 0; i < byte; i++)
+    {
+      if (text[i] == '\n')
+      {
+        point.row++;
+        point.column = 0;
+      }
+      else
+      {
+        point.column++;
+      }
+    }
+    return point;
+  }
+
+  // Replaces `removed` bytes at `start` of `text` with `inserted`, and
+  // reparses `tree` incrementally. The caller deletes `tree` only after the
+  // hashes were updated, as DeclarationHashes requires.
+  TSTree *edit(TSParser *parser, std::string &text, TSTree *tree, uint32_t start, uint32_t removed,
+               const std::string &inserted)
+  {
+    TSInputEdit input_edit;
+    input_edit.start_byte = start;
+    input_edit.old_end_byte = start + removed;
+    input_edit.new_end_byte = start + inserted.size();
+    input_edit.start_point = point_at(text, start);
+    input_edit.old_end_point = point_at(text, start + removed);
+    text.replace(start, removed, inserted);
+    input_edit.new_end_point = point_at(text, start + inserted.size());
+    ts_tree_edit(tree, &input_edit);
+    return ts_parser_parse_string(parser, tree, text.data(), text.size());
+  }
+
+  std::vector<uint64_t> hashes(const talon::DeclarationHashes &declarations)
+  {
+    std::vector<uint64_t> result;
+    for (const talon::DeclarationHashes::Declaration &declaration : declarations.declarations())
+      result.push_back(declaration.hash);
+    return result;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  const talon::Symbols &s = talon::symbols();
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  std::string text;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+    TSNode root = ts_tree_root_node(tree);
+    bool has_header = ts_node_named_child_count(root) > 0 && ts_node_symbol(ts_node_named_child(root, 0)) == s.matches;
+    if (!ts_node_has_error(root) && !has_header && !example.source.empty())
+      text += example.source + "\n";
+    ts_tree_delete(tree);
+  }
+
+  TSTree *tree = ts_parser_parse_string(parser, NULL, text.data(), text.size());
+  talon::DeclarationHashes declarations;
+  declarations.update(tree, text);
+  size_t count = declarations.declarations().size();
+  test::expect(count > 20, "too few declarations to test with");
+  test::expect(declarations.rehashed_count() == count, "the first update hashed every declaration");
+
+  // Comments and blank lines before every declaration.
+  {
+    std::string commented = text;
+    for (size_t i = count; i-- > 0;)
+      commented.insert(ts_node_start_byte(declarations.declarations()[i].node), "\n# note\n\n");
+    TSTree *commented_tree = ts_parser_parse_string(parser, NULL, commented.data(), commented.size());
+    talon::DeclarationHashes commented_declarations;
+    commented_declarations.update(commented_tree, commented);
+    test::expect(hashes(commented_declarations) == hashes(declarations), "comments changed the hashes");
+    test::expect(commented_declarations.root() == declarations.root(), "comments changed the root");
+    ts_tree_delete(commented_tree);
+  }
+
+  size_t layout_edits = 0, rule_edits = 0;
+  for (size_t k = 1; k < count; k += count / 25 + 1)
+  {
+    TSSymbol symbol = ts_node_symbol(declarations.declarations()[k].node);
+    uint32_t start = ts_node_start_byte(declarations.declarations()[k].node);
+    std::vector<uint64_t> before = hashes(declarations);
+    uint64_t root = declarations.root();
+
+    // A blank line before the declaration.
+    TSTree *new_tree = edit(parser, text, tree, start, 0, "\n");
+    declarations.update(new_tree, text);
+    ts_tree_delete(tree);
+    tree = new_tree;
+    std::string where = "declaration " + std::to_string(k);
+    test::expect(hashes(declarations) == before && declarations.root() == root,
+                 "blank line changed hashes at " + where);
+    test::expect(declarations.removed().empty(), "blank line removed a hash at " + where);
+    std::string rehashed = std::to_string(declarations.rehashed_count());
+    test::expect(declarations.rehashed_count() <= 4, "blank line rehashed " + rehashed + " at " + where);
+    layout_edits++;
+
+    // A different first letter of a command's rule.
+    char first = text[start + 1];
+    if (symbol != s.command_declaration || first < 'a' || first > 'y')
+      continue;
+    new_tree = edit(parser, text, tree, start + 1, 1, std::string(1, first + 1));
+    declarations.update(new_tree, text);
+    ts_tree_delete(tree);
+    tree = new_tree;
+    std::vector<uint64_t> after = hashes(declarations);
+    size_t changed = 0;
+    for (size_t i = 0; i < after.size() && after.size() == before.size(); i++)
+      changed += after[i] != before[i];
+    test::expect(changed == 1 && after[k] != before[k],
+                 "rule edit changed " + std::to_string(changed) + " hashes at " + where);
+    test::expect(declarations.declarations()[k].changed && declarations.removed().size() == 1,
+                 "rule edit was not reported as a change at " + where);
+    test::expect(declarations.root() != root, "rule edit kept the root at " + where);
+    rehashed = std::to_string(declarations.rehashed_count());
+    test::expect(declarations.rehashed_count() <= 4, "rule edit rehashed " + rehashed + " at " + where);
+
+    talon::DeclarationHashes fresh;
+    fresh.update(tree, text);
+    test::expect(hashes(fresh) == after && fresh.root() == declarations.root(),
+                 "incremental hashes differ at " + where);
+    rule_edits++;
+  }
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+
+  std::printf("%zu declarations, %zu layout edits, %zu rule edits, %d failures\n", count, layout_edits, rule_edits,
+              test::failures.load());
+  return test::status();
+}
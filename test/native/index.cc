@@ -0,0 +1,127 @@
+// Test for talon/index.h.
+//
+// Indexes every corpus test and checks that every reference points at the
+// text it names. Then publishes a stream of snapshots while reader threads
+// check that each snapshot they pin is whole and that versions never go back,
+// and that every replaced snapshot is freed once the readers are done.
+
+#include "talon/index.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+  void check_references(const std::string &name, std::string_view source, const char *kind,
+                        const std::vector<talon::FileIndex::Reference> &references, const char *prefix)
+  {
+    for (const talon::FileIndex::Reference &reference : references)
+    {
+      std::string_view text = source.substr(reference.start_byte, reference.end_byte - reference.start_byte);
+      test::expect(text.substr(0, std::strlen(prefix) + reference.name.size()) == prefix + reference.name,
+                   name + ": " + kind + " " + reference.name + " at \"" + std::string(text.substr(0, 40)) + "\"");
+    }
+  }
+
+  // A file whose only action is named after the version it was written in, so
+  // readers can tell which update they see.
+  talon::FileIndex synthetic_file(size_t path, uint64_t version)
+  {
+    talon::FileIndex file;
+    file.path = "file" + std::to_string(path) + ".talon";
+    file.actions.push_back({"user.action" + std::to_string(version), 0, 1, {0, 0}});
+    file.lists.push_back({"user.list", 0, 1, {0, 0}});
+    return file;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  const talon::Symbols &s = talon::symbols();
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  size_t indexed = 0;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    const std::string &source = example.source;
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    talon::FileIndex file = talon::index_file(example.name, root, source);
+    std::string name = example.file + ": " + example.name;
+    check_references(name, source, "action", file.actions, "");
+    check_references(name, source, "list", file.lists, "{");
+    check_references(name, source, "capture", file.captures, "<");
+    check_references(name, source, "command", file.commands, "");
+
+    size_t commands = 0;
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+        commands += ts_node_symbol(ts_node_named_child(child, j)) == s.command_declaration;
+    }
+    test::expect(file.commands.size() == commands, name + ": wrong number of commands");
+    ts_tree_delete(tree);
+    indexed++;
+  }
+  ts_parser_delete(parser);
+
+  // Replacing and removing files.
+  {
+    talon::WorkspaceIndex index;
+    index.update({synthetic_file(2, 1), synthetic_file(1, 1)});
+    index.update({synthetic_file(2, 2)}, {"file1.talon"});
+    talon::WorkspaceIndex::Reader snapshot = index.read();
+    test::expect(snapshot->version() == 2, "version after two updates");
+    test::expect(snapshot->files().size() == 1 && snapshot->file("file2.talon"), "files after removal");
+    test::expect(snapshot->find_action("user.action2") && !snapshot->find_action("user.action1"), "replaced actions");
+  }
+
+  // Readers during continuous updates.
+  const size_t paths = 50, updates = 2000;
+  talon::WorkspaceIndex index(8);
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> reads(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; r++)
+  {
+    readers.emplace_back([&]()
+    {
+      uint64_t last = 0, count = 0;
+      while (!done)
+      {
+        talon::WorkspaceIndex::Reader snapshot = index.read();
+        test::expect(snapshot->version() >= last, "version went back");
+        last = snapshot->version();
+        const std::vector<talon::IndexSnapshot::Entry> *entries = snapshot->find_list("user.list");
+        test::expect(snapshot->files().size() == std::min<uint64_t>(last, paths), "wrong number of files");
+        test::expect(last == 0 || (entries && entries->size() == snapshot->files().size()), "wrong number of lists");
+        for (size_t i = 1; i < snapshot->files().size(); i++)
+          test::expect(snapshot->files()[i - 1]->path < snapshot->files()[i]->path, "files not sorted");
+        test::expect(last == 0 || snapshot->find_action("user.action" + std::to_string(last)), "latest action missing");
+        count++;
+      }
+      reads += count;
+    });
+  }
+  for (uint64_t version = 1; version <= updates; version++)
+    index.update({synthetic_file(version % paths, version)});
+  done = true;
+  for (std::thread &reader : readers)
+    reader.join();
+  index.update({synthetic_file(0, updates + 1)});
+  test::expect(index.retired_count() == 0, "replaced snapshots were not freed");
+
+  std::printf("%zu corpus tests indexed, %llu snapshot reads during %zu updates, %d failures\n", indexed,
+              (unsigned long long)reads.load(), updates, test::failures.load());
+  return test::status();
+}
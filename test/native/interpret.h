@@ -0,0 +1,176 @@
+#ifndef TREE_SITTER_TALON_TEST_NATIVE_INTERPRET_H_
+#define TREE_SITTER_TALON_TEST_NATIVE_INTERPRET_H_
+
+#include "talon/language.h"
+#include "talon/value.h"
+#include <tree_sitter/api.h>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace test
+{
+
+  using Scope = std::vector<std::pair<std::string, talon::Value>>;
+
+  // Appends `code` as UTF-8.
+  inline void append_utf8(std::string &out, uint32_t code)
+  {
+    if (code < 0x80)
+      out += char(code);
+    else if (code < 0x800)
+    {
+      out += char(0xc0 | (code >> 6));
+      out += char(0x80 | (code & 0x3f));
+    }
+    else if (code < 0x10000)
+    {
+      out += char(0xe0 | (code >> 12));
+      out += char(0x80 | ((code >> 6) & 0x3f));
+      out += char(0x80 | (code & 0x3f));
+    }
+    else
+    {
+      out += char(0xf0 | (code >> 18));
+      out += char(0x80 | ((code >> 12) & 0x3f));
+      out += char(0x80 | ((code >> 6) & 0x3f));
+      out += char(0x80 | (code & 0x3f));
+    }
+  }
+
+  // Appends what an escape sequence stands for, as Python decodes it.
+  inline void interpret_escape(std::string &out, std::string_view sequence)
+  {
+    char c = sequence[1];
+    switch (c)
+    {
+    case 'a':
+      out += '\a';
+      break;
+    case 'b':
+      out += '\b';
+      break;
+    case 'f':
+      out += '\f';
+      break;
+    case 'n':
+      out += '\n';
+      break;
+    case 'r':
+      out += '\r';
+      break;
+    case 't':
+      out += '\t';
+      break;
+    case 'v':
+      out += '\v';
+      break;
+    case '\r':
+    case '\n':
+      // a line continuation
+      break;
+    case 'x':
+    case 'u':
+    case 'U':
+    {
+      uint32_t code = std::strtoul(std::string(sequence.substr(2)).c_str(), NULL, 16);
+      if (code <= 0x10ffff)
+        append_utf8(out, code);
+      else
+        out += sequence;
+      break;
+    }
+    default:
+      if (c >= '0' && c <= '7')
+      {
+        std::string digits(sequence.substr(1));
+        char *end;
+        uint32_t code = std::strtoul(digits.c_str(), &end, 8);
+        if (*end == '\0')
+          append_utf8(out, code);
+        else
+          out += sequence;
+      }
+      else if (c == '8' || c == '9')
+        out += sequence;
+      else
+        out += c;
+    }
+  }
+
+  // Formats a string node by walking its children, as a tree walker would.
+  // Interpolations must be variables, looked up in `scope`.
+  inline void interpret(TSNode node, std::string_view source, const Scope &scope, std::string &out)
+  {
+    const talon::Symbols &s = talon::symbols();
+    uint32_t count = ts_node_named_child_count(node);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      TSNode child = ts_node_named_child(node, i);
+      TSSymbol symbol = ts_node_symbol(child);
+      std::string_view text = talon::node_text(source, child);
+      if (symbol == s.string_escape_sequence)
+        interpret_escape(out, text);
+      else if (symbol == s.interpolation)
+      {
+        TSNode variable = ts_node_named_child(child, 0);
+        std::string_view name = talon::node_text(source, ts_node_child_by_field_id(variable, s.variable_name));
+        for (const auto &[key, value] : scope)
+          if (key == name)
+            talon::append_value(out, value);
+      }
+      else if (text == "{{" || text == "}}")
+        out += text[0];
+      else
+        out += text;
+    }
+  }
+
+  // The `string` nodes below `root`, in source order.
+  inline std::vector<TSNode> string_nodes(TSNode root)
+  {
+    const talon::Symbols &s = talon::symbols();
+    std::vector<TSNode> nodes;
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    for (bool more = true; more;)
+    {
+      TSNode node = ts_tree_cursor_current_node(&cursor);
+      if (ts_node_symbol(node) == s.string)
+        nodes.push_back(node);
+      if (ts_tree_cursor_goto_first_child(&cursor))
+        continue;
+      while (!ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        if (!ts_tree_cursor_goto_parent(&cursor))
+        {
+          more = false;
+          break;
+        }
+      }
+    }
+    ts_tree_cursor_delete(&cursor);
+    return nodes;
+  }
+
+  // The values of the slots a template compiled from, looked up in `scope`.
+  inline std::vector<talon::Value> slot_values(const std::vector<TSNode> &slots, std::string_view source,
+                                               const Scope &scope)
+  {
+    const talon::Symbols &s = talon::symbols();
+    std::vector<talon::Value> values;
+    for (TSNode slot : slots)
+    {
+      std::string_view name = talon::node_text(source, ts_node_child_by_field_id(slot, s.variable_name));
+      for (const auto &[key, value] : scope)
+        if (key == name)
+          values.push_back(value);
+    }
+    return values;
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_TEST_NATIVE_INTERPRET_H_
@@ -0,0 +1,139 @@
+// Test for talon/lazy.h.
+//
+// Parses every error-free corpus test both with tree_sitter_talon() and with
+// tree_sitter_talon_lazy(), and checks that the lazy tree has the same
+// declarations and rules, and that every body parsed on demand matches the
+// body of the full parse. Then checks that a comment at column 0 inside a body
+// stays inside the skipped range.
+
+#include "talon/language.h"
+#include "talon/lazy.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+  std::string to_string(TSNode node)
+  {
+    if (ts_node_is_null(node))
+      return "<null>";
+    char *text = ts_node_string(node);
+    std::string result = text;
+    std::free(text);
+    return result;
+  }
+
+  std::vector<TSNode> declarations(TSNode root)
+  {
+    const talon::Symbols &s = talon::symbols();
+    std::vector<TSNode> result;
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+      {
+        TSNode declaration = ts_node_named_child(child, j);
+        if (ts_node_symbol(declaration) != s.comment)
+          result.push_back(declaration);
+      }
+    }
+    return result;
+  }
+
+  void expect(bool condition, const test::Example &example, const std::string &what)
+  {
+    if (!condition)
+      test::fail("%s: %s: %s", example.file.c_str(), example.name.c_str(), what.c_str());
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  const talon::Symbols &s = talon::symbols();
+  TSParser *eager = ts_parser_new();
+  ts_parser_set_language(eager, tree_sitter_talon());
+  TSParser *lazy = ts_parser_new();
+  ts_parser_set_language(lazy, tree_sitter_talon_lazy());
+  talon::LazyBodies bodies;
+
+  size_t checked = 0, skipped = 0;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    const std::string &source = example.source;
+    TSTree *eager_tree = ts_parser_parse_string(eager, NULL, source.data(), source.size());
+    if (ts_node_has_error(ts_tree_root_node(eager_tree)))
+    {
+      ts_tree_delete(eager_tree);
+      continue;
+    }
+    TSTree *lazy_tree = ts_parser_parse_string(lazy, NULL, source.data(), source.size());
+    bodies.reset(lazy_tree, source);
+    expect(!ts_node_has_error(ts_tree_root_node(lazy_tree)), example, "lazy tree has errors");
+
+    std::vector<TSNode> expected = declarations(ts_tree_root_node(eager_tree));
+    std::vector<TSNode> actual = declarations(ts_tree_root_node(lazy_tree));
+    expect(actual.size() == expected.size(), example, "different number of declarations");
+    for (size_t i = 0; i < std::min(actual.size(), expected.size()); i++)
+    {
+      expect(ts_node_start_byte(actual[i]) == ts_node_start_byte(expected[i]), example, "declaration moved");
+      expect(to_string(ts_node_child_by_field_id(actual[i], s.left)) ==
+                 to_string(ts_node_child_by_field_id(expected[i], s.left)),
+             example, "different rule");
+      TSNode expected_body = ts_node_child_by_field_id(expected[i], s.right);
+      skipped += talon::is_lazy_block(ts_node_child_by_field_id(actual[i], s.right));
+      TSNode body = bodies.body(actual[i]);
+      expect(to_string(body) == to_string(expected_body), example,
+             "body " + to_string(body) + ", expected " + to_string(expected_body));
+      expect(ts_node_start_byte(body) == ts_node_start_byte(expected_body), example, "body moved");
+    }
+    ts_tree_delete(lazy_tree);
+    ts_tree_delete(eager_tree);
+    checked++;
+  }
+
+  // A comment at column 0 between the statements of a body does not end the
+  // skipped range, as it does not end the block of a full parse.
+  {
+    test::Example example = {"lazy.cc", "lazy", "comment at column 0",
+                              "foo:\n    key(a)\n# note\n    key(b)\nbar: x\n"};
+    const std::string &source = example.source;
+    TSTree *eager_tree = ts_parser_parse_string(eager, NULL, source.data(), source.size());
+    TSTree *lazy_tree = ts_parser_parse_string(lazy, NULL, source.data(), source.size());
+    bodies.reset(lazy_tree, source);
+    std::vector<TSNode> expected = declarations(ts_tree_root_node(eager_tree));
+    std::vector<TSNode> actual = declarations(ts_tree_root_node(lazy_tree));
+    expect(actual.size() == 2 && expected.size() == 2, example, "different number of declarations");
+    if (actual.size() == 2 && expected.size() == 2)
+    {
+      TSNode block = ts_node_child_by_field_id(actual[0], s.right);
+      expect(talon::is_lazy_block(block), example, "body was not skipped: " + to_string(block));
+      TSNode skipped_body = ts_node_named_child(block, 0);
+      std::string range = source.substr(ts_node_start_byte(skipped_body),
+                                        ts_node_end_byte(skipped_body) - ts_node_start_byte(skipped_body));
+      expect(ts_node_symbol(skipped_body) == s.comment && range == "key(a)\n# note\n    key(b)", example,
+             "skipped range " + range);
+      TSNode body = bodies.body(actual[0]);
+      TSNode expected_body = ts_node_child_by_field_id(expected[0], s.right);
+      expect(to_string(body) == to_string(expected_body), example,
+             "body " + to_string(body) + ", expected " + to_string(expected_body));
+      // Bodies are only given for declarations of the bound tree, even at
+      // the same offset.
+      expect(ts_node_is_null(bodies.body(expected[0])), example, "body of a declaration of another tree");
+    }
+    bodies.reset(NULL, std::string_view());
+    ts_tree_delete(lazy_tree);
+    ts_tree_delete(eager_tree);
+  }
+  ts_parser_delete(lazy);
+  ts_parser_delete(eager);
+
+  std::printf("%zu corpus tests compared, %zu bodies skipped, %d failures\n", checked, skipped, test::failures.load());
+  return test::failures || skipped == 0 ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+// Fuzz test for talon/number.h.
+//
+// Generates random literals, many of them near-misses of valid ones, and checks
+// that decode_number accepts exactly the strings matched by the `integer` and
+// `float` tokens in grammar.js, that it agrees with strtoull and strtod on
+// their values, and that the parser produces the same node type for them.
+
+#include "talon/language.h"
+#include "talon/number.h"
+#include "test/native/test.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <regex>
+#include <string>
+
+namespace
+{
+
+  // The `integer` and `float` tokens from grammar.js, with `(_?[0-9]+)+` and
+  // `([0-9]+_?)+` unrolled so that std::regex does not backtrack exponentially.
+#define HEX "_?[A-Fa-f0-9]+(_[A-Fa-f0-9]+)*"
+#define OCT "_?[0-7]+(_[0-7]+)*"
+#define BIN "_?[0-1]+(_[0-1]+)*"
+#define DIGITS "[0-9]+(_[0-9]+)*_?"
+#define EXPONENT "[eE][\\+-]?" DIGITS
+
+  const std::regex integer_token(
+      "0[xX]" HEX "[Ll]?"
+      "|0[oO]" OCT "[Ll]?"
+      "|0[bB]" BIN "[Ll]?"
+      "|" DIGITS "[LljJ]?");
+
+  const std::regex float_token(
+      "(" DIGITS "\\.(" DIGITS ")?(" EXPONENT ")?"
+      "|(" DIGITS ")?\\.(" DIGITS ")(" EXPONENT ")?"
+      "|" DIGITS EXPONENT ")"
+      "[LljJ]?");
+
+  uint64_t state = 55;
+
+  uint32_t below(uint32_t bound)
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return uint32_t((state * 0x2545f4914f6cdd1dull) % bound);
+  }
+
+  std::string random_literal()
+  {
+    static const char *const pieces[] = {
+        "0", "1", "7", "9", "42", "1234567890", "ff", "A", "_", "__", ".", "e", "E", "+", "-",
+        "x", "X", "o", "O", "b", "B", "l", "L", "j", "J", "0x", "0o", "0b", "e-", "E+",
+    };
+    std::string literal;
+    uint32_t length = 1 + below(6);
+    for (uint32_t i = 0; i < length; i++)
+      literal += pieces[below(sizeof(pieces) / sizeof(pieces[0]))];
+    return literal;
+  }
+
+  std::string without(const std::string &text, const char *characters)
+  {
+    std::string result;
+    for (char c : text)
+      if (!std::strchr(characters, c))
+        result += c;
+    return result;
+  }
+
+  void fail(const std::string &literal, const char *message)
+  {
+    test::fail("%s: %s", literal.c_str(), message);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 200000;
+  const talon::Symbols &s = talon::symbols();
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  size_t integers = 0, floats = 0, parsed = 0;
+  for (size_t n = 0; n < iterations; n++)
+  {
+    std::string literal = random_literal();
+    talon::Number number = talon::decode_number(literal);
+    bool is_integer = std::regex_match(literal, integer_token);
+    bool is_float = std::regex_match(literal, float_token);
+
+    if (is_integer != (number.kind == talon::Number::INTEGER))
+      fail(literal, is_integer ? "integer token rejected" : "accepted as integer");
+    if (is_float != (number.kind == talon::Number::FLOAT))
+      fail(literal, is_float ? "float token rejected" : "accepted as float");
+
+    if (number.kind == talon::Number::INTEGER)
+    {
+      integers++;
+      std::string digits = without(literal, "_lLjJ");
+      int base = 10;
+      if (digits.size() > 1 && digits[0] == '0' && std::strchr("xXoObB", digits[1]))
+      {
+        base = std::strchr("xX", digits[1]) ? 16 : std::strchr("oO", digits[1]) ? 8
+                                                                                : 2;
+        digits = digits.substr(2);
+      }
+      errno = 0;
+      unsigned long long expected = std::strtoull(digits.c_str(), NULL, base);
+      bool overflow = errno == ERANGE;
+      if (overflow != number.overflow || (!overflow && expected != number.integer))
+        fail(literal, "integer value differs from strtoull");
+    }
+    else if (number.kind == talon::Number::FLOAT)
+    {
+      floats++;
+      double expected = std::strtod(without(literal, "_lLjJ").c_str(), NULL);
+      if (!(expected == number.real || (std::isnan(expected) && std::isnan(number.real))))
+        fail(literal, "float value differs from strtod");
+    }
+
+    // Check the tokens against the generated parser itself.
+    if (number.kind != talon::Number::INVALID && n % 16 == 0)
+    {
+      parsed++;
+      std::string source = "settings():\n    x = " + literal + "\n";
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      TSNode root = ts_tree_root_node(tree);
+      TSNode declaration = ts_node_named_child(ts_node_named_child(root, 0), 0);
+      TSNode block = ts_node_child_by_field_id(declaration, s.right);
+      TSNode value = ts_node_child_by_field_id(ts_node_named_child(block, 0), s.right);
+      TSSymbol expected = number.kind == talon::Number::INTEGER ? s.integer : s.float_;
+      if (ts_node_has_error(root) || ts_node_symbol(value) != expected ||
+          ts_node_end_byte(value) - ts_node_start_byte(value) != literal.size())
+        fail(literal, "parsed as a different token");
+      ts_tree_delete(tree);
+    }
+  }
+
+  ts_parser_delete(parser);
+  std::printf("Decoded %zu integers and %zu floats in %zu literals (%zu parsed): %d failures\n",
+              integers, floats, iterations, parsed, test::failures.load());
+  return test::status();
+}
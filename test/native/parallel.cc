@@ -0,0 +1,113 @@
+// Test for talon/parallel.h.
+//
+// Parses every error-free corpus test in pieces as small as its top-level
+// declarations allow, on one and on three threads, and checks that the pieces
+// together have the same top-level nodes, at the same positions, as a parse of
+// the whole test. Then parses all of them at once with
+// talon::parse_workspace, with every file split, and checks the same.
+
+#include "talon/language.h"
+#include "talon/parallel.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+  struct Item
+  {
+    std::string tree;
+    uint32_t start_byte;
+    uint32_t end_byte;
+    TSPoint start_point;
+
+    bool operator==(const Item &other) const
+    {
+      return tree == other.tree && start_byte == other.start_byte && end_byte == other.end_byte &&
+             start_point.row == other.start_point.row && start_point.column == other.start_point.column;
+    }
+  };
+
+  Item item(TSNode node)
+  {
+    char *text = ts_node_string(node);
+    Item result = {text, ts_node_start_byte(node), ts_node_end_byte(node), ts_node_start_point(node)};
+    std::free(text);
+    return result;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  const talon::Symbols &s = talon::symbols();
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  size_t checked = 0, pieces = 0;
+  std::vector<std::string_view> sources;
+  std::vector<std::vector<Item>> all_expected;
+  std::vector<test::Example> examples = test::load_corpus(corpus_path);
+  for (const test::Example &example : examples)
+  {
+    const std::string &source = example.source;
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    if (ts_node_has_error(root))
+    {
+      ts_tree_delete(tree);
+      continue;
+    }
+    std::vector<Item> expected;
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) == s.matches)
+        expected.push_back(item(child));
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+        if (ts_node_symbol(ts_node_named_child(child, j)) != s.comment)
+          expected.push_back(item(ts_node_named_child(child, j)));
+    }
+    ts_tree_delete(tree);
+    sources.push_back(source);
+    all_expected.push_back(expected);
+
+    for (unsigned threads : {1, 3})
+    {
+      talon::SplitTree split = talon::parse_parallel(source, threads, 1);
+      std::vector<Item> actual;
+      split.for_each_declaration([&](TSNode node) { actual.push_back(item(node)); });
+      if (actual != expected)
+        test::fail("%s: %s (%u threads, %zu pieces)", example.file.c_str(), example.name.c_str(),
+                   threads, split.pieces().size());
+      pieces += split.pieces().size();
+    }
+    checked++;
+  }
+  ts_parser_delete(parser);
+
+  talon::WorkspaceOptions options;
+  options.threads = 3;
+  options.split_size = 1;
+  talon::Scheduler::Stats stats;
+  std::vector<talon::SplitTree> trees = talon::parse_workspace(sources, options, &stats);
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    std::vector<Item> actual;
+    trees[i].for_each_declaration([&](TSNode node) { actual.push_back(item(node)); });
+    if (actual != all_expected[i])
+      test::fail("workspace file %zu (%zu pieces)", i, trees[i].pieces().size());
+  }
+  if (trees.size() != sources.size())
+    test::fail("workspace returned %zu trees for %zu files", trees.size(), sources.size());
+  std::printf("%zu files parsed as a workspace in %llu tasks, %llu stolen\n", sources.size(),
+              (unsigned long long)stats.tasks, (unsigned long long)stats.steals);
+
+  std::printf("%zu corpus tests compared in %zu pieces, %d failures\n", checked, pieces, test::failures.load());
+  return test::status();
+}
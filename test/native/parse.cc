@@ -0,0 +1,98 @@
+// Test for talon/parse.h.
+//
+// Checks that progress is reported up to the end of the source, that parses
+// time out and are cancelled, also midway, and that the parser then produces
+// the same tree as a fresh one instead of resuming the abandoned parse.
+
+#include "talon/language.h"
+#include "talon/parse.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+  std::string to_string(TSTree *tree)
+  {
+    if (!tree)
+      return "<null>";
+    char *text = ts_node_string(ts_tree_root_node(tree));
+    std::string result = text;
+    std::free(text);
+    ts_tree_delete(tree);
+    return result;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  std::string source;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+    if (example.file.rfind("knausj_talon/", 0) == 0)
+      source += example.source + "\n";
+  if (source.empty())
+    source = "foo: bar()\n";
+  while (source.size() < (1 << 20))
+    source += source;
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  std::string expected = to_string(ts_parser_parse_string(parser, NULL, source.data(), source.size()));
+  talon::ParseStatus status;
+
+  // Progress
+  std::vector<uint32_t> reports;
+  talon::ParseOptions options;
+  options.progress = [&](uint32_t bytes_read, uint32_t total)
+  {
+    test::expect(total == source.size(), "progress total");
+    reports.push_back(bytes_read);
+  };
+  std::string actual = to_string(talon::parse(parser, NULL, source, options, &status));
+  test::expect(status == talon::PARSE_OK && actual == expected, "parse with progress");
+  test::expect(reports.size() >= source.size() / options.chunk_size, "progress granularity");
+  test::expect(std::is_sorted(reports.begin(), reports.end()), "progress order");
+  test::expect(!reports.empty() && reports.back() == source.size(), "progress end");
+
+  // Cancellation before the parse
+  size_t flag = 1;
+  options = talon::ParseOptions();
+  options.cancellation_flag = &flag;
+  test::expect(talon::parse(parser, NULL, source, options, &status) == NULL, "cancelled parse returns NULL");
+  test::expect(status == talon::PARSE_CANCELLED, "cancelled status");
+  test::expect(ts_parser_cancellation_flag(parser) == NULL, "cancellation flag restored");
+  test::expect(to_string(ts_parser_parse_string(parser, NULL, source.data(), source.size())) == expected,
+               "parse after cancellation");
+
+  // Cancellation midway
+  flag = 0;
+  options.progress = [&](uint32_t bytes_read, uint32_t total)
+  {
+    if (bytes_read > total / 2)
+      flag = 1;
+  };
+  test::expect(talon::parse(parser, NULL, source, options, &status) == NULL, "parse cancelled midway returns NULL");
+  test::expect(status == talon::PARSE_CANCELLED, "cancelled midway status");
+  test::expect(to_string(ts_parser_parse_string(parser, NULL, source.data(), source.size())) == expected,
+               "parse after cancellation midway");
+
+  // Timeout
+  ts_parser_set_timeout_micros(parser, 123456789);
+  options = talon::ParseOptions();
+  options.timeout_micros = 1;
+  test::expect(talon::parse(parser, NULL, source, options, &status) == NULL, "timed out parse returns NULL");
+  test::expect(status == talon::PARSE_TIMED_OUT, "timed out status");
+  test::expect(ts_parser_timeout_micros(parser) == 123456789, "timeout restored");
+  ts_parser_set_timeout_micros(parser, 0);
+  test::expect(to_string(ts_parser_parse_string(parser, NULL, source.data(), source.size())) == expected,
+               "parse after timeout");
+
+  ts_parser_delete(parser);
+  std::printf("%d failures\n", test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,149 @@
+// Test for talon/phrases.h.
+//
+// Checks the phrases of a few rules built by hand against lists written out
+// in full, including lists without items. Then compiles the rule of every
+// command in the corpus tests, and checks that the generator lists as many
+// phrases as count_phrases counts, for lists of several sizes, without
+// growing its phrase buffer.
+
+#include "talon/language.h"
+#include "talon/phrases.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+
+namespace
+{
+
+  talon::RuleOp op(talon::RuleKind kind, const char *name = "", uint32_t arity = 0)
+  {
+    return {kind, arity, name};
+  }
+
+  // The size of a list is the length of its name, so that tests can choose.
+  talon::PhraseOptions name_length_options(uint32_t max_repeat)
+  {
+    talon::PhraseOptions options;
+    options.size = [](const talon::RuleOp &reference) { return uint64_t(reference.name.size()); };
+    options.max_repeat = max_repeat;
+    return options;
+  }
+
+  std::string text(const std::vector<talon::PhraseToken> &phrase)
+  {
+    std::string result;
+    for (const talon::PhraseToken &token : phrase)
+    {
+      if (!result.empty())
+        result += ' ';
+      result += token.op->name;
+      if (token.op->kind == talon::RULE_LIST)
+        result += '#' + std::to_string(token.item);
+    }
+    return result;
+  }
+
+  void expect_phrases(const std::string &name, const talon::RuleIR &rule, const talon::PhraseOptions &options,
+                      const std::vector<std::string> &expected)
+  {
+    std::vector<std::string> phrases;
+    talon::PhraseGenerator generator(rule, options);
+    while (generator.next())
+      phrases.push_back(text(generator.phrase()));
+    test::expect(phrases == expected, name + ": wrong phrases");
+    test::expect(talon::count_phrases(rule, options) == expected.size(), name + ": wrong count");
+    // A second pass after reset() lists the same phrases.
+    generator.reset();
+    size_t count = 0;
+    while (generator.next())
+      count++;
+    test::expect(count == expected.size(), name + ": reset");
+  }
+
+  void collect_rules(TSNode node, std::vector<TSNode> &out)
+  {
+    const talon::Symbols &s = talon::symbols();
+    if (ts_node_symbol(node) == s.command_declaration)
+    {
+      out.push_back(ts_node_child_by_field_id(node, s.left));
+      return;
+    }
+    for (uint32_t i = 0; i < ts_node_named_child_count(node); i++)
+      collect_rules(ts_node_named_child(node, i), out);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  using namespace talon;
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+
+  // go {ab}
+  expect_phrases("sequence", {{op(RULE_WORD, "go"), op(RULE_LIST, "ab"), op(RULE_SEQ, "", 2)}},
+                 name_length_options(2), {"go ab#0", "go ab#1"});
+  // [a] b*
+  expect_phrases("optional and repeat",
+                 {{op(RULE_WORD, "a"), op(RULE_OPTIONAL), op(RULE_WORD, "b"), op(RULE_REPEAT), op(RULE_SEQ, "", 2)}},
+                 name_length_options(2), {"", "b", "b b", "a", "a b", "a b b"});
+  // (x | {empty})+ with an empty list.
+  expect_phrases("empty list in a choice",
+                 {{op(RULE_WORD, "x"), op(RULE_LIST), op(RULE_CHOICE, "", 2), op(RULE_REPEAT1)}},
+                 name_length_options(3), {"x", "x x", "x x x"});
+  // ^ {empty}* y $
+  expect_phrases("empty list in a repeat",
+                 {{op(RULE_START_ANCHOR), op(RULE_LIST), op(RULE_REPEAT), op(RULE_WORD, "y"), op(RULE_END_ANCHOR),
+                   op(RULE_SEQ, "", 4)}},
+                 name_length_options(2), {"y"});
+  // {empty} z
+  expect_phrases("empty list in a sequence", {{op(RULE_LIST), op(RULE_WORD, "z"), op(RULE_SEQ, "", 2)}},
+                 name_length_options(2), {});
+  // ({abc} {ab})* counts 1 + 6 + 6^2 + ... + 6^5 phrases.
+  RuleIR repeated = {{op(RULE_LIST, "abc"), op(RULE_LIST, "ab"), op(RULE_SEQ, "", 2), op(RULE_REPEAT)}};
+  test::expect(count_phrases(repeated, name_length_options(5)) == 9331, "count of a repeated sequence");
+  // Counts saturate rather than wrap.
+  test::expect(count_phrases(repeated, name_length_options(100)) == UINT64_MAX, "saturated count");
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  size_t rules = 0, phrases = 0;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, example.source.data(), example.source.size());
+    std::vector<TSNode> nodes;
+    collect_rules(ts_tree_root_node(tree), nodes);
+    for (TSNode node : nodes)
+    {
+      RuleIR rule;
+      if (!compile_rule(node, example.source, rule))
+        continue;
+      rules++;
+      for (uint64_t list_size : {0, 1, 3})
+      {
+        PhraseOptions options;
+        options.size = [&](const RuleOp &) { return list_size; };
+        uint64_t count = count_phrases(rule, options);
+        std::string where = example.file + ": " + example.name + " with lists of " + std::to_string(list_size);
+        if (count > 100000)
+          continue;
+        PhraseGenerator generator(rule, options);
+        size_t capacity = generator.phrase().capacity();
+        uint64_t generated = 0;
+        while (generator.next())
+        {
+          generated++;
+          test::expect(generator.phrase().capacity() == capacity, "phrase buffer grew at " + where);
+        }
+        std::string counts = std::to_string(generated) + " of " + std::to_string(count);
+        test::expect(generated == count, "generated " + counts + " phrases at " + where);
+        phrases += generated;
+      }
+    }
+    ts_tree_delete(tree);
+  }
+  ts_parser_delete(parser);
+  test::expect(rules > 20, "too few rules to test with");
+
+  std::printf("%zu rules, %zu phrases, %d failures\n", rules, phrases, test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,85 @@
+// Test for talon/pipeline.h.
+//
+// Writes the corpus tests to a temporary directory, one file each, indexes it
+// with the pipeline, with and without io_uring, and checks that the snapshot
+// is the same as that of the serial path.
+
+#include "talon/pipeline.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace
+{
+
+  // A summary of a snapshot that does not depend on how it was built.
+  std::vector<std::string> summarize(const talon::IndexSnapshot &snapshot)
+  {
+    std::vector<std::string> result;
+    for (const std::shared_ptr<const talon::FileIndex> &file : snapshot.files())
+    {
+      std::string line = file->path;
+      for (const talon::FileIndex::Reference &command : file->commands)
+        line += " " + command.name + "@" + std::to_string(command.start_byte);
+      for (const talon::FileIndex::Reference &action : file->actions)
+        line += " " + action.name + "@" + std::to_string(action.start_byte);
+      result.push_back(line);
+    }
+    return result;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() / ("tree-sitter-talon-pipeline-" + std::to_string(getpid()));
+  size_t count = 0;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    std::filesystem::path path = root / (count % 7 == 0 ? "nested" : "") / (std::to_string(count) + ".talon");
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary) << example.source;
+    count++;
+  }
+  std::ofstream(root / "ignored.py") << "pass\n";
+
+  talon::WorkspaceIndex serial_index;
+  talon::PipelineStats serial = talon::index_directory_serial(root.string(), serial_index);
+  std::vector<std::string> expected = summarize(*serial_index.read());
+  if (serial.files != count || expected.size() != count)
+    test::fail("serial path indexed %llu files of %zu", (unsigned long long)serial.files, count);
+
+  for (bool io_uring : {true, false})
+  {
+    for (size_t publish_every : {0, 5})
+    {
+      talon::PipelineOptions options;
+      options.use_io_uring = io_uring;
+      options.read_batch = 8;
+      options.queue_capacity = 16;
+      options.parse_threads = 3;
+      options.publish_every = publish_every;
+      talon::WorkspaceIndex index;
+      talon::PipelineStats stats = talon::index_directory(root.string(), index, options);
+      std::vector<std::string> actual = summarize(*index.read());
+      if (actual != expected)
+        test::fail("pipeline (io_uring %s, publish every %zu) differs from the serial path",
+                   stats.io_uring ? "on" : "off", publish_every);
+      if (stats.files != count || stats.bytes != serial.bytes || stats.failed != 0)
+        test::fail("pipeline counted %llu files and %llu bytes", (unsigned long long)stats.files,
+                   (unsigned long long)stats.bytes);
+      for (const talon::StageStats &stage : stats.stages)
+        if (stage.items != count || stats.utilization(stage) > 1)
+          test::fail("stage %s passed %llu files", stage.name.c_str(), (unsigned long long)stage.items);
+    }
+  }
+
+  std::filesystem::remove_all(root);
+  std::printf("%zu files indexed, %d failures\n", count, test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,90 @@
+// Test for talon/scheduler.h.
+//
+// Runs tasks of uneven cost, some of which push more tasks, all queued on one
+// thread, and checks that every task ran exactly once, that the other threads
+// stole work, and that the statistics add up.
+
+#include "talon/scheduler.h"
+#include "test/native/test.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+
+  void spin(uint64_t micros)
+  {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+  }
+
+}
+
+int main()
+{
+  const unsigned threads = 4;
+  const size_t parents = 64, children = 8;
+
+  for (int round = 0; round < 3; round++)
+  {
+    talon::Scheduler scheduler(threads);
+    std::vector<std::atomic<int>> runs(parents * (children + 1));
+    std::atomic<bool> wrong_thread(false);
+    for (size_t i = 0; i < parents; i++)
+    {
+      scheduler.push_back(0, [&, i](unsigned thread)
+      {
+        if (thread >= threads)
+          wrong_thread = true;
+        runs[i]++;
+        spin(i % 7 * 50);
+        for (size_t j = 0; j < children; j++)
+        {
+          size_t child = parents + i * children + j;
+          scheduler.push_front(thread, [&, child](unsigned)
+          {
+            runs[child]++;
+            spin(20);
+          });
+        }
+      });
+    }
+    talon::Scheduler::Stats stats = scheduler.run();
+
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+      if (runs[i] != 1)
+        test::fail("round %d: task %zu ran %d times", round, i, runs[i].load());
+    }
+    if (wrong_thread)
+      test::fail("round %d: task ran with a thread index out of range", round);
+    if (stats.tasks != runs.size())
+      test::fail("round %d: %llu tasks counted, %zu run", round, (unsigned long long)stats.tasks, runs.size());
+    if (stats.busy_ns.size() != threads)
+      test::fail("round %d: busy time for %zu threads", round, stats.busy_ns.size());
+    for (uint64_t busy : stats.busy_ns)
+    {
+      if (busy > stats.makespan_ns)
+        test::fail("round %d: a thread was busy for longer than the makespan", round);
+    }
+    // Everything was queued on thread 0, so the others only ran what they
+    // stole.
+    if (std::thread::hardware_concurrency() > 1 && stats.steals == 0)
+      test::fail("round %d: no tasks were stolen", round);
+    double utilization = stats.utilization();
+    if (utilization <= 0 || utilization > 1)
+      test::fail("round %d: utilization %.3f", round, utilization);
+  }
+
+  // A scheduler without tasks returns at once.
+  talon::Scheduler empty(threads);
+  if (empty.run().tasks != 0)
+    test::fail("empty scheduler ran tasks");
+
+  std::printf("%d failures\n", test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,127 @@
+// Test for talon/settings.h.
+//
+// Resolves the settings of a few files for every combination of active
+// contexts and checks that the file with the most `match` lines wins, with
+// ties broken by path. Then updates and removes files while a resolution is
+// cached, and checks that the settings those files defined are resolved
+// again, in place, while every other entry keeps its assignment.
+
+#include "talon/settings.h"
+#include "test/native/test.h"
+#include <cstdio>
+
+namespace
+{
+
+  // The value of `name` in `resolution`, or "-" if it is not set.
+  std::string value(const talon::SettingsResolver &resolver, const talon::SettingsResolver::Resolution &resolution,
+                    const char *name)
+  {
+    const talon::SettingsResolver::Assignment *assignment = resolution.get(resolver.setting_id(name));
+    return assignment ? assignment->value : "-";
+  }
+
+  void expect_value(const talon::SettingsResolver &resolver, const talon::SettingsResolver::Resolution &resolution,
+                    const char *name, const std::string &expected, const std::string &where)
+  {
+    std::string actual = value(resolver, resolution, name);
+    if (actual != expected)
+      test::fail("%s: %s is %s, expected %s", where.c_str(), name, actual.c_str(), expected.c_str());
+  }
+
+}
+
+int main()
+{
+  talon::SettingsResolver resolver;
+  // Added out of path order, so that ties are not broken by file id.
+  uint32_t z_app = resolver.update_file("z_app.talon", "app: editor\n-\nsettings():\n    a = 3\n    c = 3\n");
+  uint32_t app = resolver.update_file("app.talon", "app: editor\n-\nsettings():\n    a = 2\n");
+  uint32_t two = resolver.update_file("two.talon", "app: editor\nmode: command\n-\nsettings():\n    b = 4\n");
+  resolver.update_file("base.talon", "settings():\n    a = 1\n    b = 0\n    b = 1\n");
+  test::expect(resolver.setting_count() == 3, "setting count");
+  test::expect(resolver.file_id("app.talon") == app, "file id");
+  test::expect(resolver.file_id("none.talon") == talon::SettingsResolver::npos, "file id of a missing file");
+
+  // The expected a, b and c for every subset of {z_app, app, two}.
+  const char *expected[8][3] = {
+      {"1", "1", "-"}, // none
+      {"3", "1", "3"}, // z_app
+      {"2", "1", "-"}, // app
+      {"2", "1", "3"}, // z_app, app: a tie broken by path
+      {"1", "4", "-"}, // two
+      {"3", "4", "3"}, // z_app, two
+      {"2", "4", "-"}, // app, two
+      {"2", "4", "3"}, // all
+  };
+  const uint32_t ids[3] = {z_app, app, two};
+  for (uint32_t mask = 0; mask < 8; mask++)
+  {
+    talon::ContextSet active;
+    for (uint32_t i = 0; i < 3; i++)
+      active.set(ids[i], mask >> i & 1);
+    const talon::SettingsResolver::Resolution &resolution = resolver.resolve(active);
+    std::string where = "contexts " + std::to_string(mask);
+    expect_value(resolver, resolution, "a", expected[mask][0], where);
+    expect_value(resolver, resolution, "b", expected[mask][1], where);
+    expect_value(resolver, resolution, "c", expected[mask][2], where);
+  }
+  test::expect(resolver.cache_size() == 8, "one cached resolution per context set");
+
+  // Trailing zero words do not make another context set.
+  talon::ContextSet just_app, padded;
+  just_app.set(app);
+  padded.set(app);
+  padded.set(200);
+  padded.set(200, false);
+  test::expect(&resolver.resolve(padded) == &resolver.resolve(just_app) && resolver.cache_size() == 8,
+               "a set with trailing zero words was cached apart");
+
+  // Moving `a` out of app.talon affects `a` and the new `d` only.
+  talon::ContextSet both;
+  both.set(z_app);
+  both.set(app);
+  const talon::SettingsResolver::Resolution &cached = resolver.resolve(both);
+  const talon::SettingsResolver::Assignment *b = cached.get(resolver.setting_id("b"));
+  const talon::SettingsResolver::Assignment *c = cached.get(resolver.setting_id("c"));
+  resolver.update_file("app.talon", "app: editor\n-\nsettings():\n    d = 5\n");
+  test::expect(&resolver.resolve(both) == &cached && resolver.cache_size() == 8,
+               "resolution was not updated in place");
+  expect_value(resolver, cached, "a", "3", "after update");
+  expect_value(resolver, cached, "d", "5", "after update");
+  test::expect(cached.get(resolver.setting_id("b")) == b && cached.get(resolver.setting_id("c")) == c,
+               "update changed unaffected settings");
+
+  // Removing z_app.talon affects `a` and `c` only.
+  resolver.remove_file("z_app.talon");
+  expect_value(resolver, cached, "a", "1", "after removal");
+  expect_value(resolver, cached, "c", "-", "after removal");
+  expect_value(resolver, cached, "d", "5", "after removal");
+  test::expect(cached.get(resolver.setting_id("b")) == b, "removal changed an unaffected setting");
+
+  // The cached resolutions agree with resolving afresh.
+  std::vector<std::vector<std::string>> updated;
+  for (uint32_t mask = 0; mask < 8; mask++)
+  {
+    talon::ContextSet active;
+    for (uint32_t i = 0; i < 3; i++)
+      active.set(ids[i], mask >> i & 1);
+    updated.emplace_back();
+    for (const char *name : {"a", "b", "c", "d"})
+      updated.back().push_back(value(resolver, resolver.resolve(active), name));
+  }
+  resolver.clear_cache();
+  for (uint32_t mask = 0; mask < 8; mask++)
+  {
+    talon::ContextSet active;
+    for (uint32_t i = 0; i < 3; i++)
+      active.set(ids[i], mask >> i & 1);
+    std::vector<std::string> fresh;
+    for (const char *name : {"a", "b", "c", "d"})
+      fresh.push_back(value(resolver, resolver.resolve(active), name));
+    test::expect(fresh == updated[mask], "contexts " + std::to_string(mask) + ": cache differs from a fresh resolve");
+  }
+
+  std::printf("%zu settings, %d failures\n", resolver.setting_count(), test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,92 @@
+// Test for talon/store.h.
+//
+// Adds every corpus test as a file of one user, then again as the files of a
+// second user, and checks that the second user adds no value to the store
+// and gets the very values of the first. Then checks that commands with
+// different rules are stored apart, and that the store is empty once the
+// files are dropped and collected.
+
+#include "talon/language.h"
+#include "talon/store.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <cstdio>
+
+namespace
+{
+
+  uint64_t total_unique(const talon::DeclarationStore::Stats &stats)
+  {
+    return stats.rules.unique + stats.bodies.unique + stats.headers.unique + stats.commands.unique;
+  }
+
+  std::vector<talon::StoredFile> add_all(TSParser *parser, talon::DeclarationStore &store,
+                                         const std::vector<std::string> &sources)
+  {
+    std::vector<talon::StoredFile> files;
+    for (const std::string &source : sources)
+    {
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      files.push_back(store.add_file(ts_tree_root_node(tree), source));
+      ts_tree_delete(tree);
+    }
+    return files;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  std::vector<std::string> sources;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+    sources.push_back(example.source);
+
+  talon::DeclarationStore store;
+  std::vector<talon::StoredFile> first = add_all(parser, store, sources);
+  talon::DeclarationStore::Stats once = store.stats();
+  test::expect(once.commands.references > 20, "too few commands to test with");
+  test::expect(once.rules.unique > 0 && once.bodies.unique > 0, "nothing was stored");
+  test::expect(once.rules.unique <= once.rules.references, "more rules than references");
+
+  std::vector<talon::StoredFile> second = add_all(parser, store, sources);
+  talon::DeclarationStore::Stats twice = store.stats();
+  test::expect(total_unique(twice) == total_unique(once), "the second user added values");
+  test::expect(twice.commands.references == 2 * once.commands.references,
+               "the second user's commands were not counted");
+  test::expect(twice.failures == 2 * once.failures, "the second user compiled differently");
+  for (size_t i = 0; i < first.size(); i++)
+  {
+    std::string where = "file " + std::to_string(i);
+    test::expect(first[i].header == second[i].header, "headers differ at " + where);
+    test::expect(first[i].commands == second[i].commands, "commands differ at " + where);
+  }
+
+  // Commands that differ in their rule only.
+  {
+    std::string a = "hello world: key(a)\n", b = "hello there: key(a)\n";
+    std::vector<talon::StoredFile> files = add_all(parser, store, {a, b, a});
+    bool shaped = files[0].commands.size() == 1 && files[1].commands.size() == 1 && files[2].commands.size() == 1;
+    test::expect(shaped, "the one-command files do not have one command");
+    if (shaped)
+    {
+      test::expect(files[0].commands[0] != files[1].commands[0], "different rules share a command");
+      test::expect(files[0].commands[0]->body == files[1].commands[0]->body, "equal bodies are stored apart");
+      test::expect(files[0].commands[0] == files[2].commands[0], "equal commands are stored apart");
+    }
+  }
+
+  first.clear();
+  second.clear();
+  store.collect();
+  test::expect(total_unique(store.stats()) == 0, "values outlived their files");
+  ts_parser_delete(parser);
+
+  std::printf("%llu commands, %llu unique rules, %llu unique bodies, %d failures\n",
+              (unsigned long long)once.commands.references, (unsigned long long)once.rules.unique,
+              (unsigned long long)once.bodies.unique, test::failures.load());
+  return test::status();
+}
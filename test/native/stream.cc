@@ -0,0 +1,153 @@
+// Test for talon/stream.h.
+//
+// Streams every error-free corpus test with a range of chunk sizes, fed to the
+// stream a few bytes at a time, and checks that it reports the same header and
+// declarations, at the same positions, as a parse of the whole test, and that
+// it never buffers more than a chunk plus the longest declaration.
+
+#include "talon/language.h"
+#include "talon/split.h"
+#include "talon/stream.h"
+#include "test/native/corpus.h"
+#include "test/native/test.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+  struct Item
+  {
+    TSSymbol symbol;
+    uint64_t start_byte;
+    uint64_t rule_start;
+    uint64_t rule_end;
+    uint64_t body_start;
+
+    bool operator==(const Item &other) const
+    {
+      return symbol == other.symbol && start_byte == other.start_byte && rule_start == other.rule_start &&
+             rule_end == other.rule_end && body_start == other.body_start;
+    }
+  };
+
+  std::vector<Item> parse_whole(TSParser *parser, const std::string &source, bool &has_error)
+  {
+    const talon::Symbols &s = talon::symbols();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    has_error = ts_node_has_error(root);
+    std::vector<Item> items;
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode child = ts_node_named_child(root, i);
+      if (ts_node_symbol(child) == s.matches)
+        items.push_back({s.matches, ts_node_start_byte(child), 0, 0, 0});
+      if (ts_node_symbol(child) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+      {
+        TSNode declaration = ts_node_named_child(child, j);
+        if (ts_node_symbol(declaration) == s.comment)
+          continue;
+        TSNode rule = ts_node_child_by_field_id(declaration, s.left);
+        TSNode body = ts_node_child_by_field_id(declaration, s.right);
+        items.push_back({ts_node_symbol(declaration), ts_node_start_byte(declaration), ts_node_start_byte(rule),
+                         ts_node_end_byte(rule), ts_node_start_byte(body)});
+      }
+    }
+    ts_tree_delete(tree);
+    return items;
+  }
+
+  std::vector<Item> stream(talon::DeclarationStream &declarations, const std::string &source, size_t step)
+  {
+    std::vector<Item> items;
+    size_t position = 0;
+    auto read = [&](char *buffer, size_t capacity)
+    {
+      size_t count = std::min({capacity, step, source.size() - position});
+      std::memcpy(buffer, source.data() + position, count);
+      position += count;
+      return count;
+    };
+    auto report = [&](const talon::StreamEvent &event)
+    {
+      if (event.kind == talon::StreamEvent::HEADER)
+      {
+        items.push_back({ts_node_symbol(event.node), event.start_byte(), 0, 0, 0});
+        return;
+      }
+      items.push_back({ts_node_symbol(event.node), event.start_byte(), event.offset + ts_node_start_byte(event.rule),
+                       event.offset + ts_node_end_byte(event.rule), event.body_start});
+    };
+    declarations.run(read, report);
+    return items;
+  }
+
+  // The most bytes the stream must hold at once besides a chunk: the prefix
+  // that decides whether there is a header, the header, or a declaration with
+  // the comments and blank lines up to the next one.
+  size_t longest_piece(const std::string &source, const std::vector<Item> &items)
+  {
+    std::string_view text = source;
+    size_t undecided = 0;
+    while (undecided < text.size() && talon::find_header_end(text.substr(0, undecided), false) == 0)
+      undecided++;
+    size_t header_end = talon::find_header_end(source, true);
+    size_t start = header_end == std::string_view::npos ? 0 : header_end;
+    size_t longest = std::max(undecided, start);
+    for (const Item &item : items)
+    {
+      if (item.symbol == talon::symbols().matches || item.start_byte <= start)
+        continue;
+      longest = std::max(longest, size_t(item.start_byte - start));
+      start = item.start_byte;
+    }
+    return std::max(longest, source.size() - start);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::string corpus_path = argc > 1 ? argv[1] : "test/corpus";
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+
+  size_t checked = 0;
+  for (const test::Example &example : test::load_corpus(corpus_path))
+  {
+    bool has_error;
+    std::vector<Item> expected = parse_whole(parser, example.source, has_error);
+    // Error recovery depends on the surrounding text, so there is no single
+    // right answer for broken inputs.
+    if (has_error)
+      continue;
+    size_t longest = longest_piece(example.source, expected);
+    for (size_t chunk_size : {1, 7, 64, 4096})
+    {
+      talon::DeclarationStream declarations(chunk_size);
+      for (size_t step : {1, 5, 1 << 20})
+      {
+        std::vector<Item> actual = stream(declarations, example.source, step);
+        if (actual != expected)
+          test::fail("%s: %s (chunk size %zu, step %zu): %zu items, expected %zu",
+                     example.file.c_str(), example.name.c_str(), chunk_size, step, actual.size(),
+                     expected.size());
+        // The read that finds the end of a piece may overshoot it by a step.
+        size_t limit = chunk_size + longest + std::min(step, chunk_size);
+        if (declarations.peak_buffer_size() > limit)
+          test::fail("%s: %s (chunk size %zu, step %zu): buffered %zu bytes, more than %zu",
+                     example.file.c_str(), example.name.c_str(), chunk_size, step,
+                     declarations.peak_buffer_size(), limit);
+      }
+    }
+    checked++;
+  }
+  ts_parser_delete(parser);
+
+  std::printf("%zu corpus tests streamed, %d failures\n", checked, test::failures.load());
+  return test::status();
+}
@@ -0,0 +1,103 @@
+// Test for talon/template.h.
+//
+// Compiles strings with escapes, escaped braces and interpolations of every
+// value type, and checks that formatting each template gives what walking
+// its syntax nodes gives, as bench/template.cc does, and a few of them what
+// Python gives.
+
+#include "talon/template.h"
+#include "test/native/interpret.h"
+#include "test/native/test.h"
+#include <cstdio>
+#include <iterator>
+
+namespace
+{
+
+  using talon::Value;
+
+  struct Case
+  {
+    const char *string;
+    uint32_t slot_count;
+    // What Python gives, or null to only compare against the tree walker.
+    const char *expected;
+  };
+
+  const Case cases[] = {
+      {"\"\"", 0, ""},
+      {"\"hello world\"", 0, "hello world"},
+      {"\"{name}\"", 1, "world"},
+      {"\"{name}{name}\"", 2, "worldworld"},
+      {"\"Hello {name}!\\n\\tTotal: {count} items\"", 2, "Hello world!\n\tTotal: 42 items"},
+      {"\"{{not interpolated}} but {name} is\"", 1, "{not interpolated} but world is"},
+      {"\"}}{{\"", 0, "}{"},
+      {"\"caf\\u00e9 \\x41\\x42\\x43 \\101 {name}\\r\\n\"", 1, "caf\xc3\xa9 ABC A world\r\n"},
+      {"\"\\u20ac \\U0001f600 \\351 \\x7f\"", 0, "\xe2\x82\xac \xf0\x9f\x98\x80 \xc3\xa9 \x7f"},
+      {"\"\\a\\b\\f\\v\\'\\\"\\\\\"", 0, "\a\b\f\v'\"\\"},
+      {"\"\\x4a{count}\\x4b\"", 1, "J42K"},
+      {"\"{count}/{total} ({ratio}) \\\"done\\\"\"", 3, "42/100 (0.42) \"done\""},
+      {"\"path\\\\to\\\\{name}\\\\file.txt\"", 1, "path\\to\\world\\file.txt"},
+      {"\"{huge} {tiny} {whole} {none} {negative}\"", 5, "1e+16 1e-05 3.0 None -7"},
+      // Sequences the grammar accepts that do not decode, kept as written.
+      {"\"\\189 \\U00110000\"", 0, nullptr},
+  };
+
+}
+
+int main()
+{
+  std::string source;
+  for (const Case &c : cases)
+    source += std::string("test:\n    insert(") + c.string + ")\n";
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+  std::vector<TSNode> nodes = test::string_nodes(ts_tree_root_node(tree));
+  test::expect(nodes.size() == std::size(cases), "string count");
+
+  const test::Scope scope = {
+      {"name", Value::of_string("world")},
+      {"count", Value::of_int(42)},
+      {"total", Value::of_int(100)},
+      {"ratio", Value::of_float(0.42)},
+      {"huge", Value::of_float(1e16)},
+      {"tiny", Value::of_float(0.00001)},
+      {"whole", Value::of_float(3)},
+      {"none", Value()},
+      {"negative", Value::of_int(-7)},
+  };
+
+  talon::TemplateSet templates;
+  for (size_t i = 0; i < nodes.size() && i < std::size(cases); i++)
+  {
+    const Case &c = cases[i];
+    std::vector<TSNode> slots;
+    uint32_t id = templates.compile(nodes[i], source, slots);
+    if (id != i || slots.size() != c.slot_count || templates.slot_count(id) != c.slot_count)
+    {
+      test::fail("%s: id %u, %zu slots, expected %zu and %u", c.string, id, slots.size(), i, c.slot_count);
+      continue;
+    }
+    std::vector<Value> values = test::slot_values(slots, source, scope);
+    test::expect(values.size() == slots.size(), std::string(c.string) + ": unknown variable");
+
+    // Appending keeps what `out` held.
+    std::string formatted = "prefix", interpreted;
+    templates.format(id, values.data(), formatted);
+    test::interpret(nodes[i], source, scope, interpreted);
+    if (formatted != "prefix" + interpreted)
+      test::fail("%s: formatted \"%s\", the tree walker \"%s\"", c.string, formatted.c_str() + 6,
+                 interpreted.c_str());
+    if (c.expected && interpreted != c.expected)
+      test::fail("%s: formatted \"%s\", expected \"%s\"", c.string, interpreted.c_str(), c.expected);
+  }
+  test::expect(templates.size() == std::size(cases), "template count");
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+
+  std::printf("%zu templates, %d failures\n", templates.size(), test::failures.load());
+  return test::status();
+}
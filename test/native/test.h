@@ -0,0 +1,41 @@
+#ifndef TREE_SITTER_TALON_TEST_NATIVE_TEST_H_
+#define TREE_SITTER_TALON_TEST_NATIVE_TEST_H_
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+namespace test
+{
+
+  // The number of failed checks of the test program. Only the first 20 are
+  // printed. Checks may fail on any thread.
+  inline std::atomic<int> failures(0);
+
+  // Counts a failure, printed as "FAIL " and then `format` like printf.
+  __attribute__((format(printf, 1, 2))) inline void fail(const char *format, ...)
+  {
+    if (failures++ >= 20)
+      return;
+    std::va_list arguments;
+    va_start(arguments, format);
+    std::fputs("FAIL ", stderr);
+    std::vfprintf(stderr, format, arguments);
+    std::fputc('\n', stderr);
+    va_end(arguments);
+  }
+
+  inline bool expect(bool condition, const std::string &what)
+  {
+    if (!condition)
+      fail("%s", what.c_str());
+    return condition;
+  }
+
+  // The exit status of the test program.
+  inline int status() { return failures ? 1 : 0; }
+
+}
+
+#endif // TREE_SITTER_TALON_TEST_NATIVE_TEST_H_
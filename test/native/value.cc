@@ -0,0 +1,63 @@
+// Test for talon/value.h.
+//
+// Checks that append_value formats floats as Python's repr() does, around
+// the bounds of fixed notation at 1e-4 and 1e16, and formats the other types
+// as str() does.
+
+#include "talon/value.h"
+#include "test/native/test.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace
+{
+
+  void expect(const talon::Value &value, const std::string &expected)
+  {
+    std::string actual;
+    talon::append_value(actual, value);
+    if (actual != expected)
+      test::fail("got \"%s\", expected \"%s\"", actual.c_str(), expected.c_str());
+  }
+
+}
+
+int main()
+{
+  // Fixed notation keeps a decimal.
+  expect(talon::Value::of_float(0), "0.0");
+  expect(talon::Value::of_float(-0.0), "-0.0");
+  expect(talon::Value::of_float(1.5), "1.5");
+  expect(talon::Value::of_float(-2), "-2.0");
+  expect(talon::Value::of_float(100000), "100000.0");
+  expect(talon::Value::of_float(0.1), "0.1");
+  expect(talon::Value::of_float(1.0 / 3), "0.3333333333333333");
+  expect(talon::Value::of_float(12345678901234.5), "12345678901234.5");
+
+  // The lower bound of fixed notation.
+  expect(talon::Value::of_float(0.0001), "0.0001");
+  expect(talon::Value::of_float(-0.00012), "-0.00012");
+  expect(talon::Value::of_float(0.00009999), "9.999e-05");
+  expect(talon::Value::of_float(-2.5e-7), "-2.5e-07");
+
+  // The upper bound of fixed notation.
+  expect(talon::Value::of_float(1e15), "1000000000000000.0");
+  expect(talon::Value::of_float(9999999999999998.0), "9999999999999998.0");
+  expect(talon::Value::of_float(1e16), "1e+16");
+  expect(talon::Value::of_float(-1.5e16), "-1.5e+16");
+  expect(talon::Value::of_float(1e100), "1e+100");
+
+  expect(talon::Value::of_float(std::numeric_limits<double>::max()), "1.7976931348623157e+308");
+  expect(talon::Value::of_float(std::numeric_limits<double>::denorm_min()), "5e-324");
+  expect(talon::Value::of_float(INFINITY), "inf");
+  expect(talon::Value::of_float(-INFINITY), "-inf");
+  expect(talon::Value::of_float(NAN), "nan");
+
+  expect(talon::Value(), "None");
+  expect(talon::Value::of_int(-42), "-42");
+  expect(talon::Value::of_string("text"), "text");
+
+  std::printf("%d failures\n", test::failures.load());
+  return test::status();
+}
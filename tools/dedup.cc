@@ -0,0 +1,62 @@
+// Usage: build/native/tools/dedup <path..>
+//
+// Adds every .talon file below the given paths to one DeclarationStore, e.g.,
+// the user directories that script/parse-examples clones into examples/, and
+// reports how many rules, bodies, headers and commands were added, how many
+// of them are distinct, and how much memory sharing them saves.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "talon/store.h"
+#include "tools/files.h"
+
+namespace
+{
+
+  void report(const char *kind, const talon::DeclarationStore::KindStats &stats)
+  {
+    double saved = stats.referenced_bytes > 0 ? 100.0 * (1 - double(stats.stored_bytes) / stats.referenced_bytes) : 0;
+    std::printf("%-10s %10llu %10llu %12.3f %12.3f %8.1f%%\n", kind, (unsigned long long)stats.references,
+                (unsigned long long)stats.unique, stats.referenced_bytes / 1e6, stats.stored_bytes / 1e6, saved);
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+    tools::find_files(argv[i], paths);
+  if (paths.empty())
+  {
+    std::fprintf(stderr, "Usage: %s <path..>\n", argv[0]);
+    return 1;
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  talon::DeclarationStore store;
+  std::vector<talon::StoredFile> files;
+  uint64_t bytes = 0;
+  uint64_t start = bench::now_ns();
+  for (const std::string &path : paths)
+  {
+    std::string source = tools::read_file(path);
+    bytes += source.size();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    files.push_back(store.add_file(ts_tree_root_node(tree), source));
+    ts_tree_delete(tree);
+  }
+  double elapsed_s = (bench::now_ns() - start) / 1e9;
+  ts_parser_delete(parser);
+
+  talon::DeclarationStore::Stats stats = store.stats();
+  std::printf("Stored %zu files (%.1f MB) in %.3fs, %llu rules or bodies did not compile, %zu actions\n",
+              files.size(), bytes / 1e6, elapsed_s, (unsigned long long)stats.failures, store.actions().size());
+  std::printf("%-10s %10s %10s %12s %12s %9s\n", "kind", "references", "unique", "referenced", "stored", "saved");
+  report("rules", stats.rules);
+  report("bodies", stats.bodies);
+  report("headers", stats.headers);
+  report("commands", stats.commands);
+  return 0;
+}
@@ -0,0 +1,48 @@
+// Usage: build/native/tools/export <output> <path..>
+//
+// Parses every .talon file below the given paths, e.g., the user directories
+// that script/parse-examples clones into examples/, and writes their trees to
+// <output> in the columnar format of talon/columnar.h. Files are named by
+// their path as found.
+
+#include "bench/bench.h"
+#include "talon/columnar.h"
+#include "talon/language.h"
+#include "tools/files.h"
+#include <algorithm>
+
+int main(int argc, char **argv)
+{
+  std::vector<std::string> paths;
+  for (int i = 2; i < argc; i++)
+    tools::find_files(argv[i], paths);
+  if (paths.empty())
+  {
+    std::fprintf(stderr, "Usage: %s <output> <path..>\n", argv[0]);
+    return 1;
+  }
+  std::sort(paths.begin(), paths.end());
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  talon::ColumnarWriter writer;
+  uint64_t bytes = 0;
+  uint64_t start = bench::now_ns();
+  for (const std::string &path : paths)
+  {
+    std::string source = tools::read_file(path);
+    bytes += source.size();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    writer.add_file(path, ts_tree_root_node(tree), source);
+    ts_tree_delete(tree);
+  }
+  ts_parser_delete(parser);
+  if (!writer.write(argv[1]))
+  {
+    std::fprintf(stderr, "%s\n", writer.error().c_str());
+    return 1;
+  }
+  std::printf("Exported %zu files (%.1f MB), %zu nodes, to %s in %.3fs\n", paths.size(), bytes / 1e6,
+              writer.node_count(), argv[1], (bench::now_ns() - start) / 1e9);
+  return 0;
+}
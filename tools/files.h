@@ -0,0 +1,34 @@
+#ifndef TREE_SITTER_TALON_TOOLS_FILES_H_
+#define TREE_SITTER_TALON_TOOLS_FILES_H_
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace tools
+{
+
+  // Appends `path` if it is a file, or else every `.talon` file below it.
+  inline void find_files(const std::filesystem::path &path, std::vector<std::string> &out)
+  {
+    if (std::filesystem::is_regular_file(path))
+    {
+      out.push_back(path.generic_string());
+      return;
+    }
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(path))
+      if (entry.is_regular_file() && entry.path().extension() == ".talon")
+        out.push_back(entry.path().generic_string());
+  }
+
+  inline std::string read_file(const std::string &path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+}
+
+#endif // TREE_SITTER_TALON_TOOLS_FILES_H_
@@ -0,0 +1,348 @@
+// Usage: build/native/tools/generate <output_path> <declarations> [seed] [corpus_path]
+//
+// Writes a synthetic Talon user directory with the given number of
+// declarations, for scaling benchmarks that should not depend on the network.
+// The shape of the output is learned from the corpus: the number of matches in
+// headers and of declarations in files, the shapes of rules, the length of
+// command bodies, how often statements are strings, key(), sleep() or other
+// actions, and how often strings are interpolated. The same seed and corpus
+// always produce the same files.
+
+#include "bench/bench.h"
+#include "talon/language.h"
+#include "test/native/corpus.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+
+  enum StatementKind
+  {
+    KEY_STATEMENT,
+    SLEEP_STATEMENT,
+    ACTION_STATEMENT,
+    ASSIGNMENT_STATEMENT,
+    STRING_STATEMENT,
+    OTHER_STATEMENT,
+    STATEMENT_KIND_COUNT,
+  };
+
+  // A rule word in a rule shape.
+  const char WORD = '\x01';
+
+  // Empirical distributions: sampling an element uniformly reproduces the
+  // frequencies of the corpus.
+  struct Model
+  {
+    std::vector<uint32_t> header_sizes;
+    std::vector<std::string> matches;
+    std::vector<uint32_t> file_sizes;
+    uint64_t commands = 0;
+    std::vector<std::string> other_declarations;
+    std::vector<std::string> rule_shapes;
+    std::vector<std::string> rule_words;
+    std::vector<uint32_t> body_lengths;
+    std::vector<StatementKind> statement_kinds;
+    std::vector<std::string> statements[STATEMENT_KIND_COUNT];
+    std::vector<uint32_t> string_lengths;
+    std::vector<std::string> string_words;
+    std::vector<std::string> interpolations;
+  };
+
+  std::string_view trim(std::string_view text)
+  {
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return end == std::string_view::npos ? std::string_view() : text.substr(0, end + 1);
+  }
+
+  // Appends the text of `rule` with every word replaced by WORD.
+  void learn_rule(Model &model, std::string_view source, TSNode rule, std::string &shape)
+  {
+    const talon::Symbols &s = talon::symbols();
+    uint32_t position = ts_node_start_byte(rule);
+    TSTreeCursor cursor = ts_tree_cursor_new(rule);
+    for (;;)
+    {
+      TSNode node = ts_tree_cursor_current_node(&cursor);
+      if (ts_node_symbol(node) == s.word)
+      {
+        shape += source.substr(position, ts_node_start_byte(node) - position);
+        shape += WORD;
+        model.rule_words.emplace_back(talon::node_text(source, node));
+        position = ts_node_end_byte(node);
+      }
+      else if (ts_tree_cursor_goto_first_child(&cursor))
+      {
+        continue;
+      }
+      while (!ts_tree_cursor_goto_next_sibling(&cursor))
+      {
+        if (!ts_tree_cursor_goto_parent(&cursor))
+        {
+          ts_tree_cursor_delete(&cursor);
+          shape += source.substr(position, ts_node_end_byte(rule) - position);
+          return;
+        }
+      }
+    }
+  }
+
+  void learn_string(Model &model, std::string_view source, TSNode string)
+  {
+    const talon::Symbols &s = talon::symbols();
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < ts_node_named_child_count(string); i++)
+    {
+      TSNode child = ts_node_named_child(string, i);
+      TSSymbol symbol = ts_node_symbol(child);
+      if (symbol == s.interpolation)
+      {
+        model.interpolations.emplace_back(talon::node_text(source, child));
+        length++;
+      }
+      else if (symbol == s.string_content)
+      {
+        std::string_view text = talon::node_text(source, child);
+        size_t start = text.find_first_not_of(' ');
+        while (start != std::string_view::npos)
+        {
+          size_t end = std::min(text.find(' ', start), text.size());
+          model.string_words.emplace_back(text.substr(start, end - start));
+          length++;
+          start = text.find_first_not_of(' ', end);
+        }
+      }
+    }
+    model.string_lengths.push_back(length);
+  }
+
+  void learn_body(Model &model, std::string_view source, TSNode block)
+  {
+    const talon::Symbols &s = talon::symbols();
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < ts_node_named_child_count(block); i++)
+    {
+      TSNode statement = ts_node_named_child(block, i);
+      TSSymbol symbol = ts_node_symbol(statement);
+      StatementKind kind;
+      if (symbol == s.assignment_statement)
+      {
+        kind = ASSIGNMENT_STATEMENT;
+      }
+      else if (symbol == s.expression_statement)
+      {
+        TSNode expression = ts_node_child_by_field_id(statement, s.expression);
+        TSSymbol type = ts_node_symbol(expression);
+        kind = type == s.key_action     ? KEY_STATEMENT
+               : type == s.sleep_action ? SLEEP_STATEMENT
+               : type == s.action       ? ACTION_STATEMENT
+               : type == s.string       ? STRING_STATEMENT
+                                        : OTHER_STATEMENT;
+        if (kind == STRING_STATEMENT)
+          learn_string(model, source, expression);
+      }
+      else
+      {
+        continue;
+      }
+      model.statement_kinds.push_back(kind);
+      model.statements[kind].emplace_back(trim(talon::node_text(source, statement)));
+      length++;
+    }
+    model.body_lengths.push_back(length);
+  }
+
+  Model learn(const std::vector<test::Example> &examples)
+  {
+    const talon::Symbols &s = talon::symbols();
+    Model model;
+    TSParser *parser = ts_parser_new();
+    ts_parser_set_language(parser, tree_sitter_talon());
+    for (const test::Example &example : examples)
+    {
+      std::string_view source = example.source;
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      TSNode root = ts_tree_root_node(tree);
+      // Learning from recovered trees would teach the generator syntax errors.
+      if (ts_node_has_error(root))
+      {
+        ts_tree_delete(tree);
+        continue;
+      }
+
+      uint32_t header_size = 0, file_size = 0;
+      for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+      {
+        TSNode child = ts_node_named_child(root, i);
+        TSSymbol symbol = ts_node_symbol(child);
+        if (symbol == s.matches)
+        {
+          for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+          {
+            TSNode match = ts_node_named_child(child, j);
+            if (ts_node_symbol(match) != s.match)
+              continue;
+            model.matches.emplace_back(trim(talon::node_text(source, match)));
+            header_size++;
+          }
+        }
+        if (symbol != s.declarations)
+          continue;
+        for (uint32_t j = 0; j < ts_node_named_child_count(child); j++)
+        {
+          TSNode declaration = ts_node_named_child(child, j);
+          TSSymbol type = ts_node_symbol(declaration);
+          if (type == s.comment)
+            continue;
+          file_size++;
+          if (type != s.command_declaration)
+          {
+            model.other_declarations.emplace_back(trim(talon::node_text(source, declaration)));
+            continue;
+          }
+          model.commands++;
+          std::string shape;
+          learn_rule(model, source, ts_node_child_by_field_id(declaration, s.left), shape);
+          model.rule_shapes.push_back(shape);
+          learn_body(model, source, ts_node_child_by_field_id(declaration, s.right));
+        }
+      }
+      model.header_sizes.push_back(header_size);
+      if (file_size > 0)
+        model.file_sizes.push_back(file_size);
+      ts_tree_delete(tree);
+    }
+    ts_parser_delete(parser);
+    return model;
+  }
+
+  class Generator
+  {
+  public:
+    Generator(const Model &model, uint64_t seed) : model(model), random(seed) {}
+
+    // Appends a file with up to `declarations` declarations and returns how
+    // many it has.
+    uint32_t file(std::string &out, uint32_t declarations)
+    {
+      uint32_t header_size = pick(model.header_sizes);
+      for (uint32_t i = 0; i < header_size; i++)
+        out += pick(model.matches) + "\n";
+      if (header_size > 0)
+        out += "-\n";
+      uint32_t count = std::min(declarations, pick(model.file_sizes));
+      for (uint32_t i = 0; i < count; i++)
+        declaration(out);
+      return count;
+    }
+
+  private:
+    template <typename T>
+    const T &pick(const std::vector<T> &values)
+    {
+      return values[random.below(values.size())];
+    }
+
+    void declaration(std::string &out)
+    {
+      uint64_t total = model.commands + model.other_declarations.size();
+      if (random.next() % total >= model.commands)
+      {
+        out += pick(model.other_declarations) + "\n";
+        return;
+      }
+      for (char c : pick(model.rule_shapes))
+      {
+        if (c == WORD)
+          out += pick(model.rule_words);
+        else
+          out += c;
+      }
+      out += ":";
+      uint32_t length = std::max(1u, pick(model.body_lengths));
+      for (uint32_t i = 0; i < length; i++)
+      {
+        out += length == 1 ? " " : "\n    ";
+        statement(out);
+      }
+      out += "\n";
+    }
+
+    void statement(std::string &out)
+    {
+      StatementKind kind = pick(model.statement_kinds);
+      if (kind != STRING_STATEMENT)
+      {
+        out += pick(model.statements[kind]);
+        return;
+      }
+      // Interpolations are drawn in the proportion the corpus has them among
+      // the words of strings.
+      uint32_t length = std::max(1u, pick(model.string_lengths));
+      size_t pieces = model.string_words.size() + model.interpolations.size();
+      out += '"';
+      for (uint32_t i = 0; i < length; i++)
+      {
+        if (i > 0)
+          out += ' ';
+        if (random.next() % pieces < model.interpolations.size())
+          out += pick(model.interpolations);
+        else
+          out += pick(model.string_words);
+      }
+      out += '"';
+    }
+
+    const Model &model;
+    bench::Random random;
+  };
+
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "Usage: %s <output_path> <declarations> [seed] [corpus_path]\n", argv[0]);
+    return 1;
+  }
+  std::filesystem::path output_path = argv[1];
+  uint64_t declarations = std::strtoull(argv[2], NULL, 10);
+  uint64_t seed = argc > 3 ? std::strtoull(argv[3], NULL, 10) : 1;
+  std::string corpus_path = argc > 4 ? argv[4] : "test/corpus";
+
+  Model model = learn(test::load_corpus(corpus_path));
+  if (model.file_sizes.empty() || model.rule_shapes.empty() || model.statement_kinds.empty() ||
+      model.string_words.empty())
+  {
+    std::fprintf(stderr, "Not enough declarations in %s to learn from\n", corpus_path.c_str());
+    return 1;
+  }
+
+  // Files are spread over directories of 1000, as large user directories are.
+  Generator generator(model, seed);
+  uint64_t files = 0, bytes = 0;
+  std::string text;
+  for (uint64_t written = 0; written < declarations; files++)
+  {
+    text.clear();
+    written += generator.file(text, uint32_t(std::min<uint64_t>(declarations - written, UINT32_MAX)));
+    char name[32];
+    std::snprintf(name, sizeof(name), "%04llu/%06llu.talon", (unsigned long long)(files / 1000),
+                  (unsigned long long)files);
+    std::filesystem::path path = output_path / name;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary).write(text.data(), text.size());
+    bytes += text.size();
+  }
+
+  bench::Json json;
+  json.begin_object();
+  json.field("declarations", declarations);
+  json.field("files", files);
+  json.field("bytes", bytes);
+  json.field("seed", seed);
+  json.end_object();
+  return 0;
+}
@@ -0,0 +1,110 @@
+// Usage: build/native/tools/phrases [--list-size=N] [--max-repeat=N] [--limit=N] <path..>
+//
+// Prints every command of the .talon files below the given paths with the
+// number of phrases its rule stands for, as if every list and capture had
+// `list-size` items, and the first `limit` of those phrases. Items are shown
+// as `{list}#i` and `<capture>#i`. Phrases are listed one at a time, so a
+// rule with a great many of them costs no more memory than one with a few.
+
+#include "talon/language.h"
+#include "talon/phrases.h"
+#include "tools/files.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+  bool option(const char *arg, const char *name, const char *&value)
+  {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+      return false;
+    value = arg + length + 1;
+    return true;
+  }
+
+  void print_phrase(const std::vector<talon::PhraseToken> &phrase)
+  {
+    std::printf("   ");
+    for (const talon::PhraseToken &token : phrase)
+    {
+      if (token.op->kind == talon::RULE_LIST)
+        std::printf(" {%s}#%llu", token.op->name.c_str(), (unsigned long long)token.item);
+      else if (token.op->kind == talon::RULE_CAPTURE)
+        std::printf(" <%s>#%llu", token.op->name.c_str(), (unsigned long long)token.item);
+      else
+        std::printf(" %s", token.op->name.c_str());
+    }
+    std::printf("\n");
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  uint64_t list_size = 1;
+  uint64_t limit = 10;
+  talon::PhraseOptions options;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "--list-size", value))
+      list_size = std::strtoull(value, NULL, 10);
+    else if (option(argv[i], "--max-repeat", value))
+      options.max_repeat = std::strtoul(value, NULL, 10);
+    else if (option(argv[i], "--limit", value))
+      limit = std::strtoull(value, NULL, 10);
+    else
+      tools::find_files(argv[i], paths);
+  }
+  if (paths.empty())
+  {
+    std::fprintf(stderr, "Usage: %s [--list-size=N] [--max-repeat=N] [--limit=N] <path..>\n", argv[0]);
+    return 1;
+  }
+  options.size = [&](const talon::RuleOp &) { return list_size; };
+
+  const talon::Symbols &s = talon::symbols();
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_talon());
+  for (const std::string &path : paths)
+  {
+    std::string source = tools::read_file(path);
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+    TSNode root = ts_tree_root_node(tree);
+    for (uint32_t i = 0; i < ts_node_named_child_count(root); i++)
+    {
+      TSNode declarations = ts_node_named_child(root, i);
+      if (ts_node_symbol(declarations) != s.declarations)
+        continue;
+      for (uint32_t j = 0; j < ts_node_named_child_count(declarations); j++)
+      {
+        TSNode declaration = ts_node_named_child(declarations, j);
+        if (ts_node_symbol(declaration) != s.command_declaration)
+          continue;
+        TSNode rule_node = ts_node_child_by_field_id(declaration, s.left);
+        if (ts_node_is_null(rule_node))
+          continue;
+        talon::RuleIR rule;
+        std::printf("%s:%u: %.*s\n", path.c_str(), ts_node_start_point(declaration).row + 1,
+                    int(ts_node_end_byte(rule_node) - ts_node_start_byte(rule_node)),
+                    source.data() + ts_node_start_byte(rule_node));
+        if (!talon::compile_rule(rule_node, source, rule))
+        {
+          std::printf("    does not compile\n");
+          continue;
+        }
+        uint64_t count = talon::count_phrases(rule, options);
+        std::printf("    %s%llu phrases\n", count == UINT64_MAX ? "at least " : "", (unsigned long long)count);
+        talon::PhraseGenerator generator(rule, options);
+        for (uint64_t k = 0; k < limit && generator.next(); k++)
+          print_phrase(generator.phrase());
+      }
+    }
+    ts_tree_delete(tree);
+  }
+  ts_parser_delete(parser);
+  return 0;
+}
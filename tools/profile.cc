@@ -0,0 +1,159 @@
+// Usage: build/native/tools/profile [--threads=N] [--repetitions=N] [--slowest=N] [--csv=path] <path..>
+//
+// Parses every .talon file below the given paths in-process, spread over a
+// pool of threads with one parser each, and times each file separately, so
+// that neither process startup nor the other files hide a slow input. Writes
+// one CSV row per file with its size, parse time, node count and error count,
+// and prints the files with the lowest throughput.
+
+#include "bench/bench.h"
+#include "bench/tree.h"
+#include "talon/language.h"
+#include "tools/files.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+  struct FileResult
+  {
+    std::string path;
+    uint64_t bytes = 0;
+    double parse_us = 0;
+    uint64_t nodes = 0;
+    uint64_t errors = 0;
+
+    double mb_per_s() const { return parse_us > 0 ? bytes / parse_us : 0; }
+  };
+
+  // Parses the file `result.path` and records the fastest of `repetitions`
+  // parse times.
+  void profile(TSParser *parser, FileResult &result, int repetitions)
+  {
+    std::string source = tools::read_file(result.path);
+    result.bytes = source.size();
+    result.parse_us = INFINITY;
+    for (int r = 0; r < repetitions; r++)
+    {
+      uint64_t start = bench::now_ns();
+      TSTree *tree = ts_parser_parse_string(parser, NULL, source.data(), source.size());
+      result.parse_us = std::min(result.parse_us, (bench::now_ns() - start) / 1e3);
+      if (r == 0)
+      {
+        bench::TreeStats stats = bench::tree_stats(ts_tree_root_node(tree));
+        result.nodes = stats.nodes;
+        result.errors = stats.errors;
+      }
+      ts_tree_delete(tree);
+    }
+  }
+
+  bool option(const char *arg, const char *name, const char *&value)
+  {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+      return false;
+    value = arg + length + 1;
+    return true;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  int repetitions = 3;
+  size_t slowest = 10;
+  std::string csv_path = "build/native/profile.csv";
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "--threads", value))
+      threads = std::max(1, std::atoi(value));
+    else if (option(argv[i], "--repetitions", value))
+      repetitions = std::max(1, std::atoi(value));
+    else if (option(argv[i], "--slowest", value))
+      slowest = std::strtoul(value, NULL, 10);
+    else if (option(argv[i], "--csv", value))
+      csv_path = value;
+    else
+      tools::find_files(argv[i], paths);
+  }
+  if (paths.empty())
+  {
+    std::fprintf(stderr, "Usage: %s [--threads=N] [--repetitions=N] [--slowest=N] [--csv=path] <path..>\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<FileResult> results(paths.size());
+  for (size_t i = 0; i < paths.size(); i++)
+    results[i].path = paths[i];
+
+  // Files are handed out one at a time, so that a large file does not leave
+  // the other threads idle behind a fixed partition.
+  std::atomic<size_t> next(0);
+  uint64_t start = bench::now_ns();
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++)
+  {
+    pool.emplace_back([&]()
+    {
+      TSParser *parser = ts_parser_new();
+      ts_parser_set_language(parser, tree_sitter_talon());
+      for (size_t i; (i = next.fetch_add(1)) < results.size();)
+        profile(parser, results[i], repetitions);
+      ts_parser_delete(parser);
+    });
+  }
+  for (std::thread &thread : pool)
+    thread.join();
+  double wall_s = (bench::now_ns() - start) / 1e9;
+
+  FILE *csv = std::fopen(csv_path.c_str(), "w");
+  if (!csv)
+  {
+    std::fprintf(stderr, "Cannot write %s\n", csv_path.c_str());
+    return 1;
+  }
+  std::fprintf(csv, "path,bytes,parse_us,nodes,errors,mb_per_s\n");
+  uint64_t bytes = 0, errors = 0;
+  std::vector<double> throughputs;
+  for (const FileResult &result : results)
+  {
+    std::fprintf(csv, "\"%s\",%llu,%.3f,%llu,%llu,%.3f\n", result.path.c_str(), (unsigned long long)result.bytes,
+                 result.parse_us, (unsigned long long)result.nodes, (unsigned long long)result.errors,
+                 result.mb_per_s());
+    bytes += result.bytes;
+    errors += result.errors > 0;
+    if (result.bytes > 0)
+      throughputs.push_back(result.mb_per_s());
+  }
+  std::fclose(csv);
+
+  double median = bench::percentile(throughputs, 50);
+  std::printf("Parsed %zu files (%.1f MB) on %u threads in %.3fs, %llu with errors, median %.1f MB/s per file\n",
+              results.size(), bytes / 1e6, threads, wall_s, (unsigned long long)errors, median);
+
+  // Empty files have no meaningful throughput.
+  std::vector<const FileResult *> ranked;
+  for (const FileResult &result : results)
+    if (result.bytes > 0)
+      ranked.push_back(&result);
+  slowest = std::min(slowest, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + slowest, ranked.end(),
+                    [](const FileResult *a, const FileResult *b) { return a->mb_per_s() < b->mb_per_s(); });
+  if (slowest > 0)
+    std::printf("Slowest files:\n");
+  for (size_t i = 0; i < slowest; i++)
+  {
+    const FileResult &result = *ranked[i];
+    std::printf("  %8.2f MB/s  %5.2fx median  %8llu bytes  %s\n", result.mb_per_s(),
+                median > 0 ? result.mb_per_s() / median : 0, (unsigned long long)result.bytes, result.path.c_str());
+  }
+  std::printf("Wrote %s\n", csv_path.c_str());
+  return 0;
+}